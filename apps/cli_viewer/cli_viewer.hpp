@@ -1,54 +1,253 @@
+#pragma once
+
+#include "buffered_writer.h"
 #include "note.hpp"
 #include "options.h"
+#include "query.hpp"
+#include "repl.hpp"
+
+#include <algorithm>    // for std::find
+#include <iostream>     // for std::cin, std::istream
+#include <unistd.h>     // for STDOUT_FILENO
 
 using namespace note;
 
+/**
+ * Interactive viewer: a line based REPL over the open ('visible') notes.
+ * Every command redraws into one buffer that is written with a single flush.
+ */
 class CliViewer {
 private:
     Options opts_;
     NoteStore noteStore;
-    std::vector<NoteData> visible;
+    std::vector<NoteId> visible;
+    size_t current{0};              // index into 'visible'
+    std::vector<NoteId> listed;     // the last numbered list, for 'open <n>'
     std::string input;
-public:
-    CliViewer(Options opts) : opts_(std::move(opts)),
-                              noteStore(NoteStore(opts_.storage_path)) {
-        NoteData default_note = noteStore.getNote("default");
-        for (const auto& kid : default_note.kids) {
-            visible.emplace_back(noteStore.getNote(kid));
+    std::string message;            // shown under the next redraw
+    TitleIndex titles;
+    std::istream& in;               // commands, and keys while paging
+    BufferedWriter out;
+
+    static constexpr size_t previewLines = 8;
+
+    void writeTitles(const TitleRange& titles) {
+        std::string_view separator;
+        for (std::string_view title : titles) {
+            out.write(separator);
+            out.write(title);
+            separator = ", ";
         }
     }
 
-    int run() {
-        while (input != "q") {
-            input.clear();
-            for (const auto& note : visible) {
-                std::cout << "=======\n";
-                std::cout << "Title: " << note.title << "\n";
-                std::cout << "  tags: ";
-                std::string separator;
-                if (note.tags.size() > 0) {
-                    for (const auto& tag : note.tags) {
-                        std::cout << separator << tag;
-                        separator = ", ";
-                    }
-                }
-                std::cout << "\n";
-                std::cout << "  ----\n";
-                std::cout << "  " << note.content << "\n";
-                std::cout << "  ----\n";
-                if (note.kids.size() > 0) {
-                    std::cout << "  children: ";
-                    separator.clear();
-                    for (const auto& child : note.kids) {
-                        std::cout << separator << child;
-                        separator = ", ";
-                    }
-                }
-                std::cout << std::endl;
+    // numbered list, shown below the next redraw
+    void listNotes(std::string_view heading, const std::vector<NoteId>& ids) {
+        listed = ids;
+        StringWriter list(message);
+        list.write(heading);
+        list.put('\n');
+        for (size_t i = 0; i < ids.size(); ++i) {
+            list.write("  ");
+            list.number(i + 1);
+            list.write(". ");
+            list.write(noteStore.getNote(ids[i]).title);
+            list.put('\n');
+        }
+    }
+
+    // the current note with the first lines of its content
+    void redraw() {
+        out.write("\033[H\033[2J"); // home, clear screen
+        if (visible.empty()) {
+            out.write("no open notes, try 'open <title>' or 'help'\n");
+        } else {
+            const NoteDataView note = noteStore.getNoteView(visible[current]);
+            out.write("=======  [");
+            out.number(current + 1);
+            out.put('/');
+            out.number(visible.size());
+            out.write("]  ");
+            out.write(note.title);
+            out.write("\n  tags: ");
+            writeTitles(note.tags);
+            out.write("\n  kids: ");
+            writeTitles(note.kids);
+            out.write("\n  ----\n");
+            std::string_view content = note.content;
+            size_t lines = 0;
+            while (!content.empty() && lines < previewLines) {
+                size_t end = content.find('\n');
+                out.write("  ");
+                out.write(content.substr(0, end));
+                out.put('\n');
+                content = end == std::string_view::npos ? std::string_view{} : content.substr(end + 1);
+                ++lines;
             }
+            if (!content.empty()) out.write("  ... ('show' for all)\n");
+            out.write("  ----\n");
+        }
+        out.write(message);
+        message.clear();
+        out.write("> ");
+        out.flush();
+    }
+
+    /**
+     * Resolves a title (or its unique prefix) or a number from the last list.
+     */
+    NoteId resolve(std::string_view arg) {
+        if (arg.empty()) return visible.empty() ? 0 : visible[current];
+        size_t number = 0;
+        if (std::all_of(arg.begin(), arg.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            for (char c : arg) number = number * 10 + static_cast<size_t>(c - '0');
+            if (number >= 1 && number <= listed.size()) return listed[number - 1];
+        }
+        std::vector<std::string_view> candidates;
+        NoteId id = titles.complete(noteStore, arg, candidates);
+        if (id == 0) {
+            message = candidates.empty() ? "no note starts with '" + std::string(arg) + "'\n" : "did you mean:\n";
+            for (auto title : candidates) message.append("  ").append(title).append("\n");
+        }
+        return id;
+    }
+
+    void open(NoteId id) {
+        auto it = std::find(visible.begin(), visible.end(), id);
+        if (it == visible.end()) it = visible.insert(visible.begin() + (visible.empty() ? 0 : current + 1), id);
+        current = static_cast<size_t>(it - visible.begin());
+    }
+
+    void close(NoteId id) {
+        auto it = std::find(visible.begin(), visible.end(), id);
+        if (it == visible.end()) return;
+        visible.erase(it);
+        if (current >= visible.size() && current > 0) --current;
+    }
 
-            std::cin >> input;
+    void page(NoteId id) {
+        Pager pager(noteStore.getNote(id).content, terminalSize());
+        std::string key;
+        while (true) {
+            pager.render(out);
+            out.flush();
+            if (!std::getline(in, key) || key == "q") return;
+            if (key == "p") pager.previous();
+            else if (pager.atEnd()) return;
+            else pager.next();
         }
+    }
+
+    void help() {
+        message =
+            "  open <title|n>   open a note (unique title prefixes complete, n: from the last list)\n"
+            "  close [title]    close a note, the current one by default\n"
+            "  next / prev      switch between open notes\n"
+            "  ls               list open notes\n"
+            "  tags / kids      list the tags / kids of the current note\n"
+            "  show [title]     page through the whole content\n"
+            "  stats            memory held by the store\n"
+            "  q                quit\n";
+    }
+
+    // returns false to quit
+    bool execute(std::string_view line) {
+        size_t space = line.find(' ');
+        std::string_view command = line.substr(0, space);
+        std::string_view arg = space == std::string_view::npos ? std::string_view{} : line.substr(space + 1);
+        while (!arg.empty() && arg.front() == ' ') arg.remove_prefix(1);
+
+        if (command == "q" || command == "quit") return false;
+        if (command.empty()) return true;
+        if (command == "help" || command == "?") help();
+        else if (command == "open" || command == "o") {
+            if (NoteId id = resolve(arg)) open(id);
+        } else if (command == "close" || command == "c") {
+            if (NoteId id = resolve(arg)) close(id);
+        } else if (command == "next" || command == "n") {
+            if (!visible.empty()) current = (current + 1) % visible.size();
+        } else if (command == "prev" || command == "p") {
+            if (!visible.empty()) current = (current + visible.size() - 1) % visible.size();
+        } else if (command == "ls") {
+            listNotes("open notes:", visible);
+        } else if ((command == "tags" || command == "kids") && !visible.empty()) {
+            const NoteData& note = noteStore.getNote(visible[current]);
+            listNotes(command == "tags" ? "tags:" : "kids:", command == "tags" ? note.tags : note.kids);
+        } else if (command == "show" || command == "s") {
+            if (NoteId id = resolve(arg)) page(id);
+        } else if (command == "stats") {
+            StringWriter stats(message);
+            writeStats(stats, QueryFormat::Tsv);
+        } else {
+            message = "unknown command '" + std::string(command) + "', try 'help'\n";
+        }
+        return true;
+    }
+
+    /**
+     * The store's memory as one JSON object, or as name and value lines.
+     */
+    template<typename Writer>
+    void writeStats(Writer& w, QueryFormat format) {
+        static constexpr std::pair<const char*, size_t MemoryStats::*> fields[] = {
+            {"notes", &MemoryStats::notes}, {"placeholders", &MemoryStats::placeholders},
+            {"edges", &MemoryStats::edges}, {"title_bytes", &MemoryStats::titleBytes},
+            {"content_bytes", &MemoryStats::contentBytes}, {"index_bytes", &MemoryStats::indexBytes},
+            {"list_bytes", &MemoryStats::listBytes}, {"table_bytes", &MemoryStats::tableBytes},
+            {"slack_bytes", &MemoryStats::slackBytes},
+        };
+        const MemoryStats stats = noteStore.memoryStats();
+        auto field = [&](std::string_view name, size_t value, bool first) {
+            if (format == QueryFormat::JsonLines) {
+                w.write(first ? "{\"" : ",\"");
+                w.write(name);
+                w.write("\":");
+            } else {
+                w.write(name);
+                w.put('\t');
+            }
+            w.number(value);
+            if (format == QueryFormat::Tsv) w.put('\n');
+        };
+        for (const auto& [name, member] : fields) field(name, stats.*member, member == fields[0].second);
+        field("total_bytes", stats.totalBytes(), false);
+        if (format == QueryFormat::JsonLines) w.write("}\n");
+    }
+
+    int runStats() {
+        writeStats(out, opts_.format == "tsv" ? QueryFormat::Tsv : QueryFormat::JsonLines);
+        out.flush();
+        return out.ok() ? 0 : 1;
+    }
+
+    int runQuery() {
+        QueryField field = opts_.query_by == "tag"     ? QueryField::Tag
+                         : opts_.query_by == "content" ? QueryField::Content
+                                                       : QueryField::Title;
+        QueryFormat format = opts_.format == "tsv" ? QueryFormat::Tsv : QueryFormat::JsonLines;
+        size_t matches = NoteQuery(noteStore, format, out).run(*opts_.query, field);
+        out.flush();
+        LOG_INFO() << "query '" << *opts_.query << "' by " << opts_.query_by << ": " << matches << " matches";
+        return out.ok() ? 0 : 1;
+    }
+public:
+    /**
+     * Reads commands from 'in' and draws to the file descriptor 'out_fd'.
+     */
+    CliViewer(Options opts, std::istream& in = std::cin, int out_fd = STDOUT_FILENO) :
+        opts_(std::move(opts)), noteStore(NoteStore(opts_.storage_path)), in(in), out(out_fd) {
+        if (opts_.query || opts_.stats) return;
+        visible = noteStore.getNote("default").kids;
+    }
+
+    int run() {
+        if (opts_.query) return runQuery();
+        if (opts_.stats) return runStats();
+
+        do {
+            redraw();
+            if (!std::getline(in, input)) break;
+        } while (execute(input));
+        out.write("\n");
         return 0;
     }
-};
\ No newline at end of file
+};
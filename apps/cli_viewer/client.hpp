@@ -0,0 +1,142 @@
+#pragma once
+
+#include "buffered_writer.h"
+#include "options.h"
+#include "protocol.hpp"
+#include "query.hpp"
+
+#include <cerrno>
+#include <cstring>      // for std::strerror
+#include <iostream>     // for std::cin
+#include <iterator>     // for std::istreambuf_iterator
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Blocking client for the notewiki daemon, one request/response round trip per call.
+ */
+class DaemonClient {
+public:
+    ~DaemonClient() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool connect(const std::string& path) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) return false;
+        path.copy(addr.sun_path, path.size());
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        return fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+
+    /**
+     * Sends one request and waits for its response, joined from its 'More' frames.
+     * Returns false if the connection failed or the request is over 'maxPayload'.
+     */
+    bool request(protocol::Op op, std::string_view body, protocol::Status& status, std::string& reply) {
+        std::string frame;
+        if (!protocol::appendFrame(frame, static_cast<uint8_t>(op), body)) return false;
+        if (!sendAll(frame)) return false;
+
+        buffer.clear();
+        reply.clear();
+        size_t offset = 0;
+        char chunk[64 * 1024];
+        while (true) {
+            uint8_t kind;
+            std::string_view payload;
+            size_t consumed;
+            auto result = protocol::nextFrame(std::string_view(buffer).substr(offset), kind, payload, consumed);
+            if (result == protocol::FrameResult::Invalid) return false;
+            if (result == protocol::FrameResult::Complete) {
+                reply.append(payload);
+                offset += consumed;
+                if (kind == static_cast<uint8_t>(protocol::Status::More)) continue;
+                status = static_cast<protocol::Status>(kind);
+                return true;
+            }
+            // only the unread part of the buffer is kept
+            buffer.erase(0, offset);
+            offset = 0;
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+    }
+
+private:
+    int fd{-1};
+    std::string buffer;
+
+    bool sendAll(std::string_view data) {
+        while (!data.empty()) {
+            ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+        return true;
+    }
+};
+
+/**
+ * notewiki_cli as a thin client: turns --get, --update or --query into one
+ * request to the daemon on --socket and prints the reply.
+ */
+inline int runClient(const Options& opts) {
+    std::string body;
+    protocol::Op op;
+    if (opts.get) {
+        op = protocol::Op::Get;
+        body = *opts.get;
+    } else if (opts.update) {
+        // the new content is read from stdin
+        op = protocol::Op::Update;
+        body = *opts.update;
+        body.push_back('\0');
+        body.append(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else if (opts.query) {
+        op = protocol::Op::Search;
+        QueryField field = opts.query_by == "tag"     ? QueryField::Tag
+                         : opts.query_by == "content" ? QueryField::Content
+                                                      : QueryField::Title;
+        QueryFormat format = opts.format == "tsv" ? QueryFormat::Tsv : QueryFormat::JsonLines;
+        body.push_back(static_cast<char>(field));
+        body.push_back(static_cast<char>(format));
+        body.append(*opts.query);
+    } else {
+        std::cerr << "--socket needs one of --get, --update or --query\n";
+        return 1;
+    }
+
+    if (body.size() >= protocol::maxPayload) {
+        std::cerr << "request too large, the limit is " << (protocol::maxPayload >> 20) << " MiB\n";
+        return 1;
+    }
+    DaemonClient client;
+    if (!client.connect(opts.socket_path)) {
+        std::cerr << "could not connect to " << opts.socket_path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    protocol::Status status;
+    std::string reply;
+    if (!client.request(op, body, status, reply)) {
+        std::cerr << "connection to the daemon failed\n";
+        return 1;
+    }
+    if (status != protocol::Status::Ok) {
+        std::cerr << (status == protocol::Status::NotFound ? "not found\n" : "bad request\n");
+        return 1;
+    }
+    BufferedWriter out;
+    out.write(reply);
+    out.flush();
+    return out.ok() ? 0 : 1;
+}
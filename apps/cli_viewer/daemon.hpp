@@ -0,0 +1,336 @@
+#pragma once
+
+#include "note.hpp"
+#include "options.h"
+#include "protocol.hpp"
+#include "query.hpp"
+
+#include <algorithm>        // for std::max
+#include <cerrno>
+#include <chrono>
+#include <csignal>          // for sigaction, SIGINT, SIGTERM
+#include <cstring>          // for std::strerror
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace note;
+
+/**
+ * Keeps the NoteStore resident and answers get, search and update requests
+ * from notewiki_cli clients on a Unix-domain socket, see protocol.hpp.
+ * * One thread, one epoll loop: non-blocking clients, buffered replies that
+ *   are flushed when the socket becomes writable again.
+ * * SIGINT/SIGTERM are forwarded into the loop through a pipe (any thread, ex:
+ *   the logger's, may receive them).
+ * * An update is saved 'saveDelay' after it, together with the updates that
+ *   followed, and on the way out: a killed daemon loses at most 'saveDelay'.
+ *
+ * example:
+ *      notewiki_cli -f notes.json --daemon --socket /tmp/notewiki.sock &
+ *      notewiki_cli --socket /tmp/notewiki.sock --query rust --by tag
+ */
+class NoteDaemon {
+public:
+    static constexpr std::chrono::milliseconds defaultSaveDelay{1000};
+
+    NoteDaemon(Options opts, std::chrono::milliseconds saveDelay = defaultSaveDelay) :
+        opts_(std::move(opts)), store(NoteStore(opts_.storage_path)), saveDelay(saveDelay) {}
+
+    ~NoteDaemon() {
+        for (auto& [fd, conn] : connections) ::close(fd);
+        if (signalFd >= 0) {
+            ::close(signalFd);
+            ::close(signalPipe[1]);
+            signalPipe[1] = -1;
+        }
+        if (epollFd >= 0) ::close(epollFd);
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            ::unlink(opts_.socket_path.c_str());
+        }
+    }
+
+    NoteDaemon(const NoteDaemon&) = delete;
+    NoteDaemon& operator=(const NoteDaemon&) = delete;
+
+    int run() {
+        if (!listen() || !setupEpoll()) return 1;
+        LOG_INFO() << "daemon serving" << logField("store", opts_.storage_path) << logField("socket", opts_.socket_path);
+
+        epoll_event ready[64];
+        bool running = true;
+        while (running) {
+            int n = ::epoll_wait(epollFd, ready, 64, saveTimeout());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                LOG_ERROR() << "epoll_wait failed: " << std::strerror(errno);
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                int fd = ready[i].data.fd;
+                if (fd == listenFd) acceptClients();
+                else if (fd == signalFd) running = false;   // SIGINT/SIGTERM
+                else handleClient(fd, ready[i].events);
+            }
+            if (dirty && Clock::now() >= saveDue) save();
+        }
+
+        if (dirty) save();
+        LOG_INFO() << "daemon stopped";
+        return 0;
+    }
+
+    /**
+     * Ends 'run' like SIGINT/SIGTERM, safe from any thread once 'run' is serving.
+     */
+    static void stop() { onSignal(0); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        std::string in;
+        std::string out;
+        size_t written{0};  // bytes of 'out' already sent
+        bool closing{false};// the client hung up, close once 'out' is sent
+    };
+
+    Options opts_;
+    NoteStore store;
+    int listenFd{-1};
+    int epollFd{-1};
+    int signalFd{-1};   // read end of 'signalPipe'
+    inline static int signalPipe[2]{-1, -1};
+    bool dirty{false};              // updated since the last save
+    std::chrono::milliseconds saveDelay;
+    Clock::time_point saveDue;      // when a 'dirty' store is saved
+    std::unordered_map<int, Connection> connections;
+
+    void save() {
+        store.save_json_file(opts_.storage_path);
+        dirty = false;
+    }
+
+    // epoll_wait's timeout: until the pending save, forever without one
+    int saveTimeout() const {
+        if (!dirty) return -1;
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(saveDue - Clock::now());
+        return static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+    }
+
+    bool listen() {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (opts_.socket_path.size() >= sizeof(addr.sun_path)) {
+            LOG_ERROR() << "socket path too long: " << opts_.socket_path;
+            return false;
+        }
+        opts_.socket_path.copy(addr.sun_path, opts_.socket_path.size());
+
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            LOG_ERROR() << "socket failed: " << std::strerror(errno);
+            return false;
+        }
+        // a socket file nobody accepts on is left over from a daemon that died
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool in_use = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        ::close(probe);
+        if (in_use) {
+            LOG_ERROR() << "another daemon is serving " << opts_.socket_path;
+            ::close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        ::unlink(opts_.socket_path.c_str());
+
+        if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listenFd, SOMAXCONN) != 0) {
+            LOG_ERROR() << "could not listen on " << opts_.socket_path << ": " << std::strerror(errno);
+            ::close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    static void onSignal(int) {
+        int saved = errno;
+        char byte = 0;
+        if (signalPipe[1] >= 0) {
+            ssize_t ignored = ::write(signalPipe[1], &byte, 1);
+            (void)ignored;
+        }
+        errno = saved;
+    }
+
+    bool setupEpoll() {
+        if (::pipe2(signalPipe, O_NONBLOCK | O_CLOEXEC) == 0) {
+            signalFd = signalPipe[0];
+            struct sigaction action{};
+            action.sa_handler = &NoteDaemon::onSignal;
+            sigemptyset(&action.sa_mask);
+            ::sigaction(SIGINT, &action, nullptr);
+            ::sigaction(SIGTERM, &action, nullptr);
+        }
+
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0 || signalFd < 0) {
+            LOG_ERROR() << "epoll setup failed: " << std::strerror(errno);
+            return false;
+        }
+        return watch(listenFd, EPOLLIN, EPOLL_CTL_ADD) && watch(signalFd, EPOLLIN, EPOLL_CTL_ADD);
+    }
+
+    bool watch(int fd, uint32_t events, int op) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        return ::epoll_ctl(epollFd, op, fd, &ev) == 0;
+    }
+
+    void acceptClients() {
+        while (true) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                    LOG_WARNING() << "accept failed: " << std::strerror(errno);
+                if (errno == EINTR) continue;
+                return;
+            }
+            connections.try_emplace(fd);
+            if (!watch(fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD)) closeClient(fd);
+        }
+    }
+
+    void closeClient(int fd) {
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd);
+    }
+
+    void handleClient(int fd, uint32_t events) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        Connection& conn = it->second;
+
+        if (events & EPOLLIN) {
+            char chunk[64 * 1024];
+            while (true) {
+                ssize_t n = ::read(fd, chunk, sizeof(chunk));
+                if (n > 0) {
+                    conn.in.append(chunk, static_cast<size_t>(n));
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                // EOF or error: answer what already arrived, then hang up
+                conn.closing = true;
+                break;
+            }
+            if (!processRequests(conn)) {
+                closeClient(fd);
+                return;
+            }
+        }
+
+        if (!flush(fd, conn)) {
+            closeClient(fd);
+            return;
+        }
+        bool pending = conn.written < conn.out.size();
+        if (events & EPOLLERR) conn.closing = true;
+        if (conn.closing && !pending) {
+            closeClient(fd);
+            return;
+        }
+        uint32_t wanted = conn.closing ? 0u : EPOLLIN | EPOLLRDHUP;
+        watch(fd, wanted | (pending ? EPOLLOUT : 0u), EPOLL_CTL_MOD);
+    }
+
+    // returns false on a malformed frame
+    bool processRequests(Connection& conn) {
+        size_t offset = 0;
+        while (true) {
+            uint8_t kind;
+            std::string_view body;
+            size_t consumed;
+            auto result = protocol::nextFrame(std::string_view(conn.in).substr(offset), kind, body, consumed);
+            if (result == protocol::FrameResult::Invalid) return false;
+            if (result == protocol::FrameResult::Incomplete) break;
+            respond(static_cast<protocol::Op>(kind), body, conn.out);
+            offset += consumed;
+        }
+        conn.in.erase(0, offset);
+        return true;
+    }
+
+    // returns false if the client is gone
+    bool flush(int fd, Connection& conn) {
+        while (conn.written < conn.out.size()) {
+            ssize_t n = ::send(fd, conn.out.data() + conn.written, conn.out.size() - conn.written, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            conn.written += static_cast<size_t>(n);
+        }
+        conn.out.clear();
+        conn.written = 0;
+        return true;
+    }
+
+    void respond(protocol::Op op, std::string_view body, std::string& out) {
+        protocol::Status status = protocol::Status::Ok;
+        protocol::FrameWriter writer(out);
+        switch (op) {
+            case protocol::Op::Get: {
+                NoteId id = store.findId(std::string(body));
+                if (NoteDataView note = store.getNoteView(id); note.id != 0)
+                    NoteQuery(store, QueryFormat::JsonLines, writer).writeNote(note);
+                else
+                    status = protocol::Status::NotFound;
+                break;
+            }
+            case protocol::Op::Search: {
+                if (body.size() < 2 || static_cast<uint8_t>(body[0]) > 2 || static_cast<uint8_t>(body[1]) > 1) {
+                    status = protocol::Status::BadRequest;
+                    break;
+                }
+                auto field = static_cast<QueryField>(body[0]);
+                auto format = static_cast<QueryFormat>(body[1]);
+                NoteQuery(store, format, writer).run(std::string(body.substr(2)), field);
+                break;
+            }
+            case protocol::Op::Update: {
+                size_t split = body.find('\0');
+                if (split == std::string_view::npos || split == 0) {
+                    status = protocol::Status::BadRequest;
+                    break;
+                }
+                std::string title(body.substr(0, split));
+                std::string content(body.substr(split + 1));
+                if (NoteId id = store.findId(title)) {
+                    auto note = store.getNoteStrings(id);
+                    store.updateNote(id, title, content, note.tags, note.kids);
+                } else {
+                    store.addNote(title, content, {}, {});
+                }
+                if (!dirty) saveDue = Clock::now() + saveDelay;
+                dirty = true;
+                NoteId id = store.findId(title);
+                NoteQuery(store, QueryFormat::JsonLines, writer).writeNote(store.getNoteView(id));
+                break;
+            }
+            default:
+                status = protocol::Status::BadRequest;
+        }
+        writer.finish(status);
+    }
+};
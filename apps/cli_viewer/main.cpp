@@ -1,20 +1,50 @@
 #include "cli_viewer.hpp"
+#include "client.hpp"
+#include "daemon.hpp"
 #include "logger.h"
 #include "note.hpp"
+#include "trace.h"
 
 int main(int argc, char* argv[]) {
     Logger& log = Logger::getInstance();
     log.enableConsoleLogging(false);
-    log.enableFileLogging("notewiki.log");
-    LOG_INFO() << "Starting viewer";
 
     auto parsed = parse_options(argc, argv);
     if (!parsed.value) {
         if (!parsed.error.empty()) std::cout << parsed.error << "\n";
         return parsed.exit_code;
     }
+    log.enableFileLogging("notewiki.log", {}, parsed.value->log_json ? LogFormat::JSON_LINES : LogFormat::TEXT);
+    if (!parsed.value->flight_recorder.empty()) {
+        if (!log.enableFlightRecorder(parsed.value->flight_recorder)) {
+            LOG_ERROR() << "could not open flight recorder: " << parsed.value->flight_recorder;
+        }
+    }
+    log.installCrashHandlers();
+    if (!parsed.value->trace.empty()) {
+        Tracer::instance().setThreadName("main");
+        Tracer::instance().enable();
+    }
+    LOG_INFO() << "Starting viewer";
 
-    CliViewer viewer(*parsed.value);
+    int status;
+    if (parsed.value->daemon) {
+        NoteDaemon daemon(*parsed.value);
+        status = daemon.run();
+    } else if (!parsed.value->socket_path.empty()) {
+        // a running daemon already holds the store, don't load it again
+        status = runClient(*parsed.value);
+    } else {
+        CliViewer viewer(*parsed.value);
+        status = viewer.run();
+    }
 
-    return viewer.run();
+    if (!parsed.value->trace.empty()) {
+        if (!Tracer::instance().writeFile(parsed.value->trace)) {
+            LOG_ERROR() << "could not write trace: " << parsed.value->trace;
+        }
+        // the teardown after this would only record events nobody writes out
+        Tracer::instance().disable();
+    }
+    return status;
 }
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>    // for std::min
+#include <charconv>     // for std::to_chars
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * Wire format between notewiki_cli and its daemon, over a Unix-domain stream socket.
+ * Every message is one frame: a 4 byte little-endian payload length, then the payload.
+ * * request payload:  [u8 Op][body]
+ *      Get:    title
+ *      Search: [u8 QueryField][u8 QueryFormat] query
+ *      Update: title '\0' content, creates the note if it doesn't exist
+ * * response payload: [u8 Status][body]
+ *      the matching notes, written like the --query output
+ * * A response longer than 'replyChunk' comes in parts: 'More' frames, then one
+ *   frame with the real status, the client joins their bodies. No frame is ever
+ *   over 'maxPayload', whatever the size of the response.
+ */
+namespace protocol {
+
+enum class Op : uint8_t { Get = 1, Search = 2, Update = 3 };
+enum class Status : uint8_t { Ok = 0, NotFound = 1, BadRequest = 2, More = 3 };
+
+inline constexpr size_t headerSize = 4;
+inline constexpr uint32_t maxPayload = 64u << 20;
+inline constexpr size_t replyChunk = 1u << 20;
+
+inline void writeHeader(char* header, uint32_t length) {
+    for (size_t i = 0; i < headerSize; ++i) header[i] = static_cast<char>((length >> (8 * i)) & 0xff);
+}
+
+/**
+ * Returns false, and appends nothing, if 'body' doesn't fit in 'maxPayload'.
+ */
+inline bool appendFrame(std::string& out, uint8_t kind, std::string_view body) {
+    if (body.size() >= maxPayload) return false;
+    char header[headerSize];
+    writeHeader(header, static_cast<uint32_t>(body.size() + 1));
+    out.append(header, headerSize);
+    out.push_back(static_cast<char>(kind));
+    out.append(body);
+    return true;
+}
+
+/**
+ * Writes a response as frames straight into 'out', a 'More' frame every
+ * 'replyChunk' bytes, so it is never copied or held twice. 'finish' closes the
+ * last frame with the response's status. Has the interface of StringWriter.
+ */
+class FrameWriter {
+public:
+    explicit FrameWriter(std::string& out) : out(out) { begin(); }
+
+    bool ok() const noexcept { return true; }
+    void flush() {}
+
+    void write(std::string_view text) {
+        while (!text.empty()) {
+            size_t room = replyChunk - (out.size() - start - headerSize - 1);
+            if (room == 0) {
+                end(Status::More);
+                begin();
+                continue;
+            }
+            size_t n = std::min(room, text.size());
+            out.append(text.substr(0, n));
+            text.remove_prefix(n);
+        }
+    }
+    void put(char c) { write(std::string_view(&c, 1)); }
+    void number(uint64_t value) {
+        char digits[20];
+        auto [last, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        write(std::string_view(digits, static_cast<size_t>(last - digits)));
+    }
+
+    void finish(Status status) { end(status); }
+
+private:
+    std::string& out;
+    size_t start{0};    // where the open frame's header is
+
+    void begin() {
+        start = out.size();
+        out.append(headerSize + 1, '\0');
+    }
+    void end(Status status) {
+        writeHeader(out.data() + start, static_cast<uint32_t>(out.size() - start - headerSize));
+        out[start + headerSize] = static_cast<char>(status);
+    }
+};
+
+enum class FrameResult { Complete, Incomplete, Invalid };
+
+/**
+ * Looks for a whole frame at the start of 'buffer'. On 'Complete', 'kind' and
+ * 'body' describe it and 'consumed' is its size including the header.
+ */
+inline FrameResult nextFrame(std::string_view buffer, uint8_t& kind, std::string_view& body, size_t& consumed) {
+    if (buffer.size() < headerSize) return FrameResult::Incomplete;
+    uint32_t length = 0;
+    for (size_t i = 0; i < headerSize; ++i) {
+        length |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[i])) << (8 * i);
+    }
+    if (length == 0 || length > maxPayload) return FrameResult::Invalid;
+    if (buffer.size() - headerSize < length) return FrameResult::Incomplete;
+    kind = static_cast<uint8_t>(buffer[headerSize]);
+    body = buffer.substr(headerSize + 1, length - 1);
+    consumed = headerSize + length;
+    return FrameResult::Complete;
+}
+
+} // namespace protocol
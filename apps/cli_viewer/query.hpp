@@ -0,0 +1,159 @@
+#pragma once
+
+#include "buffered_writer.h"
+#include "note.hpp"
+
+#include <algorithm>    // for std::search, std::equal
+#include <functional>   // for std::boyer_moore_horspool_searcher
+#include <string>
+#include <string_view>
+
+using namespace note;
+
+enum class QueryField { Title, Tag, Content };
+enum class QueryFormat { JsonLines, Tsv };
+
+/**
+ * Runs one query against the NoteStore and streams every match to a BufferedWriter,
+ * for scripting against large stores (ex: 'notewiki_cli --query rust --by tag | jq').
+ * * Title and content queries match case-insensitive substrings, tag queries
+ *   list the kids of the note with exactly that title.
+ * * Matches come out in NoteId order, one record per line, nothing is copied
+ *   out of the store.
+ * * TSV escapes tabs, newlines and backslashes, and the ',' inside a tag or kid
+ *   title, so the title lists split on the unescaped ','.
+ * * 'Writer' is a BufferedWriter for stdout, or a StringWriter (ex: for daemon replies).
+ */
+template<typename Writer>
+class NoteQuery {
+public:
+    NoteQuery(const NoteStore& store, QueryFormat format, Writer& out) :
+        store(store), format(format), out(out) {}
+
+    /**
+     * Returns the number of matching notes.
+     */
+    size_t run(const std::string& query, QueryField field) {
+        if (format == QueryFormat::Tsv) out.write("id\ttitle\ttags\tkids\tcontent\n");
+        size_t matches = 0;
+        if (field == QueryField::Tag) {
+            NoteId tag = store.findId(query);
+            if (tag == 0) return 0;
+            for (NoteId id : store.getNote(tag).kids) {
+                if (NoteDataView note = store.getNoteView(id); note.id != 0) {
+                    writeNote(note);
+                    ++matches;
+                }
+            }
+            return matches;
+        }
+
+        Searcher searcher(query.begin(), query.end());
+        for (NoteId id = 1; id <= store.lastId(); ++id) {
+            const NoteData* note = store.findNote(id);
+            if (!note) continue;
+            const std::string& text = field == QueryField::Title ? note->title : note->content;
+            if (std::search(text.begin(), text.end(), searcher) == text.end()) continue;
+            writeNote(store.getNoteView(id));
+            ++matches;
+        }
+        return matches;
+    }
+
+    void writeNote(const NoteDataView& note) {
+        if (format == QueryFormat::JsonLines) {
+            out.write("{\"id\":");
+            out.number(note.id);
+            out.write(",\"title\":");
+            writeJsonString(note.title);
+            out.write(",\"tags\":");
+            writeTitles(note.tags);
+            out.write(",\"kids\":");
+            writeTitles(note.kids);
+            out.write(",\"content\":");
+            writeJsonString(note.content);
+            out.write("}\n");
+        } else {
+            out.number(note.id);
+            out.put('\t');
+            writeTsvField(note.title);
+            out.put('\t');
+            writeTitles(note.tags);
+            out.put('\t');
+            writeTitles(note.kids);
+            out.put('\t');
+            writeTsvField(note.content);
+            out.put('\n');
+        }
+    }
+
+private:
+    const NoteStore& store;
+    QueryFormat format;
+    Writer& out;
+
+    // ASCII case folding for the matcher
+    static char fold(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    struct FoldHash {
+        size_t operator()(char c) const { return static_cast<unsigned char>(fold(c)); }
+    };
+    struct FoldEqual {
+        bool operator()(char a, char b) const { return fold(a) == fold(b); }
+    };
+    using Searcher = std::boyer_moore_horspool_searcher<std::string::const_iterator, FoldHash, FoldEqual>;
+
+    void writeJsonString(std::string_view text) {
+        static constexpr char hex[] = "0123456789abcdef";
+        out.put('"');
+        size_t plain = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            out.write(text.substr(plain, i - plain));
+            plain = i + 1;
+            switch (c) {
+                case '"': out.write("\\\""); break;
+                case '\\': out.write("\\\\"); break;
+                case '\n': out.write("\\n"); break;
+                case '\r': out.write("\\r"); break;
+                case '\t': out.write("\\t"); break;
+                default:
+                    out.write("\\u00");
+                    out.put(hex[c >> 4]);
+                    out.put(hex[c & 0xf]);
+            }
+        }
+        out.write(text.substr(plain));
+        out.put('"');
+    }
+
+    // TSV fields can't hold tabs or newlines, they are written as \t, \n and \\ escapes.
+    // Titles in a list are separated by ',', a ',' inside one is written as \,
+    void writeTsvField(std::string_view text, bool inList = false) {
+        size_t plain = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+            if (c != '\t' && c != '\n' && c != '\r' && c != '\\' && (c != ',' || !inList)) continue;
+            out.write(text.substr(plain, i - plain));
+            plain = i + 1;
+            out.put('\\');
+            out.put(c == '\t' ? 't' : c == '\n' ? 'n' : c == '\r' ? 'r' : c);
+        }
+        out.write(text.substr(plain));
+    }
+
+    void writeTitles(const TitleRange& titles) {
+        bool json = format == QueryFormat::JsonLines;
+        if (json) out.put('[');
+        bool first = true;
+        for (std::string_view title : titles) {
+            if (!first) out.put(',');
+            first = false;
+            if (json) writeJsonString(title);
+            else writeTsvField(title, true);
+        }
+        if (json) out.put(']');
+    }
+};
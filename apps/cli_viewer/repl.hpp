@@ -0,0 +1,217 @@
+#pragma once
+
+#include "buffered_writer.h"
+#include "note.hpp"
+
+#include <algorithm>    // for std::lower_bound, std::sort, std::max
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+using namespace note;
+
+struct TerminalSize {
+    size_t rows{24};
+    size_t cols{80};
+};
+
+/**
+ * Size of the terminal on stdout, 24x80 when it isn't a terminal.
+ */
+inline TerminalSize terminalSize() {
+    TerminalSize size;
+    winsize ws{};
+    if (::ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+        size.rows = ws.ws_row;
+        size.cols = ws.ws_col;
+    }
+    return size;
+}
+
+/**
+ * Sorted titles of the NoteStore for completing titles from their prefix,
+ * rebuilt when the store version changes.
+ */
+class TitleIndex {
+public:
+    /**
+     * Resolves 'prefix' to a note: an exact title, or the only title starting with it.
+     * Returns 0 otherwise, 'candidates' then holds up to 'max_candidates' titles
+     * starting with 'prefix'.
+     */
+    NoteId complete(const NoteStore& store, std::string_view prefix,
+                    std::vector<std::string_view>& candidates, size_t max_candidates = 10) {
+        refresh(store);
+        candidates.clear();
+        auto it = std::lower_bound(entries.begin(), entries.end(), prefix,
+                                   [](const Entry& e, std::string_view p) { return e.title < p; });
+        if (it != entries.end() && it->title == prefix) return it->id;
+
+        NoteId match = 0;
+        size_t matches = 0;
+        for (; it != entries.end() && it->title.substr(0, prefix.size()) == prefix; ++it) {
+            match = it->id;
+            if (matches++ < max_candidates) candidates.push_back(it->title);
+        }
+        return matches == 1 ? match : 0;
+    }
+
+private:
+    struct Entry {
+        std::string_view title;     // points into the store
+        NoteId id;
+    };
+    std::vector<Entry> entries;
+    uint64_t version{~0ull};
+
+    void refresh(const NoteStore& store) {
+        if (version == store.version()) return;
+        version = store.version();
+        entries.clear();
+        entries.reserve(store.size());
+        for (NoteId id = 1; id <= store.lastId(); ++id) {
+            if (const NoteData* note = store.findNote(id)) entries.push_back({note->title, id});
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.title < b.title; });
+    }
+};
+
+/**
+ * Decodes the UTF-8 code point at 'text[i]' and moves 'i' past it. A byte that
+ * doesn't start a valid sequence is returned as it is, one byte long.
+ */
+inline char32_t decodeUtf8(std::string_view text, size_t& i) {
+    unsigned char lead = static_cast<unsigned char>(text[i]);
+    size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xe ? 3 : (lead >> 3) == 0x1e ? 4 : 0;
+    if (length <= 1 || i + length > text.size()) {
+        ++i;
+        return lead;
+    }
+    char32_t c = lead & (0x7f >> length);
+    for (size_t k = 1; k < length; ++k) {
+        unsigned char next = static_cast<unsigned char>(text[i + k]);
+        if ((next & 0xc0) != 0x80) {
+            ++i;
+            return lead;
+        }
+        c = (c << 6) | (next & 0x3f);
+    }
+    i += length;
+    return c;
+}
+
+/**
+ * Terminal columns taken by 'c', like wcwidth(): 0 for control characters and
+ * combining marks, 2 for East Asian wide characters and emoji, 1 otherwise.
+ */
+inline size_t displayWidth(char32_t c) {
+    if (c < 0x20 || (c >= 0x7f && c < 0xa0)) return 0;
+    if ((c >= 0x0300 && c <= 0x036f) || (c >= 0x1ab0 && c <= 0x1aff) || (c >= 0x1dc0 && c <= 0x1dff) ||
+        (c >= 0x200b && c <= 0x200f) || (c >= 0x20d0 && c <= 0x20ff) || (c >= 0xfe00 && c <= 0xfe0f) ||
+        (c >= 0xfe20 && c <= 0xfe2f)) return 0;
+    if ((c >= 0x1100 && c <= 0x115f) || (c >= 0x2e80 && c <= 0x303e) || (c >= 0x3041 && c <= 0x33ff) ||
+        (c >= 0x3400 && c <= 0x4dbf) || (c >= 0x4e00 && c <= 0x9fff) || (c >= 0xa000 && c <= 0xa4cf) ||
+        (c >= 0xac00 && c <= 0xd7a3) || (c >= 0xf900 && c <= 0xfaff) || (c >= 0xfe30 && c <= 0xfe4f) ||
+        (c >= 0xff00 && c <= 0xff60) || (c >= 0xffe0 && c <= 0xffe6) || (c >= 0x1f300 && c <= 0x1f64f) ||
+        (c >= 0x1f900 && c <= 0x1f9ff) || (c >= 0x20000 && c <= 0x3fffd)) return 2;
+    return 1;
+}
+
+/**
+ * Shows long text one screen at a time. Lines wider than the terminal are
+ * wrapped between code points by their display width, tabs are expanded to
+ * the next multiple of 'tabWidth' columns. Only the rows of the current
+ * window are written.
+ */
+class Pager {
+public:
+    static constexpr size_t defaultTabWidth = 8;
+
+    Pager(std::string_view text, TerminalSize size, size_t tabWidth = defaultTabWidth) :
+        text(text), size(size), tabWidth(std::max<size_t>(tabWidth, 1)) {
+        // byte range of every screen row
+        size_t width = std::max<size_t>(size.cols, 1);
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == std::string_view::npos) end = text.size();
+            size_t row = start;
+            size_t column = 0;
+            for (size_t i = start; i < end;) {
+                size_t next = i;
+                char32_t c = decodeUtf8(text, next);
+                size_t w = advance(c, column);
+                // a character wider than the whole row still gets a row of its own
+                if (column + w > width && column > 0) {
+                    rows.push_back({row, i});
+                    row = i;
+                    column = 0;
+                    w = advance(c, column);
+                }
+                column += w;
+                i = next;
+            }
+            rows.push_back({row, end});
+            start = end + 1;
+        }
+    }
+
+    size_t rowCount() const { return rows.size(); }
+    // rows left for text, one is kept for the status line
+    size_t pageRows() const { return size.rows > 1 ? size.rows - 1 : 1; }
+    bool atEnd() const { return top + pageRows() >= rows.size(); }
+    void next() { if (!atEnd()) top += pageRows(); }
+    void previous() { top = top > pageRows() ? top - pageRows() : 0; }
+
+    /**
+     * 'Writer' is a BufferedWriter for the terminal, or a StringWriter.
+     */
+    template<typename Writer>
+    void render(Writer& out) const {
+        out.write("\033[H\033[2J"); // home, clear screen
+        size_t last = std::min(rows.size(), top + pageRows());
+        for (size_t i = top; i < last; ++i) {
+            writeRow(out, text.substr(rows[i].first, rows[i].second - rows[i].first));
+            out.put('\n');
+        }
+        out.write("-- lines ");
+        out.number(top + 1);
+        out.put('-');
+        out.number(last);
+        out.write(" of ");
+        out.number(rows.size());
+        out.write(atEnd() ? " (end) [p]rev [q]uit: " : " [enter] next [p]rev [q]uit: ");
+    }
+
+private:
+    std::string_view text;
+    TerminalSize size;
+    size_t tabWidth;
+    std::vector<std::pair<size_t, size_t>> rows;
+    size_t top{0};
+
+    // columns taken by 'c' written at 'column'
+    size_t advance(char32_t c, size_t column) const {
+        return c == '\t' ? tabWidth - column % tabWidth : displayWidth(c);
+    }
+
+    // a row with its tabs as spaces, they depend on the column the row starts at
+    template<typename Writer>
+    void writeRow(Writer& out, std::string_view row) const {
+        size_t plain = 0;
+        size_t column = 0;
+        for (size_t i = 0; i < row.size();) {
+            size_t at = i;
+            char32_t c = decodeUtf8(row, i);
+            size_t w = advance(c, column);
+            column += w;
+            if (c != '\t') continue;
+            out.write(row.substr(plain, at - plain));
+            plain = i;
+            for (; w > 0; --w) out.put(' ');
+        }
+        out.write(row.substr(plain));
+    }
+};
@@ -0,0 +1,75 @@
+// Prints the last records of a flight recorder file, see Logger::enableFlightRecorder.
+//      usage: notewiki_flightdump <file> [-n count]
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "buffered_writer.h"
+#include "flight_recorder.h"
+#include "logger.h"
+
+static std::string_view levelName(uint8_t level) {
+    switch (static_cast<LogLevel>(level)) {
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::DEBUG: return "DEBUG";
+        default: return "?";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    size_t count = 100;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if ((arg == "-n" || arg == "--count") && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-h" || arg == "--help" || !path.empty()) {
+            std::cout << "usage: notewiki_flightdump <file> [-n count]\n";
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        } else {
+            path = arg;
+        }
+    }
+    if (path.empty()) {
+        std::cout << "usage: notewiki_flightdump <file> [-n count]\n";
+        return 1;
+    }
+
+    std::string error;
+    std::vector<FlightRecord> records = FlightRecorder::load(path, count, error);
+    if (!error.empty()) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    // "seq YYYY-MM-DD hh:mm:ss.nnnnnnnnn [LEVEL] [þr:id] message", like the text log
+    BufferedWriter out;
+    std::string line;
+    char buffer[32];
+    for (const FlightRecord& record : records) {
+        line.clear();
+        line.append(std::to_string(record.seq));
+        line.push_back(' ');
+        std::time_t seconds = static_cast<std::time_t>(record.timestamp / 1000000000);
+        std::tm tm{};
+        localtime_r(&seconds, &tm);
+        line.append(buffer, std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm));
+        std::snprintf(buffer, sizeof(buffer), ".%09lld", static_cast<long long>(record.timestamp % 1000000000));
+        line.append(buffer);
+        line.append(" [");
+        line.append(levelName(record.level));
+        std::snprintf(buffer, sizeof(buffer), "] [þr:%llx] ", static_cast<unsigned long long>(record.thread));
+        line.append(buffer);
+        log_args::decode(record.args, line);
+        line.push_back('\n');
+        out.write(line);
+    }
+    out.flush();
+    return out.ok() ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Where the time of a frame goes.
+ * Input: window events and ImGui::NewFrame, then the event queue of the frame
+ * Notes: renderNotes
+ * Tools: menu, search, graph and diagnostics windows
+ * Render: ImGui::Render and the draw calls
+ * Swap: glfwSwapBuffers, includes waiting for vsync
+ */
+enum class FramePhase : uint8_t { Input, Notes, Tools, Render, Swap };
+
+/**
+ * Phase durations of the last 'frames' frames, cheap enough to always collect:
+ * one clock read per phase, no allocation, no lock (UI thread only).
+ *
+ * example:
+ *      timings.beginFrame();
+ *      renderNotes(ctx);
+ *      timings.lap(FramePhase::Notes);
+ */
+class FrameTimings {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t phases = 5;
+    static constexpr size_t frames = 240;
+    static constexpr const char* phaseNames[phases] = {"input", "notes", "tools", "render", "swap"};
+
+    // one frame, microseconds per phase
+    using Frame = std::array<float, phases>;
+
+    /**
+     * Starts the next frame, the time since the last lap is dropped.
+     * 'now' is for tests, the clock is read by default.
+     */
+    void beginFrame(Clock::time_point now = Clock::now()) noexcept {
+        current = (current + 1) % frames;
+        ring[current] = {};
+        if (count < frames) ++count;
+        mark = now;
+    }
+
+    /**
+     * Adds the time since the last lap (or 'beginFrame') to 'phase' of the current frame.
+     */
+    void lap(FramePhase phase, Clock::time_point now = Clock::now()) noexcept {
+        ring[current][static_cast<size_t>(phase)] +=
+            std::chrono::duration<float, std::micro>(now - mark).count();
+        mark = now;
+    }
+
+    // frames recorded, up to 'frames'
+    size_t size() const noexcept { return count; }
+
+    // 'age' 0 is the current frame, 1 the one before, ...
+    const Frame& frame(size_t age) const noexcept { return ring[(current + frames - age) % frames]; }
+
+    static float total(const Frame& frame) noexcept {
+        float sum = 0.0f;
+        for (float us : frame) sum += us;
+        return sum;
+    }
+
+private:
+    std::array<Frame, frames> ring{};
+    size_t current{0};
+    size_t count{0};
+    Clock::time_point mark{Clock::now()};
+};
@@ -1,37 +1,111 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <optional>
 
+#include "logger.h"
+#include "mpsc_queue.h"
 #include "note.hpp"
 
 enum class EventType {
     BeginEdit, CancelEdit, SubmitEdit,
-    OpenId, MoveUp, MoveDown,
+    OpenId, CloseId, MoveUp, MoveDown,
+    SearchQuery, SearchResults,
 };
 
 struct Event {
     EventType type;
     note::NoteId id{};
-    std::optional<note::NoteId> insertAfter;
+    std::optional<note::NoteId> insertAfter{};
+    uint32_t repeat{1};     // MoveUp/MoveDown: how many steps, see 'EventQueue::try_pop'
 };
 
 /**
  * EventQueue allows protecting the container object, defining behaviour, and 
- * change internals in the future
+ * change internals in the future.
+ * * Any thread may 'push' (UI, search, graph layout, ...), only the UI thread
+ *   may 'try_pop'. Internally a bounded lock-free ring. No event is ever
+ *   dropped: when the ring is full 'push' spills into a locked overflow list,
+ *   and keeps spilling until the UI thread has drained it, so the events of one
+ *   producer stay in order. 'push' never blocks on the consumer, the UI thread
+ *   pushes to its own queue.
+ * * 'try_pop' coalesces redundant events waiting right behind the popped one:
+ *   repeated MoveUp/MoveDown on the same id add up in 'repeat', duplicate OpenId,
+ *   SearchQuery and SearchResults events are dropped (their handlers read the
+ *   latest state anyway).
+ * * The wakeup hook runs after every 'push', ex: to wake up a UI thread blocked
+ *   waiting for window events. A plain function so it can be swapped atomically.
  */
 class EventQueue {
 public:
-    void push(Event a) { q_.push_back(std::move(a)); }
+    static constexpr size_t defaultCapacity = 1024;
+
+    explicit EventQueue(size_t capacity = defaultCapacity) : q_(capacity) {}
+
+    void setWakeup(void (*hook)()) { wakeup_.store(hook, std::memory_order_release); }
+
+    void push(Event a) {
+        if (overflowing_.load(std::memory_order_acquire) || !q_.try_push(a)) {
+            std::lock_guard<std::mutex> lock(overflowMtx_);
+            if (overflow_.empty()) LOG_WARNING() << "event queue full, spilling events";
+            overflow_.push_back(std::move(a));
+            overflowing_.store(true, std::memory_order_release);
+        }
+        if (auto hook = wakeup_.load(std::memory_order_acquire)) hook();
+    }
     
     /**
      * returns bool to allow use in a while loop iterating over the queue
      */
     bool try_pop(Event& out) {
-        if (q_.empty()) return false;
-        out = std::move(q_.front());
-        q_.pop_front();
+        if (!q_.try_pop(out)) return popOverflow(out);
+        while (const Event* next = q_.front()) {
+            if (!mergeInto(out, *next)) break;
+            q_.pop();
+        }
         return true;
     }
+
+    bool empty() const {
+        return q_.empty() && !overflowing_.load(std::memory_order_acquire);
+    }
 private:
-    std::deque<Event> q_;
-};
\ No newline at end of file
+    MpscQueue<Event> q_;
+    std::atomic<void (*)()> wakeup_{nullptr};
+    // events that did not fit in 'q_', popped once 'q_' is empty
+    std::mutex overflowMtx_;
+    std::deque<Event> overflow_;
+    std::atomic<bool> overflowing_{false};  // 'overflow_' is not empty, set under 'overflowMtx_'
+
+    bool popOverflow(Event& out) {
+        if (!overflowing_.load(std::memory_order_acquire)) return false;
+        std::lock_guard<std::mutex> lock(overflowMtx_);
+        out = std::move(overflow_.front());
+        overflow_.pop_front();
+        if (overflow_.empty()) overflowing_.store(false, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Folds 'next' into 'current' if handling both is the same as handling 'current' once.
+     */
+    static bool mergeInto(Event& current, const Event& next) {
+        if (next.type != current.type) return false;
+        switch (current.type) {
+            case EventType::MoveUp:
+            case EventType::MoveDown:
+                if (next.id != current.id) return false;
+                current.repeat += next.repeat;
+                return true;
+            case EventType::OpenId:
+                return next.id == current.id && next.insertAfter == current.insertAfter;
+            case EventType::SearchQuery:
+            case EventType::SearchResults:
+                return true;
+            default:
+                return false;
+        }
+    }
+};
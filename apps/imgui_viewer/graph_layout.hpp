@@ -0,0 +1,517 @@
+#pragma once
+
+#include "note.hpp"
+#include "thread_pool.h"
+
+#include <atomic>             // for std::atomic<>
+#include <cmath>              // for std::sqrt, std::cos, std::sin
+#include <condition_variable> // for std::condition_variable
+#include <limits>             // for std::numeric_limits
+#include <mutex>              // for std::mutex, std::lock_guard<>
+#include <shared_mutex>       // for std::shared_mutex, std::shared_lock<>
+#include <thread>             // for std::thread
+#include <utility>            // for std::swap, std::pair
+#include <vector>
+
+using namespace note;
+
+struct GraphPoint {
+    float x{0.0f};
+    float y{0.0f};
+};
+
+/**
+ * Barnes-Hut quadtree over the node positions, rebuilt every layout step.
+ * Nodes far away relative to their cell size are approximated by the cell's
+ * center of mass, so repulsion costs O(n log n) instead of O(n^2).
+ * The bodies of every cell are a range of 'order', so 'query' takes the cells
+ * inside a rectangle whole.
+ */
+class QuadTree {
+public:
+    void build(const std::vector<GraphPoint>& points) {
+        cells.clear();
+        if (points.empty()) return;
+
+        float min_x = points[0].x, max_x = points[0].x;
+        float min_y = points[0].y, max_y = points[0].y;
+        for (const auto& p : points) {
+            min_x = std::min(min_x, p.x); max_x = std::max(max_x, p.x);
+            min_y = std::min(min_y, p.y); max_y = std::max(max_y, p.y);
+        }
+        float size = std::max(max_x - min_x, max_y - min_y) + 1.0f;
+        cells.reserve(points.size() * 2);
+        cells.push_back(Cell{min_x, min_y, size});
+        nextMerged.assign(points.size(), -1);
+        for (uint32_t i = 0; i < points.size(); ++i) insert(points, i);
+        buildOrder();
+    }
+
+    /**
+     * Bodies in depth-first tree order: neighbours in space are neighbours in
+     * this list, so walking it keeps the cells a thread touches in cache.
+     */
+    const std::vector<uint32_t>& order() const noexcept { return bodyOrder; }
+
+    /**
+     * Calls 'visit(body)' for every body of 'points' (the points the tree was
+     * built from) inside the rectangle ['x0', 'x1'] x ['y0', 'y1'].
+     */
+    template<typename Visit>
+    void query(const std::vector<GraphPoint>& points, float x0, float y0, float x1, float y1,
+               Visit&& visit) const {
+        if (cells.empty()) return;
+        auto inside = [&](const GraphPoint& p) { return p.x >= x0 && p.x <= x1 && p.y >= y0 && p.y <= y1; };
+
+        int32_t stack[4 * maxDepth + 4];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Cell& cell = cells[stack[--top]];
+            const float cx1 = cell.x0 + cell.size, cy1 = cell.y0 + cell.size;
+            if (cell.mass == 0.0f || cell.x0 > x1 || cx1 < x0 || cell.y0 > y1 || cy1 < y0) continue;
+            const bool covered = cell.x0 >= x0 && cx1 <= x1 && cell.y0 >= y0 && cy1 <= y1;
+            const bool leaf = cell.child[0] < 0 && cell.child[1] < 0 && cell.child[2] < 0 && cell.child[3] < 0;
+            if (covered || leaf) {
+                const uint32_t end = cell.first + static_cast<uint32_t>(cell.mass);
+                for (uint32_t k = cell.first; k < end; ++k) {
+                    if (covered || inside(points[bodyOrder[k]])) visit(bodyOrder[k]);
+                }
+            } else {
+                for (int32_t c : cell.child) {
+                    if (c >= 0) stack[top++] = c;
+                }
+            }
+        }
+    }
+
+    /**
+     * Sum of the repulsive forces on 'points[body]', 'strength / distance' falloff.
+     */
+    GraphPoint repulsion(const std::vector<GraphPoint>& points, uint32_t body,
+                         float strength, float theta) const {
+        GraphPoint force;
+        if (cells.empty()) return force;
+        const GraphPoint& p = points[body];
+        const float theta2 = theta * theta;
+
+        int32_t stack[4 * maxDepth + 4];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Cell& cell = cells[stack[--top]];
+            if (cell.mass == 0.0f || cell.body == static_cast<int32_t>(body)) continue;
+
+            float dx = p.x - cell.cx;
+            float dy = p.y - cell.cy;
+            float d2 = dx * dx + dy * dy;
+            bool leaf = cell.child[0] < 0 && cell.child[1] < 0 && cell.child[2] < 0 && cell.child[3] < 0;
+            if (leaf || cell.size * cell.size < theta2 * d2) {
+                if (d2 < 1e-4f) continue; // coincident, nudged apart by the springs
+                float f = strength * cell.mass / d2;
+                force.x += dx * f;
+                force.y += dy * f;
+            } else {
+                for (int32_t c : cell.child) {
+                    if (c >= 0) stack[top++] = c;
+                }
+            }
+        }
+        return force;
+    }
+
+private:
+    static constexpr int maxDepth = 24;
+
+    struct Cell {
+        float x0, y0, size;
+        float cx{0.0f}, cy{0.0f}, mass{0.0f};
+        int32_t child[4]{-1, -1, -1, -1};
+        int32_t body{-1};
+        int32_t merged{-1};     // max depth cells: the first of the bodies too close to separate
+        uint32_t first{0};      // the cell's bodies are 'bodyOrder[first, first + mass)'
+    };
+    std::vector<Cell> cells;
+    std::vector<uint32_t> bodyOrder;
+    std::vector<int32_t> nextMerged;    // per body, the next body of the same max depth cell
+    std::vector<int32_t> stack;
+
+    // depth-first, so the bodies of a cell follow each other
+    void buildOrder() {
+        bodyOrder.clear();
+        stack.assign(1, 0);
+        while (!stack.empty()) {
+            Cell& cell = cells[stack.back()];
+            stack.pop_back();
+            cell.first = static_cast<uint32_t>(bodyOrder.size());
+            if (cell.body >= 0) bodyOrder.push_back(static_cast<uint32_t>(cell.body));
+            for (int32_t b = cell.merged; b >= 0; b = nextMerged[b]) bodyOrder.push_back(static_cast<uint32_t>(b));
+            for (int q = 3; q >= 0; --q) {
+                if (cell.child[q] >= 0) stack.push_back(cell.child[q]);
+            }
+        }
+    }
+
+    void merge(Cell& cell, int32_t body) {
+        nextMerged[body] = cell.merged;
+        cell.merged = body;
+    }
+
+    static void addMass(Cell& cell, const GraphPoint& p) {
+        float mass = cell.mass + 1.0f;
+        cell.cx += (p.x - cell.cx) / mass;
+        cell.cy += (p.y - cell.cy) / mass;
+        cell.mass = mass;
+    }
+
+    int quadrant(const Cell& cell, const GraphPoint& p) const {
+        float half = cell.size * 0.5f;
+        return (p.x >= cell.x0 + half ? 1 : 0) + (p.y >= cell.y0 + half ? 2 : 0);
+    }
+
+    int32_t childOf(int32_t index, int q) {
+        if (cells[index].child[q] < 0) {
+            const Cell& cell = cells[index];
+            float half = cell.size * 0.5f;
+            Cell child{cell.x0 + ((q & 1) ? half : 0.0f), cell.y0 + ((q & 2) ? half : 0.0f), half};
+            cells.push_back(child);
+            cells[index].child[q] = static_cast<int32_t>(cells.size() - 1);
+        }
+        return cells[index].child[q];
+    }
+
+    void insert(const std::vector<GraphPoint>& points, uint32_t body) {
+        const GraphPoint& p = points[body];
+        int32_t index = 0;
+        for (int depth = 0; ; ++depth) {
+            Cell& cell = cells[index];
+            bool leaf = cell.child[0] < 0 && cell.child[1] < 0 && cell.child[2] < 0 && cell.child[3] < 0;
+            if (leaf) {
+                if (cell.mass == 0.0f) {
+                    cell.body = static_cast<int32_t>(body);
+                    addMass(cell, p);
+                    return;
+                }
+                if (depth >= maxDepth) {
+                    // too close to separate, keep them together in one cell
+                    if (cell.body >= 0) merge(cell, cell.body);
+                    cell.body = -1;
+                    merge(cell, static_cast<int32_t>(body));
+                    addMass(cell, p);
+                    return;
+                }
+                // split: push the resident body one level down
+                int32_t resident = cell.body;
+                cells[index].body = -1;
+                if (resident >= 0) {
+                    int32_t c = childOf(index, quadrant(cells[index], points[resident]));
+                    cells[c].body = resident;
+                    addMass(cells[c], points[resident]);
+                }
+            }
+            addMass(cells[index], p);
+            index = childOf(index, quadrant(cells[index], p));
+        }
+    }
+};
+
+/**
+ * One published state of the layout, handed to the renderer.
+ * 'topology' changes whenever 'ids', 'edges' or the adjacency changed.
+ */
+struct GraphFrame {
+    uint64_t topology{0};
+    uint64_t iteration{0};
+    float temperature{0.0f};
+    std::vector<NoteId> ids;
+    std::vector<GraphPoint> positions;
+    std::vector<std::pair<uint32_t, uint32_t>> edges; // indices into 'ids', note -> tag
+    std::vector<uint32_t> adjacencyOffsets;           // CSR adjacency over 'ids', both directions
+    std::vector<uint32_t> adjacency;
+    QuadTree tree;                                    // over 'positions', for what a viewport shows
+};
+
+/**
+ * Force-directed (Fruchterman-Reingold) layout of the note graph.
+ * * Runs on its own thread, the forces are computed on a ThreadPool.
+ * * Each step is published through a triple buffer, so the UI thread only ever
+ *   swaps two indices and never waits for a step to finish.
+ * * 'markDirty' rebuilds the graph from the store, nodes keep their positions
+ *   and new nodes start next to their neighbours, so the picture stays stable.
+ * * The wakeup hook runs after every published step, so a UI thread waiting for
+ *   window events draws it.
+ */
+class GraphLayout {
+public:
+    GraphLayout(const NoteStore& store, std::shared_mutex& storeMtx, size_t workers = 0) :
+        store(store), storeMtx(storeMtx),
+        pool(workers ? workers : std::max(1u, std::thread::hardware_concurrency()) - 1) {
+        worker = std::thread(&GraphLayout::run, this);
+    }
+
+    ~GraphLayout() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+        }
+        cv.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    GraphLayout(const GraphLayout&) = delete;
+    GraphLayout& operator=(const GraphLayout&) = delete;
+
+    void setWakeup(void (*hook)()) { wakeup.store(hook, std::memory_order_release); }
+
+    /**
+     * The layout only runs while the graph is shown.
+     */
+    void setActive(bool is_active) {
+        if (active.exchange(is_active) == is_active) return;
+        if (is_active) {
+            // take the lock so the wakeup can't slip in before the layout thread waits
+            { std::lock_guard<std::mutex> lock(mtx); }
+            cv.notify_one();
+        }
+    }
+
+    /**
+     * Call after the store changed, the next step picks up the new notes and edges.
+     */
+    void markDirty() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            dirty = true;
+        }
+        cv.notify_one();
+    }
+
+    /**
+     * UI thread: returns the newest published frame.
+     * The frame stays valid until the next call.
+     */
+    const GraphFrame& acquire() {
+        std::lock_guard<std::mutex> lock(swapMtx);
+        if (fresh) {
+            std::swap(front, middle);
+            fresh = false;
+        }
+        return frames[front];
+    }
+
+private:
+    static constexpr float springLength = 40.0f;
+    static constexpr float theta = 1.0f;
+    static constexpr float gravity = 0.02f;
+    static constexpr float cooling = 0.995f;
+    static constexpr float minTemperature = 0.02f;
+    static constexpr float reheatTemperature = 0.3f;
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    const NoteStore& store;
+    std::shared_mutex& storeMtx;
+    ThreadPool pool;
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::atomic<bool> active{false};
+    std::atomic<void (*)()> wakeup{nullptr};
+    bool dirty{true};
+    bool done{false};
+
+    // layout thread state
+    std::vector<NoteId> ids;
+    std::vector<uint32_t> slotOf;              // NoteId -> index into 'ids'
+    std::vector<GraphPoint> positions;
+    std::vector<GraphPoint> displacement;
+    std::vector<uint32_t> adjacencyOffsets;   // CSR adjacency, both directions
+    std::vector<uint32_t> adjacency;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    QuadTree tree;
+    uint64_t topology{0};
+    uint64_t iteration{0};
+    float temperature{1.0f};
+
+    // triple buffer: 'back' is written by the layout thread, 'front' read by the UI
+    GraphFrame frames[3];
+    int back{0}, middle{1}, front{2};
+    bool fresh{false};
+    std::mutex swapMtx;
+
+    // deterministic jitter so new nodes don't start exactly on top of each other
+    static GraphPoint jitter(NoteId id) {
+        uint32_t h = id * 2654435761u;
+        return {static_cast<float>(h & 0xffff) / 65535.0f - 0.5f,
+                static_cast<float>(h >> 16) / 65535.0f - 0.5f};
+    }
+
+    /**
+     * Reads nodes and edges from the store, keeping the positions of known notes.
+     */
+    void rebuild() {
+        std::vector<NoteId> new_ids;
+        std::vector<std::pair<NoteId, NoteId>> id_edges;
+        {
+            std::shared_lock<std::shared_mutex> guard(storeMtx);
+            NoteId last = store.lastId();
+            new_ids.reserve(store.size());
+            for (NoteId id = 1; id <= last; ++id) {
+                const NoteData* note = store.findNote(id);
+                if (!note) continue;
+                new_ids.emplace_back(id);
+                for (NoteId tag : note->tags) id_edges.emplace_back(id, tag);
+            }
+        }
+
+        std::vector<uint32_t> new_slot(new_ids.empty() ? 1 : new_ids.back() + 1, none);
+        for (uint32_t i = 0; i < new_ids.size(); ++i) new_slot[new_ids[i]] = i;
+
+        std::vector<std::pair<uint32_t, uint32_t>> new_edges;
+        new_edges.reserve(id_edges.size());
+        for (const auto& [from, to] : id_edges) {
+            if (to < new_slot.size() && new_slot[to] != none && from != to)
+                new_edges.emplace_back(new_slot[from], new_slot[to]);
+        }
+
+        // CSR adjacency for the spring forces
+        std::vector<uint32_t> offsets(new_ids.size() + 1, 0);
+        for (const auto& [a, b] : new_edges) { ++offsets[a + 1]; ++offsets[b + 1]; }
+        for (size_t i = 1; i < offsets.size(); ++i) offsets[i] += offsets[i - 1];
+        std::vector<uint32_t> adj(offsets.back());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (const auto& [a, b] : new_edges) { adj[fill[a]++] = b; adj[fill[b]++] = a; }
+
+        // keep old positions, place new nodes at the centroid of placed neighbours
+        std::vector<GraphPoint> new_positions(new_ids.size());
+        std::vector<bool> placed(new_ids.size(), false);
+        size_t added = 0;
+        for (uint32_t i = 0; i < new_ids.size(); ++i) {
+            NoteId id = new_ids[i];
+            if (id < slotOf.size() && slotOf[id] != none) {
+                new_positions[i] = positions[slotOf[id]];
+                placed[i] = true;
+            }
+        }
+        for (uint32_t i = 0; i < new_ids.size(); ++i) {
+            if (placed[i]) continue;
+            GraphPoint sum;
+            int count = 0;
+            for (uint32_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+                if (!placed[adj[e]]) continue;
+                sum.x += new_positions[adj[e]].x;
+                sum.y += new_positions[adj[e]].y;
+                ++count;
+            }
+            GraphPoint j = jitter(new_ids[i]);
+            if (count > 0) {
+                new_positions[i] = {sum.x / count + j.x * springLength, sum.y / count + j.y * springLength};
+            } else {
+                // sunflower spiral around the origin
+                float r = springLength * std::sqrt(static_cast<float>(i) + 1.0f);
+                float a = static_cast<float>(i) * 2.39996323f;
+                new_positions[i] = {r * std::cos(a) + j.x, r * std::sin(a) + j.y};
+            }
+            placed[i] = true;
+            ++added;
+        }
+
+        bool first = ids.empty();
+        ids = std::move(new_ids);
+        slotOf = std::move(new_slot);
+        positions = std::move(new_positions);
+        edges = std::move(new_edges);
+        adjacencyOffsets = std::move(offsets);
+        adjacency = std::move(adj);
+        displacement.assign(ids.size(), {});
+        ++topology;
+        // a full restart for the first layout, a gentle one when notes change
+        if (first) temperature = 1.0f;
+        else if (added > 0 || temperature < reheatTemperature) temperature = std::max(temperature, reheatTemperature);
+    }
+
+    /**
+     * One iteration: Barnes-Hut repulsion, springs along edges, weak gravity.
+     */
+    void step() {
+        tree.build(positions);
+        const float k2 = springLength * springLength;
+        const float max_move = temperature * springLength * 2.0f;
+
+        const auto& order = tree.order();
+        pool.parallel_for(order.size(), [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                const uint32_t i = order[k];
+                GraphPoint f = tree.repulsion(positions, i, k2, theta);
+                const GraphPoint& p = positions[i];
+                for (uint32_t e = adjacencyOffsets[i]; e < adjacencyOffsets[i + 1]; ++e) {
+                    const GraphPoint& q = positions[adjacency[e]];
+                    float dx = q.x - p.x;
+                    float dy = q.y - p.y;
+                    float d = std::sqrt(dx * dx + dy * dy);
+                    f.x += dx * d / springLength;
+                    f.y += dy * d / springLength;
+                }
+                f.x -= p.x * gravity;
+                f.y -= p.y * gravity;
+                displacement[i] = f;
+            }
+        });
+
+        pool.parallel_for(ids.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const GraphPoint& f = displacement[i];
+                float length = std::sqrt(f.x * f.x + f.y * f.y);
+                if (length < 1e-6f) continue;
+                float scale = std::min(length, max_move) / length;
+                positions[i].x += f.x * scale;
+                positions[i].y += f.y * scale;
+            }
+        });
+
+        temperature *= cooling;
+        ++iteration;
+    }
+
+    void publish() {
+        GraphFrame& frame = frames[back];
+        if (frame.topology != topology) {
+            frame.ids = ids;
+            frame.edges = edges;
+            frame.adjacencyOffsets = adjacencyOffsets;
+            frame.adjacency = adjacency;
+            frame.topology = topology;
+        }
+        frame.positions = positions;
+        frame.tree.build(frame.positions);
+        frame.iteration = iteration;
+        frame.temperature = temperature;
+
+        {
+            std::lock_guard<std::mutex> lock(swapMtx);
+            std::swap(back, middle);
+            fresh = true;
+        }
+        if (auto hook = wakeup.load(std::memory_order_acquire)) hook();
+    }
+
+    // Function that loops in the layout thread
+    void run() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this] {
+                    return done || (active.load() && (dirty || temperature > minTemperature));
+                });
+                if (done) return;
+                if (dirty) {
+                    dirty = false;
+                    lock.unlock();
+                    rebuild();
+                }
+            }
+            step();
+            publish();
+        }
+    }
+};
@@ -2,54 +2,70 @@
 #include "options.h"
 #include "parser.h"
 #include "renderer.hpp"
+#include "graph_layout.hpp"
 #include "renderer_ctx.hpp"
+#include "search.hpp"
 #include "viewstate.hpp"
 
+#include <shared_mutex>
+
 using namespace note;
 
 class NoteAppUI {
 private:
     Options opts_;
     NoteStore store;
+    // background readers (search, graph) share the store, writes on this thread are exclusive
+    std::shared_mutex storeMtx;
     ViewState view;
     ImguiRenderer renderer;
     EventQueue events;
+    SearchWorker search{store, storeMtx, events};
+    SearchSnapshot searchResults;
+    GraphLayout graph{store, storeMtx};
     bool isRunning{false};
 public:
     NoteAppUI(Options opts) : opts_(std::move(opts)),
                               store(NoteStore(opts_.storage_path)) {
         LOG_DEBUG() << "initializing NoteAppUI";
         const auto kids = store.getKids("default");
-        view.addFromKids(kids, store);
+        view.addFromKids(kids);
     }
 
     int run() {
         isRunning = true;
         if (renderer.setup(opts_.app_name) != 0) return -1;
+        events.setWakeup(&ImguiRenderer::wake);
+        graph.setWakeup(&ImguiRenderer::wake);
 
         while (isRunning) {
             // - render a frame
-            isRunning = renderer.render(RenderCtx{store, view, events});
+            isRunning = renderer.render(RenderCtx{store, view, events, graph});
+            graph.setActive(view.getGraph().show);
             // - process events in event queue
             Event e;
             while (events.try_pop(e)) {
                 switch (e.type) {
                     case EventType::MoveUp: {
-                        view.moveUp(e.id);
+                        for (uint32_t i = 0; i < e.repeat; ++i) view.moveUp(e.id);
                         break;
                     }
                     case EventType::MoveDown: {
-                        view.moveDown(e.id);
+                        for (uint32_t i = 0; i < e.repeat; ++i) view.moveDown(e.id);
                         break;
                     }
                     case EventType::BeginEdit: {
-                        view.startEdit(e.id, store.getNoteStrings(e.id));
+                        view.startEdit(e.id, store.getNoteView(e.id));
                         break;
                     }
                     case EventType::SubmitEdit: {
-                        auto note = store.getNoteStrings(e.id);
+                        // every field comes from the edit, nothing from the store
+                        NoteDataStrings note;
                         view.copyFromEdit(note);
+                        std::unique_lock<std::shared_mutex> lock(storeMtx);
                         store.updateNote(e.id, note.title, note.content, note.tags, note.kids);
+                        lock.unlock();
+                        graph.markDirty();
                         view.stopEdit(e.id);
                         break;
                     }
@@ -60,10 +76,34 @@ public:
                     case EventType::OpenId: {
                         if (e.insertAfter.has_value())
                             view.addId(e.id, *e.insertAfter);
+                        else
+                            view.addId(e.id);
+                        break;
+                    }
+                    case EventType::CloseId: {
+                        view.removeId(e.id);
+                        renderer.forgetNote(e.id);
+                        break;
+                    }
+                    case EventType::SearchQuery: {
+                        auto& state = view.getSearch();
+                        state.searching = !state.query.empty();
+                        search.submit(state.query);
+                        break;
+                    }
+                    case EventType::SearchResults: {
+                        if (!search.latest(searchResults)) break;
+                        auto& state = view.getSearch();
+                        state.results.clear();
+                        for (const auto& hit : searchResults.hits) state.results.emplace_back(hit.id);
+                        state.scanned = searchResults.scanned;
+                        state.searching = !searchResults.complete;
                         break;
                     }
                 }
             }
+            // the queue belongs to the frame that was just drawn
+            renderer.timings().lap(FramePhase::Input);
         }
         store.save_json_file(opts_.storage_path);
         return renderer.tearDown();
@@ -1,6 +1,7 @@
 #include "imgui_viewer.hpp"
 #include "logger.h"
 #include "options.h"
+#include "trace.h"
 
 int main(int argc, char* argv[]) {
     auto parsed = parse_options(argc, argv);
@@ -11,9 +12,27 @@ int main(int argc, char* argv[]) {
 
     Logger& log = Logger::getInstance();
     if (parsed.value->verbose) log.setLogLevel(LogLevel::INFO);
+    if (!parsed.value->flight_recorder.empty()) {
+        if (!log.enableFlightRecorder(parsed.value->flight_recorder)) {
+            LOG_ERROR() << "could not open flight recorder: " << parsed.value->flight_recorder;
+        }
+    }
+    log.installCrashHandlers();
+    if (!parsed.value->trace.empty()) {
+        Tracer::instance().setThreadName("ui");
+        Tracer::instance().enable();
+    }
 
     NoteAppUI viewer(*parsed.value);
 
     LOG_INFO() << "Starting ui";
-    return viewer.run();
+    int status = viewer.run();
+    if (!parsed.value->trace.empty()) {
+        if (!Tracer::instance().writeFile(parsed.value->trace)) {
+            LOG_ERROR() << "could not write trace: " << parsed.value->trace;
+        }
+        // the teardown after this would only record events nobody writes out
+        Tracer::instance().disable();
+    }
+    return status;
 }
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "markdown.h"
+#include "note.hpp"
+
+#include <unordered_map>
+
+using namespace note;
+
+/**
+ * Parsed Markdown of the rendered notes.
+ * * A note is re-parsed when its 'modified' version changed, blocks that weren't
+ *   edited are moved over from the old tree instead of being parsed again.
+ * * [[links]] are resolved to NoteIds whenever the store version changed, so a
+ *   link starts working as soon as its target note exists.
+ * * An entry lives while its note is open, 'erase' it when the note closes.
+ */
+class MarkdownCache {
+private:
+    struct Entry {
+        uint64_t modified{UINT64_MAX};
+        uint64_t linksVersion{UINT64_MAX};
+        markdown::Document doc;
+    };
+    std::unordered_map<NoteId, Entry> entries;
+
+public:
+    markdown::Document& get(NoteId id, const NoteData& note, const NoteStore& store) {
+        Entry& entry = entries[id];
+        if (entry.modified != note.modified) {
+            entry.doc = markdown::parse(note.content, std::move(entry.doc));
+            entry.modified = note.modified;
+            entry.linksVersion = UINT64_MAX;
+            LOG_DEBUG() << "parsed markdown of: " << id << ", blocks: " << entry.doc.blocks.size()
+                        << ", reused: " << entry.doc.reusedBlocks;
+        }
+        if (entry.linksVersion != store.version()) {
+            for (auto& block : entry.doc.blocks) {
+                for (auto& span : block.spans) {
+                    if (span.type == markdown::SpanType::Link) span.target = store.findId(span.text);
+                }
+            }
+            entry.linksVersion = store.version();
+        }
+        return entry.doc;
+    }
+
+    void erase(NoteId id) { entries.erase(id); }
+};
@@ -0,0 +1,693 @@
+#pragma once
+
+#include "diagnostics.hpp"
+#include "events.hpp"
+#include "markdown_cache.hpp"
+#include "renderer_ctx.hpp"
+
+#include "imgui.h"
+#include "misc/cpp/imgui_stdlib.h"
+
+/**
+ * Draws the notes, search and graph windows into the current ImGui frame.
+ * Knows nothing about windows or GPUs: ImguiRenderer runs it in a GLFW window
+ * with OpenGL, benchmarks/bench_renderer.cpp against a null backend.
+ */
+class NoteRenderer {
+protected:
+    ImFont* font_regular{nullptr};
+    ImFont* font_title{nullptr};
+    ImVec2 contentEditSize {-FLT_MIN, 30};
+    // parsed note content
+    MarkdownCache markdown;
+    // tag and kid grids
+    static constexpr float gridCellWidth = 160.0f;
+    static constexpr size_t gridPageSize = 1000;
+    static constexpr int gridMaxRows = 6;
+    static constexpr const char* sortLabels[] = {"order: stored", "order: title", "order: recent"};
+    // graph: the nodes inside the canvas this frame, and a mark per node for them
+    std::vector<uint32_t> graphNodes;
+    std::vector<uint8_t> graphShown;
+    // diagnostics: phase times of the last frames
+    FrameTimings frameTimings;
+    static constexpr ImU32 phaseColors[FrameTimings::phases] = {
+        IM_COL32(120, 120, 140, 255), IM_COL32(90, 170, 255, 255), IM_COL32(150, 220, 120, 255),
+        IM_COL32(240, 200, 80, 255), IM_COL32(230, 110, 90, 255),
+    };
+public:
+    /**
+     * Fonts of the note text and of the titles, from the current font atlas.
+     */
+    void setFonts(ImFont* regular, ImFont* title) {
+        font_regular = regular;
+        font_title = title;
+    }
+
+    /**
+     * Phase times of the last frames, the owner of the frame loop begins the
+     * frames and adds the phases outside of 'renderFrame'.
+     */
+    FrameTimings& timings() noexcept { return frameTimings; }
+
+    /**
+     * Drops what is cached for a note that was closed.
+     */
+    void forgetNote(NoteId id) { markdown.erase(id); }
+
+    /**
+     * Everything drawn in one frame, between ImGui::NewFrame and ImGui::Render.
+     */
+    void renderFrame(const RenderCtx& ctx) {
+        renderMenuBar(ctx);
+        frameTimings.lap(FramePhase::Tools);
+        renderNotes(ctx);
+        frameTimings.lap(FramePhase::Notes);
+        renderSearch(ctx);
+        renderGraph(ctx);
+        renderDiagnostics(ctx);
+        frameTimings.lap(FramePhase::Tools);
+    }
+
+    /**
+     * Draws a inputText for a given string in edit mode.
+     * 'label' is a '##' label: no visible text, the note id is already on the ID stack.
+     */
+    void editText(std::string& editedText, const NoteId& id, const char* label, const RenderCtx& ctx) {
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x); // or a fixed width you like
+        bool submitted = ImGui::InputText(
+            label,
+            &editedText,
+            ImGuiInputTextFlags_EnterReturnsTrue);
+
+        // Commit on Enter:
+        if (submitted) {
+            // add Action to action queue
+            ctx.events.push({EventType::SubmitEdit, id});
+        }
+        // Optional cancel with Esc:
+        else if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            ctx.events.push({EventType::CancelEdit, id});
+        }
+    }
+
+    void editMultilineText(std::string& editedText, NoteId id, const RenderCtx& ctx) {
+        // size of the input text block
+        const char* text_begin = editedText.data();
+        ImVec2 text_size = ImGui::CalcTextSize(text_begin, text_begin + editedText.size(), false);
+        ImVec2 size = ImVec2(contentEditSize.x, text_size.y + contentEditSize.y);
+
+        ImGuiInputTextFlags flags = ImGuiInputTextFlags_AllowTabInput |
+                                    ImGuiInputTextFlags_WordWrap | 
+                                    ImGuiInputTextFlags_NoHorizontalScroll |
+                                    ImGuiInputTextFlags_EnterReturnsTrue;
+        bool submitted = ImGui::InputTextMultiline("##content", &editedText, size, flags);
+
+        // Commit on Enter:
+        if (submitted) {
+            ctx.events.push({EventType::SubmitEdit, id});
+        }
+        // Optional cancel with Esc:
+        else if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            ctx.events.push({EventType::CancelEdit, id});
+        }
+    }
+
+    /**
+     * Draws 'ids' as a wrapping grid of fixed width buttons.
+     * Only the rows inside the grid's scroll area are submitted, and lists longer
+     * than 'gridPageSize' are split into pages.
+     */
+    void renderIdGrid(const char* label, const std::vector<NoteId>& ids, uint32_t& page,
+                      NoteId owner, const RenderCtx& ctx) {
+        if (ids.empty()) return;
+        const size_t pages = (ids.size() + gridPageSize - 1) / gridPageSize;
+        if (page >= pages) page = static_cast<uint32_t>(pages - 1);
+        const size_t first = static_cast<size_t>(page) * gridPageSize;
+        const size_t count = std::min(gridPageSize, ids.size() - first);
+
+        const ImGuiStyle& style = ImGui::GetStyle();
+        const float width = ImGui::GetContentRegionAvail().x - style.ScrollbarSize;
+        const int columns = std::max(1, static_cast<int>((width + style.ItemSpacing.x) /
+                                                         (gridCellWidth + style.ItemSpacing.x)));
+        const int rows = static_cast<int>((count + columns - 1) / columns);
+        const float row_height = ImGui::GetFrameHeightWithSpacing();
+
+        ImGui::PushID(label);
+        if (pages > 1) {
+            if (ImGui::SmallButton("<") && page > 0) --page;
+            ImGui::SameLine();
+            ImGui::Text("page %u / %zu", page + 1, pages);
+            ImGui::SameLine();
+            if (ImGui::SmallButton(">") && page + 1 < pages) ++page;
+        }
+
+        // the grid scrolls once it's taller than 'gridMaxRows'
+        ImGui::BeginChild("grid", ImVec2(0, std::min(rows, gridMaxRows) * row_height));
+        ImGuiListClipper clipper;
+        clipper.Begin(rows, row_height);
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                for (int col = 0; col < columns; ++col) {
+                    size_t i = first + static_cast<size_t>(row) * columns + col;
+                    if (i >= first + count) break;
+                    NoteId id = ids[i];
+                    const NoteData* note = ctx.store.findNote(id);
+                    if (!note) continue;
+                    if (col > 0) ImGui::SameLine();
+                    ImGui::PushID(static_cast<int>(id));
+                    if (ImGui::Button(note->title.c_str(), ImVec2(gridCellWidth, 0))) {
+                        LOG_DEBUG() << "clicked on " << label << ": " << id;
+                        ctx.events.push({EventType::OpenId, id, owner});
+                    }
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", note->title.c_str());
+                    ImGui::PopID();
+                }
+            }
+        }
+        ImGui::EndChild();
+        ImGui::PopID();
+    }
+
+    static ImU32 spanColor(const markdown::Span& span) {
+        switch (span.type) {
+            case markdown::SpanType::Code: return IM_COL32(230, 160, 90, 255);
+            case markdown::SpanType::Emphasis: return IM_COL32(170, 200, 255, 255);
+            case markdown::SpanType::Strong: return IM_COL32(255, 255, 255, 255);
+            case markdown::SpanType::Link:
+                return span.target ? IM_COL32(90, 170, 255, 255) : IM_COL32(150, 150, 150, 255);
+            default: return ImGui::GetColorU32(ImGuiCol_Text);
+        }
+    }
+
+    /**
+     * Draws inline spans with word wrapping. Plain text goes to ImGui in one piece,
+     * mixed spans are laid out word by word so links stay clickable.
+     */
+    void renderSpans(const std::vector<markdown::Span>& spans, NoteId owner, const RenderCtx& ctx) {
+        if (spans.size() == 1 && spans[0].type == markdown::SpanType::Text) {
+            const std::string& text = spans[0].text;
+            ImGui::PushTextWrapPos(0.0f);
+            ImGui::TextUnformatted(text.data(), text.data() + text.size());
+            ImGui::PopTextWrapPos();
+            return;
+        }
+
+        const float wrap = ImGui::GetContentRegionAvail().x;
+        const float space = ImGui::CalcTextSize(" ").x;
+        float x = 0.0f;
+        bool first = true;
+        bool gap = false;   // whitespace since the last word
+        for (const auto& span : spans) {
+            std::string_view shown = span.shown();
+            const char* p = shown.data();
+            const char* end = p + shown.size();
+            while (p < end) {
+                if (*p == ' ') {
+                    gap = true;
+                    ++p;
+                    continue;
+                }
+                const char* word_end = p;
+                while (word_end < end && *word_end != ' ') ++word_end;
+                float width = ImGui::CalcTextSize(p, word_end).x;
+                if (!first) {
+                    float spacing = gap ? space : 0.0f;
+                    if (x + spacing + width <= wrap) {
+                        ImGui::SameLine(0.0f, spacing);
+                        x += spacing;
+                    } else {
+                        x = 0.0f;
+                    }
+                }
+                ImGui::PushStyleColor(ImGuiCol_Text, spanColor(span));
+                ImGui::TextUnformatted(p, word_end);
+                ImGui::PopStyleColor();
+                if (span.type == markdown::SpanType::Link && span.target != 0) {
+                    if (ImGui::IsItemHovered()) {
+                        ImVec2 min = ImGui::GetItemRectMin();
+                        ImVec2 max = ImGui::GetItemRectMax();
+                        ImGui::GetWindowDrawList()->AddLine(ImVec2(min.x, max.y), max, spanColor(span));
+                    }
+                    if (ImGui::IsItemClicked()) {
+                        LOG_DEBUG() << "clicked on link: " << span.target;
+                        ctx.events.push({EventType::OpenId, span.target, owner});
+                    }
+                }
+                x += width;
+                first = false;
+                gap = false;
+                p = word_end;
+            }
+        }
+    }
+
+    void renderBlock(const markdown::Block& block, NoteId owner, const RenderCtx& ctx) {
+        using markdown::BlockType;
+        const float indent = ImGui::GetFontSize();
+        switch (block.type) {
+            case BlockType::Heading:
+                if (block.level <= 2) ImGui::PushFont(font_title);
+                renderSpans(block.spans, owner, ctx);
+                if (block.level <= 2) ImGui::PopFont();
+                break;
+            case BlockType::ListItem:
+                if (block.level > 0) ImGui::Indent(indent * block.level);
+                if (block.number > 0) {
+                    ImGui::Text("%u.", block.number);
+                    ImGui::SameLine();
+                } else {
+                    ImGui::Bullet();
+                }
+                renderSpans(block.spans, owner, ctx);
+                if (block.level > 0) ImGui::Unindent(indent * block.level);
+                break;
+            case BlockType::CodeBlock:
+                ImGui::Indent(indent);
+                ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(230, 160, 90, 255));
+                ImGui::TextUnformatted(block.code.data(), block.code.data() + block.code.size());
+                ImGui::PopStyleColor();
+                ImGui::Unindent(indent);
+                break;
+            case BlockType::Quote:
+                ImGui::Indent(indent);
+                ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetColorU32(ImGuiCol_TextDisabled));
+                renderSpans(block.spans, owner, ctx);
+                ImGui::PopStyleColor();
+                ImGui::Unindent(indent);
+                break;
+            case BlockType::Rule:
+                ImGui::Separator();
+                break;
+            case BlockType::Paragraph:
+                renderSpans(block.spans, owner, ctx);
+                break;
+        }
+    }
+
+    /**
+     * Walks the cached Markdown tree of a note. Blocks that were measured at the
+     * current width and are scrolled out of view only reserve their height.
+     */
+    void renderMarkdown(markdown::Document& doc, NoteId owner, const RenderCtx& ctx) {
+        const float width = ImGui::GetContentRegionAvail().x;
+        for (auto& block : doc.blocks) {
+            if (block.layoutWidth == width && !ImGui::IsRectVisible(ImVec2(width, block.layoutHeight))) {
+                ImGui::Dummy(ImVec2(width, block.layoutHeight));
+                continue;
+            }
+            ImGui::BeginGroup();
+            renderBlock(block, owner, ctx);
+            ImGui::EndGroup();
+            block.layoutWidth = width;
+            block.layoutHeight = ImGui::GetItemRectSize().y;
+        }
+    }
+
+    void displayNormalNote(const NoteData& note, NoteId id, const RenderCtx& ctx) {
+        // title
+        ImGui::PushFont(font_title);
+        ImGui::TextUnformatted(note.title.c_str());
+        if (!ctx.view.getEditMode() && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0)) {
+            LOG_INFO() << "double clicked on title: " << note.title;
+            ctx.events.push({EventType::BeginEdit, id});
+
+        }
+        ImGui::PopFont();
+        ImGui::SameLine();
+
+        // move note up
+        if (ImGui::Button("↑"))
+            ctx.events.push({EventType::MoveUp, id});
+
+        ImGui::SameLine();
+        // move note down
+        if (ImGui::Button("↓"))
+            ctx.events.push({EventType::MoveDown, id});
+
+        ImGui::SameLine();
+        // close note
+        if (ImGui::Button("x"))
+            ctx.events.push({EventType::CloseId, id});
+
+        // tags
+        auto& lists = ctx.view.getLists(id);
+        ImGui::Text("Tags: "); ImGui::SameLine();
+        if (ImGui::SmallButton(sortLabels[static_cast<int>(lists.sort)])) {
+            lists.sort = static_cast<ListSort>((static_cast<int>(lists.sort) + 1) % 3);
+        }
+        renderIdGrid("tags", ctx.view.sorted(lists.tags, note.tags, note.modified, lists.sort, ctx.store),
+                     lists.tagPage, id, ctx);
+        ImGui::Spacing();
+
+        // content
+        ImGuiWindowFlags window_flags = ImGuiWindowFlags_None;
+        ImGui::BeginChild("ChildR", ImVec2(0, 0), ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_Borders, window_flags);
+        renderMarkdown(markdown.get(id, note, ctx.store), id, ctx);
+        if (!ctx.view.getEditMode() && ImGui::IsWindowHovered() && ImGui::IsMouseDoubleClicked(0)) {
+            LOG_INFO() << "double clicked on content: " << note.title;
+            ctx.events.push({EventType::BeginEdit, id});
+        }
+        ImGui::EndChild();
+
+        // children
+        ImGui::Text("Tagged in: %zu", note.kids.size());
+        renderIdGrid("kids", ctx.view.sorted(lists.kids, note.kids, note.modified, lists.sort, ctx.store),
+                     lists.kidPage, id, ctx);
+    }
+
+    void displayEditedNote(const NoteId& id, const RenderCtx& ctx) {
+        // title + move controls
+        ImGui::PushFont(font_title);
+        editText(ctx.view.getEditNote().title, id, "##title", ctx);
+        ImGui::PopFont();
+
+        // Tags line
+        ImGui::Text("Tags: "); ImGui::SameLine();
+        editText(ctx.view.getEditNote().tags, id, "##tags", ctx);
+        ImGui::Spacing();
+
+        // content
+        editMultilineText(ctx.view.getEditNote().content, id, ctx);
+
+        // children
+        ImGui::Text("Tagged in: ");
+        editText(ctx.view.getEditNote().kids, id, "##children", ctx);
+    }
+
+    void renderNotes(const RenderCtx& ctx) {
+        ImGui::Begin("NoteWiki");
+
+        for (const auto& note_view : ctx.view.view()) {
+            const auto& note = ctx.store.getNote(note_view.id);
+            // integer id on the ID stack, the child itself gets a fixed name
+            ImGui::PushID(static_cast<int>(note_view.id));
+            ImGui::BeginChild("note", ImVec2(0, 0), ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_Border);
+
+            if (note_view.edit) displayEditedNote(note_view.id, ctx);
+            else displayNormalNote(note, note_view.id, ctx);
+
+            ImGui::EndChild();
+            ImGui::PopID();
+        }
+
+        ImGui::End();
+    }
+
+    /**
+     * Menu bar to toggle the tool windows.
+     */
+    void renderMenuBar(const RenderCtx& ctx) {
+        if (!ImGui::BeginMainMenuBar()) return;
+        if (ImGui::BeginMenu("View")) {
+            ImGui::MenuItem("Search", nullptr, &ctx.view.getSearch().show);
+            ImGui::MenuItem("Graph", nullptr, &ctx.view.getGraph().show);
+            ImGui::MenuItem("Diagnostics", nullptr, &ctx.view.getDiagnostics().show);
+            ImGui::EndMenu();
+        }
+        ImGui::EndMainMenuBar();
+    }
+
+    /**
+     * Search panel, every edit of the query starts a new background search.
+     * Results open through the same 'OpenId' event as tag buttons.
+     */
+    void renderSearch(const RenderCtx& ctx) {
+        auto& search = ctx.view.getSearch();
+        if (!search.show) return;
+
+        ImGui::SetNextWindowSize(ImVec2(400, 500), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Search", &search.show)) {
+            ImGui::End();
+            return;
+        }
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::InputTextWithHint("##query", "search titles and content", &search.query)) {
+            ctx.events.push({EventType::SearchQuery});
+        }
+        if (search.searching)
+            ImGui::TextDisabled("searching... %zu notes scanned", search.scanned);
+        else
+            ImGui::TextDisabled("%zu results", search.results.size());
+
+        ImGui::BeginChild("results");
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(search.results.size()));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                NoteId id = search.results[i];
+                const NoteData* note = ctx.store.findNote(id);
+                if (!note) continue;
+                ImGui::PushID(static_cast<int>(id));
+                if (ImGui::Selectable(note->title.c_str())) {
+                    ctx.events.push({EventType::OpenId, id});
+                }
+                ImGui::PopID();
+            }
+        }
+        ImGui::EndChild();
+        ImGui::End();
+    }
+
+    /**
+     * Graph window: draws the latest published layout, culled to the canvas.
+     * Drag to pan, mouse wheel to zoom, click a node to open it.
+     */
+    void renderGraph(const RenderCtx& ctx) {
+        auto& state = ctx.view.getGraph();
+        if (!state.show) return;
+
+        ImGui::SetNextWindowSize(ImVec2(700, 600), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Graph", &state.show)) {
+            ImGui::End();
+            return;
+        }
+        const GraphFrame& frame = ctx.graph.acquire();
+        bool fit = ImGui::Button("Fit");
+        ImGui::SameLine();
+        ImGui::TextDisabled("%zu notes, %zu edges, step %llu", frame.ids.size(), frame.edges.size(),
+                            static_cast<unsigned long long>(frame.iteration));
+
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImVec2 size = ImGui::GetContentRegionAvail();
+        if (size.x < 50.0f || size.y < 50.0f) {
+            ImGui::End();
+            return;
+        }
+        ImGui::InvisibleButton("canvas", size, ImGuiButtonFlags_MouseButtonLeft);
+        const bool hovered = ImGui::IsItemHovered();
+        const ImGuiIO& io = ImGui::GetIO();
+
+        if (fit && !frame.positions.empty()) {
+            float min_x = frame.positions[0].x, max_x = min_x;
+            float min_y = frame.positions[0].y, max_y = min_y;
+            for (const auto& p : frame.positions) {
+                min_x = std::min(min_x, p.x); max_x = std::max(max_x, p.x);
+                min_y = std::min(min_y, p.y); max_y = std::max(max_y, p.y);
+            }
+            state.panX = (min_x + max_x) * 0.5f;
+            state.panY = (min_y + max_y) * 0.5f;
+            state.zoom = std::min(size.x / (max_x - min_x + 1.0f), size.y / (max_y - min_y + 1.0f)) * 0.9f;
+        }
+        if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
+            state.panX -= io.MouseDelta.x / state.zoom;
+            state.panY -= io.MouseDelta.y / state.zoom;
+        }
+        if (hovered && io.MouseWheel != 0.0f) {
+            state.zoom = std::clamp(state.zoom * (io.MouseWheel > 0 ? 1.2f : 1.0f / 1.2f), 0.001f, 20.0f);
+        }
+
+        const ImVec2 center(origin.x + size.x * 0.5f, origin.y + size.y * 0.5f);
+        const ImVec2 corner(origin.x + size.x, origin.y + size.y);
+        auto toScreen = [&](const GraphPoint& p) {
+            return ImVec2(center.x + (p.x - state.panX) * state.zoom,
+                          center.y + (p.y - state.panY) * state.zoom);
+        };
+        auto outside = [&](const ImVec2& p) {
+            return p.x < origin.x || p.y < origin.y || p.x > corner.x || p.y > corner.y;
+        };
+
+        ImDrawList* draw = ImGui::GetWindowDrawList();
+        draw->PushClipRect(origin, corner, true);
+        draw->AddRectFilled(origin, corner, IM_COL32(20, 20, 24, 255));
+
+        // a frame may be published mid topology change on the first frames
+        const size_t count = std::min(frame.ids.size(), frame.positions.size());
+        // the nodes inside the canvas, from the layout's quadtree
+        graphNodes.clear();
+        graphShown.resize(count);
+        const float half_w = size.x * 0.5f / state.zoom, half_h = size.y * 0.5f / state.zoom;
+        frame.tree.query(frame.positions, state.panX - half_w, state.panY - half_h,
+                         state.panX + half_w, state.panY + half_h, [&](uint32_t i) {
+            if (i >= count) return;
+            graphNodes.push_back(i);
+            graphShown[i] = 1;
+        });
+
+        const ImU32 edge_color = IM_COL32(120, 120, 140, 90);
+        auto drawEdge = [&](uint32_t a, uint32_t b) {
+            ImVec2 p = toScreen(frame.positions[a]);
+            ImVec2 q = toScreen(frame.positions[b]);
+            // both ends beyond the same side: the line can't cross the canvas
+            if ((p.x < origin.x && q.x < origin.x) || (p.x > corner.x && q.x > corner.x) ||
+                (p.y < origin.y && q.y < origin.y) || (p.y > corner.y && q.y > corner.y)) return;
+            draw->AddLine(p, q, edge_color);
+        };
+        const bool adjacent = frame.adjacencyOffsets.size() == count + 1;
+        if (!adjacent || graphNodes.size() * 2 > count) {
+            // most of the graph is in view, every edge
+            for (const auto& [a, b] : frame.edges) {
+                if (a < count && b < count) drawEdge(a, b);
+            }
+        } else {
+            // zoomed in: the edges of the nodes in view, once each. Edges passing
+            // through with both ends out of view are left out.
+            for (uint32_t a : graphNodes) {
+                for (uint32_t e = frame.adjacencyOffsets[a]; e < frame.adjacencyOffsets[a + 1]; ++e) {
+                    uint32_t b = frame.adjacency[e];
+                    if (b < count && (!graphShown[b] || a < b)) drawEdge(a, b);
+                }
+            }
+        }
+
+        const float radius = std::clamp(3.0f * state.zoom, 1.5f, 8.0f);
+        const bool labels = state.zoom > 0.5f;
+        const ImVec2 mouse = io.MousePos;
+        float best = (radius + 4.0f) * (radius + 4.0f);
+        size_t hoveredNode = count;
+        for (uint32_t i : graphNodes) {
+            graphShown[i] = 0;
+            ImVec2 p = toScreen(frame.positions[i]);
+            if (outside(p)) continue;
+            bool open = ctx.view.isVisible(frame.ids[i]);
+            draw->AddRectFilled(ImVec2(p.x - radius, p.y - radius), ImVec2(p.x + radius, p.y + radius),
+                                open ? IM_COL32(240, 200, 80, 255) : IM_COL32(110, 170, 240, 255));
+            if (labels) {
+                if (const NoteData* note = ctx.store.findNote(frame.ids[i]))
+                    draw->AddText(ImVec2(p.x + radius + 2.0f, p.y - radius), IM_COL32(220, 220, 220, 255),
+                                  note->title.data(), note->title.data() + note->title.size());
+            }
+            float dx = p.x - mouse.x, dy = p.y - mouse.y;
+            if (hovered && dx * dx + dy * dy < best) {
+                best = dx * dx + dy * dy;
+                hoveredNode = i;
+            }
+        }
+        draw->PopClipRect();
+
+        if (hoveredNode < count) {
+            if (const NoteData* note = ctx.store.findNote(frame.ids[hoveredNode])) {
+                ImGui::SetTooltip("%s", note->title.c_str());
+            }
+            if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+                ctx.events.push({EventType::OpenId, frame.ids[hoveredNode]});
+            }
+        }
+        ImGui::End();
+    }
+
+    /**
+     * Diagnostics window: the phase times of the last frames as stacked bars,
+     * the memory held by the store and the view, the store's last load and save durations.
+     */
+    void renderDiagnostics(const RenderCtx& ctx) {
+        auto& state = ctx.view.getDiagnostics();
+        if (!state.show) return;
+
+        ImGui::SetNextWindowSize(ImVec2(460, 560), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Diagnostics", &state.show)) {
+            ImGui::End();
+            return;
+        }
+
+        // the current frame is still being timed, start from the one before
+        const size_t frames = frameTimings.size() > 1 ? frameTimings.size() - 1 : 0;
+        FrameTimings::Frame sum{};
+        FrameTimings::Frame worst{};
+        float worst_total = 0.0f;
+        float all_total = 0.0f;
+        for (size_t age = 1; age <= frames; ++age) {
+            const auto& frame = frameTimings.frame(age);
+            const float total = FrameTimings::total(frame);
+            for (size_t p = 0; p < FrameTimings::phases; ++p) sum[p] += frame[p];
+            all_total += total;
+            if (total > worst_total) {
+                worst_total = total;
+                worst = frame;
+            }
+        }
+        const float average = frames ? 1.0f / static_cast<float>(frames) : 0.0f;
+        ImGui::Text("frame: %.2f ms average, %.2f ms worst, last %zu frames",
+                    all_total * average / 1000.0f, worst_total / 1000.0f, frames);
+        if (ImGui::BeginTable("phases", 3, ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("phase");
+            ImGui::TableSetupColumn("average ms");
+            ImGui::TableSetupColumn("in worst ms");
+            ImGui::TableHeadersRow();
+            for (size_t p = 0; p < FrameTimings::phases; ++p) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(phaseColors[p]), "%s", FrameTimings::phaseNames[p]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", sum[p] * average / 1000.0f);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", worst[p] / 1000.0f);
+            }
+            ImGui::EndTable();
+        }
+
+        // one stacked bar per frame, newest on the right, scaled to the worst frame or 60 fps
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const ImVec2 size(ImGui::GetContentRegionAvail().x, 100.0f);
+        ImGui::Dummy(size);
+        ImDrawList* draw = ImGui::GetWindowDrawList();
+        draw->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), IM_COL32(20, 20, 24, 255));
+        const float scale = size.y / std::max(worst_total, 16667.0f);
+        const float bar = size.x / static_cast<float>(FrameTimings::frames);
+        const float bottom = origin.y + size.y;
+        for (size_t age = 1; age <= frames; ++age) {
+            const auto& frame = frameTimings.frame(age);
+            const float x = origin.x + size.x - static_cast<float>(age) * bar;
+            float y = bottom;
+            for (size_t p = 0; p < FrameTimings::phases; ++p) {
+                const float height = frame[p] * scale;
+                if (height >= 0.5f) draw->AddRectFilled(ImVec2(x, y - height), ImVec2(x + bar, y), phaseColors[p]);
+                y -= height;
+            }
+        }
+        const float budget_y = bottom - 16667.0f * scale;
+        draw->AddLine(ImVec2(origin.x, budget_y), ImVec2(origin.x + size.x, budget_y), IM_COL32(255, 255, 255, 90));
+
+        ImGui::Separator();
+        // running totals of the store and the view, cheap enough for every frame
+        const MemoryStats store = ctx.store.memoryStats();
+        const ViewMemoryStats view = ctx.view.memoryStats();
+        ImGui::Text("notes: %zu (%zu placeholders), edges: %zu", store.notes, store.placeholders, store.edges);
+        ImGui::Text("open notes: %zu, list states: %zu", view.visible, view.listStates);
+        if (ImGui::BeginTable("memory", 2, ImGuiTableFlags_SizingFixedFit)) {
+            const std::pair<const char*, size_t> rows[] = {
+                {"titles", store.titleBytes}, {"contents", store.contentBytes},
+                {"title index", store.indexBytes}, {"tag and kid lists", store.listBytes},
+                {"hash tables", store.tableBytes}, {"slack", store.slackBytes},
+                {"store total", store.totalBytes()},
+                {"view: open notes", view.visibleBytes}, {"view: edit", view.editBytes},
+                {"view: search", view.searchBytes}, {"view: sorted lists", view.sortedBytes + view.tableBytes},
+                {"view: slack", view.slackBytes}, {"view total", view.totalBytes()},
+            };
+            for (const auto& [name, bytes] : rows) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f KiB", static_cast<double>(bytes) / 1024.0);
+            }
+            ImGui::EndTable();
+        }
+        using ms = std::chrono::duration<double, std::milli>;
+        ImGui::Text("last load: %.1f ms", ms(ctx.store.lastLoadDuration()).count());
+        if (ctx.store.lastSaveDuration().count() > 0)
+            ImGui::Text("last save: %.1f ms", ms(ctx.store.lastSaveDuration()).count());
+        else
+            ImGui::TextDisabled("not saved yet");
+        ImGui::End();
+    }
+};
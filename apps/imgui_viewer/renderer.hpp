@@ -1,5 +1,8 @@
-#include "events.hpp"
-#include "renderer_ctx.hpp"
+#include "note_renderer.hpp"
+#ifdef DEBUGGING
+#include "alloc_counter.h"
+#include <cassert>
+#endif
 
 #include "imgui.h"
 #include "misc/cpp/imgui_stdlib.h"
@@ -8,13 +11,75 @@
 #include <GLFW/glfw3.h>
 
 
-class ImguiRenderer {
+/**
+ * The NoteRenderer in a GLFW window, drawn with OpenGL.
+ */
+class ImguiRenderer : public NoteRenderer {
 private:
     GLFWwindow* window{nullptr};
-    ImFont* font_regular;
-    ImFont* font_title;
-    ImVec2 contentEditSize {-FLT_MIN, 30};
+    // frames drawn since the last input or queued event, see 'waitForInput'
+    int quietFrames{0};
+    // frames kept polling after input, so ImGui settles hover and focus changes
+    static constexpr int activeFrames = 3;
+    // longest wait for window events, bounds how late a blinking cursor or a
+    // graph layout being computed gets redrawn
+    static constexpr double idleWaitSeconds = 0.5;
+
+    /**
+     * True if the current frame got any user input.
+     */
+    static bool frameHasInput() {
+        const ImGuiIO& io = ImGui::GetIO();
+        return !io.InputQueueCharacters.empty() ||
+               io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f ||
+               io.MouseWheel != 0.0f || io.MouseWheelH != 0.0f ||
+               ImGui::IsAnyMouseDown() || io.WantTextInput ||
+               ImGui::IsKeyPressed(ImGuiKey_Escape) || ImGui::IsKeyPressed(ImGuiKey_Enter);
+    }
+
+    /**
+     * Blocks until a window event, a 'wake' or the idle timeout once the UI has
+     * been quiet for a few frames, polls otherwise.
+     */
+    void waitForInput(const RenderCtx& ctx) {
+        if (quietFrames >= activeFrames && ctx.events.empty()) {
+            glfwWaitEventsTimeout(idleWaitSeconds);
+        } else {
+            glfwPollEvents();
+        }
+    }
+#ifdef DEBUGGING
+    // frames to skip before expecting ImGui's internal buffers to have grown to size
+    static constexpr int warmupFrames = 120;
+    int frameCount{0};
+    bool lastFrameHadInput{true};
+
+    /**
+     * A frame is steady when neither it nor the previous frame had any user input,
+     * so ImGui and the draw lists had no reason to grow.
+     */
+    bool isSteadyFrame(bool hasInput) {
+        bool steady = !hasInput && !lastFrameHadInput && ++frameCount > warmupFrames;
+        lastFrameHadInput = hasInput;
+        return steady;
+    }
+
+    /**
+     * The per-frame path must not touch the heap once the UI is idle.
+     */
+    void checkFrameAllocations(bool steady, size_t allocations) {
+        if (steady && allocations != 0) {
+            LOG_ERROR() << "steady-state frame made " << allocations << " heap allocations";
+        }
+        assert(!steady || allocations == 0);
+    }
+#endif
 public:
+    /**
+     * Wakes up the UI thread if it waits for window events, safe from any thread.
+     */
+    static void wake() { glfwPostEmptyEvent(); }
+
     /**
      * Setup for ImgUI: creates the window and sets up the fonts
      */
@@ -51,10 +116,9 @@ public:
             b.BuildRanges(&ranges);
         }
 
-        // regular text
-        font_regular = io.Fonts->AddFontFromFileTTF(font_name.c_str(), 20.0f, nullptr, ranges.Data);
-        // titles
-        font_title = io.Fonts->AddFontFromFileTTF(font_name.c_str(), 35.0f, nullptr, ranges.Data);
+        // regular text and titles
+        setFonts(io.Fonts->AddFontFromFileTTF(font_name.c_str(), 20.0f, nullptr, ranges.Data),
+                 io.Fonts->AddFontFromFileTTF(font_name.c_str(), 35.0f, nullptr, ranges.Data));
         // Build font atlas
         io.Fonts->Build();
         // set regular as default
@@ -80,163 +144,42 @@ public:
         return 0;
     }
 
-    /**
-     * Draws a inputText for a given string in edit mode.
-     */
-    void editText(std::string& editedText, const NoteId& id, const std::string& labelSuffix, RenderCtx& ctx) {
-        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x); // or a fixed width you like
-        std::string label = "##edit_" + std::to_string(id) + "_" + labelSuffix; // '##' = no visible label, keeps ID
-        bool submitted = ImGui::InputText(
-            label.c_str(),
-            &editedText,
-            ImGuiInputTextFlags_EnterReturnsTrue);
-
-        // Commit on Enter:
-        if (submitted) {
-            // add Action to action queue
-            ctx.events.push({EventType::SubmitEdit, id});
-        }
-        // Optional cancel with Esc:
-        else if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
-            ctx.events.push({EventType::CancelEdit, id});
-        }
-    }
-
-    void editMultilineText(std::string& editedText, NoteId id, RenderCtx ctx) {
-        // size of the input text block
-        ImVec2 text_size = ImGui::CalcTextSize(editedText.c_str(), nullptr, false);
-        ImVec2 size = ImVec2(contentEditSize.x, text_size.y + contentEditSize.y);
-
-        std::string label = "##edit_" + std::to_string(id) + "_content"; // '##' = no visible label, keeps ID
-        ImGuiInputTextFlags flags = ImGuiInputTextFlags_AllowTabInput |
-                                    ImGuiInputTextFlags_WordWrap | 
-                                    ImGuiInputTextFlags_NoHorizontalScroll |
-                                    ImGuiInputTextFlags_EnterReturnsTrue;
-        bool submitted = ImGui::InputTextMultiline(label.c_str(), &editedText, size, flags);
-
-        // Commit on Enter:
-        if (submitted) {
-            ctx.events.push({EventType::SubmitEdit, id});
-        }
-        // Optional cancel with Esc:
-        else if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
-            ctx.events.push({EventType::CancelEdit, id});
-        }
-    }
-
-    void displayNormalNote(const NoteData& note, NoteId id, const RenderCtx& ctx) {
-        // title
-        ImGui::PushFont(font_title);
-        ImGui::TextUnformatted(note.title.c_str());
-        if (!ctx.view.getEditMode() && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0)) {
-            LOG_INFO() << "double clicked on title: " << note.title;
-            ctx.events.push({EventType::BeginEdit, id});
-
-        }
-        ImGui::PopFont();
-        ImGui::SameLine();
-
-        // move note up
-        if (ImGui::Button("↑"))
-            ctx.events.push({EventType::MoveUp, id});
-
-        ImGui::SameLine();
-        // move note down
-        if (ImGui::Button("↓"))
-            ctx.events.push({EventType::MoveDown, id});
-
-        // tags
-        ImGui::Text("Tags: "); ImGui::SameLine();
-        for (const auto& tag : note.tags) {
-            const auto& note = ctx.store.getNote(tag);
-            if (ImGui::Button(note.title.c_str())) {
-                LOG_DEBUG() << "clicked on tag: " << tag;
-                ctx.events.push({EventType::OpenId, tag, id});
-            }
-            ImGui::SameLine();
-        }
-        ImGui::Spacing();
-
-        // content
-        ImGuiWindowFlags window_flags = ImGuiWindowFlags_None;
-        ImGui::BeginChild("ChildR", ImVec2(0, 0), ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_Borders, window_flags);
-        ImGui::TextWrapped("%s", note.content.c_str());  // a 'printf' style function
-        if (!ctx.view.getEditMode() && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0)) {
-            LOG_INFO() << "double clicked on content: " << note.title;
-            ctx.events.push({EventType::BeginEdit, id});
-        }
-        ImGui::EndChild();
-
-        // children
-        ImGui::Text("Tagged in: ");
-        for (const auto& kid : note.kids) {
-            const auto& note = ctx.store.getNote(kid);
-            if (ImGui::Button(note.title.c_str())) {
-                LOG_DEBUG() << "clicked on kid: " << kid;
-                ctx.events.push({EventType::OpenId, kid, id});
-            }
-            ImGui::SameLine();
-        }
-    }
-
-    void displayEditedNote(const NoteId& id, RenderCtx ctx) {
-        // title + move controls
-        ImGui::PushFont(font_title);
-        editText(ctx.view.getEditNote().title, id, "title", ctx);
-        ImGui::PopFont();
-
-        // Tags line
-        ImGui::Text("Tags: "); ImGui::SameLine();
-        editText(ctx.view.getEditNote().tags, id, "tags", ctx);
-        ImGui::Spacing();
-
-        // content
-        editMultilineText(ctx.view.getEditNote().content, id, ctx);
-
-        // children
-        ImGui::Text("Tagged in: ");
-        editText(ctx.view.getEditNote().kids, id, "children", ctx);
-    }
-
-    void renderNotes(const RenderCtx& ctx) {
-        ImGui::Begin("NoteWiki");
-
-        for (auto note_view : ctx.view.view()) {
-            const auto& note = ctx.store.getNote(note_view.id);
-            ImGui::PushID(note_view.id);
-            ImGui::BeginChild(note.title.c_str(), ImVec2(0, 0), ImGuiChildFlags_AutoResizeY | ImGuiChildFlags_Border);
-
-            if (note_view.edit) displayEditedNote(note_view.id, ctx);
-            else displayNormalNote(note, note_view.id, ctx);
-
-            ImGui::EndChild();
-            ImGui::PopID();
-        }
-
-        ImGui::End();
-    }
-
     int render(const RenderCtx& ctx) {
         // The active loop that is always running and re-rendering the UI
         if (glfwWindowShouldClose(window)) return false;
 
-        glfwPollEvents();
+        // idle time is not part of the frame, neither in the trace nor in the timings
+        waitForInput(ctx);
+        TRACE_SCOPE("frame");
+        frameTimings.beginFrame();
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
+        frameTimings.lap(FramePhase::Input);
+        bool hasInput = frameHasInput();
+        quietFrames = hasInput || !ctx.events.empty() ? 0 : quietFrames + 1;
+#ifdef DEBUGGING
+        bool steady = isSteadyFrame(hasInput);
+        alloc_counter::Scope frameAllocs;
+#endif
 
-        renderNotes(ctx);
+        renderFrame(ctx);
 
         // ImGui::ShowDemoWindow();
 
         ImGui::Render();
+#ifdef DEBUGGING
+        checkFrameAllocations(steady && ctx.events.empty(), frameAllocs.allocations());
+#endif
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
         glViewport(0, 0, display_w, display_h);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        frameTimings.lap(FramePhase::Render);
         glfwSwapBuffers(window);
+        frameTimings.lap(FramePhase::Swap);
 
         return true;
     }
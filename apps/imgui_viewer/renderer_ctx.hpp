@@ -2,15 +2,18 @@
 #include "note.hpp"
 #include "viewstate.hpp"
 #include "events.hpp"
+#include "graph_layout.hpp"
 
 /**
  * Object to send to the renderer so it can:
  * i) get the order of notes from 'view'
  * ii) get the notes from 'store'
  * iii) push events to the event queue.
+ * iv) get the latest graph layout.
  */
 struct RenderCtx {
     const NoteStore& store;
     ViewState& view;
     EventQueue&      events;
+    GraphLayout&     graph;
 };
\ No newline at end of file
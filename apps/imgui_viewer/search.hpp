@@ -0,0 +1,215 @@
+#pragma once
+
+#include "events.hpp"
+#include "note.hpp"
+
+#include <algorithm>          // for std::upper_bound, std::search
+#include <atomic>             // for std::atomic<>
+#include <condition_variable> // for std::condition_variable
+#include <functional>         // for std::boyer_moore_horspool_searcher
+#include <mutex>              // for std::mutex, std::lock_guard<>
+#include <shared_mutex>       // for std::shared_mutex, std::shared_lock<>
+#include <string>
+#include <thread>             // for std::thread
+#include <vector>
+
+using namespace note;
+
+/**
+ * A single ranked search match.
+ */
+struct SearchHit {
+    NoteId id;
+    int score;
+    size_t title_length;
+
+    // best first: higher score, then shorter title, then older note
+    bool operator<(const SearchHit& other) const {
+        if (score != other.score) return score > other.score;
+        if (title_length != other.title_length) return title_length < other.title_length;
+        return id < other.id;
+    }
+};
+
+/**
+ * The latest results of the search worker, replaced as a query progresses.
+ */
+struct SearchSnapshot {
+    uint64_t generation{0};
+    std::vector<SearchHit> hits;
+    size_t scanned{0};
+    bool complete{true};
+};
+
+/**
+ * Runs title and content searches against the NoteStore on its own thread.
+ * * Every 'submit' bumps the generation, which cancels the query in flight.
+ * * The store is scanned in id ranges under a shared lock on 'storeMtx', writers
+ *   (ex: 'updateNote' on the UI thread) take the lock exclusively.
+ * * After every range that changed the ranking a 'SearchResults' event is pushed,
+ *   the UI thread then copies the snapshot with 'latest'.
+ */
+class SearchWorker {
+public:
+    static constexpr size_t maxHits = 200;
+    static constexpr NoteId chunkSize = 2048;
+
+    SearchWorker(const NoteStore& store, std::shared_mutex& storeMtx, EventQueue& events) :
+        store(store), storeMtx(storeMtx), events(events) {
+        worker = std::thread(&SearchWorker::run, this);
+    }
+
+    ~SearchWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+            generation.fetch_add(1);
+        }
+        cv.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    SearchWorker(const SearchWorker&) = delete;
+    SearchWorker& operator=(const SearchWorker&) = delete;
+
+    /**
+     * Starts a new query and cancels the running one.
+     */
+    void submit(std::string query) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            pending = std::move(query);
+            hasPending = true;
+            generation.fetch_add(1);
+        }
+        cv.notify_one();
+    }
+
+    /**
+     * Copies the newest results into 'out', returns false if they belong to an
+     * older, cancelled query.
+     */
+    bool latest(SearchSnapshot& out) {
+        std::lock_guard<std::mutex> lock(resultsMtx);
+        if (snapshot.generation != generation.load()) return false;
+        out = snapshot;
+        return true;
+    }
+
+private:
+    const NoteStore& store;
+    std::shared_mutex& storeMtx;
+    EventQueue& events;
+
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::string pending;
+    bool hasPending{false};
+    bool done{false};
+    std::atomic<uint64_t> generation{0};
+
+    std::mutex resultsMtx;
+    SearchSnapshot snapshot;
+
+    // ASCII case folding for the matchers below
+    static char fold(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    struct FoldHash {
+        size_t operator()(char c) const { return static_cast<unsigned char>(fold(c)); }
+    };
+    struct FoldEqual {
+        bool operator()(char a, char b) const { return fold(a) == fold(b); }
+    };
+    using Searcher = std::boyer_moore_horspool_searcher<std::string::const_iterator, FoldHash, FoldEqual>;
+
+    static bool startsWith(const std::string& text, const std::string& needle) {
+        return text.size() >= needle.size() &&
+               std::equal(needle.begin(), needle.end(), text.begin(), FoldEqual{});
+    }
+
+    /**
+     * Title matches rank above content matches, 0 means no match.
+     */
+    static int score(const NoteData& note, const std::string& needle, const Searcher& searcher) {
+        if (startsWith(note.title, needle)) {
+            return note.title.size() == needle.size() ? 1000 : 600;
+        }
+        if (std::search(note.title.begin(), note.title.end(), searcher) != note.title.end()) return 300;
+        if (std::search(note.content.begin(), note.content.end(), searcher) != note.content.end()) return 100;
+        return 0;
+    }
+
+    /**
+     * Keeps 'hits' sorted and at most 'maxHits' long, returns true if 'hit' made the cut.
+     */
+    static bool insertHit(std::vector<SearchHit>& hits, const SearchHit& hit) {
+        if (hits.size() == maxHits && !(hit < hits.back())) return false;
+        hits.insert(std::upper_bound(hits.begin(), hits.end(), hit), hit);
+        if (hits.size() > maxHits) hits.pop_back();
+        return true;
+    }
+
+    bool cancelled(uint64_t gen) const { return generation.load(std::memory_order_relaxed) != gen; }
+
+    void publish(uint64_t gen, const std::vector<SearchHit>& hits, size_t scanned, bool complete) {
+        {
+            std::lock_guard<std::mutex> lock(resultsMtx);
+            snapshot.generation = gen;
+            snapshot.hits = hits;
+            snapshot.scanned = scanned;
+            snapshot.complete = complete;
+        }
+        events.push({EventType::SearchResults});
+    }
+
+    void scan(const std::string& needle, uint64_t gen) {
+        std::vector<SearchHit> hits;
+        if (needle.empty()) {
+            publish(gen, hits, 0, true);
+            return;
+        }
+        Searcher searcher(needle.begin(), needle.end());
+
+        NoteId last;
+        {
+            std::shared_lock<std::shared_mutex> guard(storeMtx);
+            last = store.lastId();
+        }
+        size_t scanned = 0;
+        for (NoteId first = 1; first <= last; first += chunkSize) {
+            if (cancelled(gen)) return;
+            bool changed = false;
+            {
+                std::shared_lock<std::shared_mutex> guard(storeMtx);
+                NoteId chunk_end = std::min<NoteId>(last, first + chunkSize - 1);
+                for (NoteId id = first; id <= chunk_end; ++id) {
+                    const NoteData* note = store.findNote(id);
+                    if (!note) continue;
+                    ++scanned;
+                    if (int s = score(*note, needle, searcher); s > 0) {
+                        changed |= insertHit(hits, {id, s, note->title.size()});
+                    }
+                }
+            }
+            if (changed) publish(gen, hits, scanned, false);
+        }
+        if (!cancelled(gen)) publish(gen, hits, scanned, true);
+    }
+
+    // Function that loops in the search thread
+    void run() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            cv.wait(lock, [this] { return done || hasPending; });
+            if (done) return;
+            std::string query = std::move(pending);
+            hasPending = false;
+            uint64_t gen = generation.load();
+            lock.unlock();
+            scan(query, gen);
+            lock.lock();
+        }
+    }
+};
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "note.hpp"
-#include "parser.h"
+#include "tokenizer.h"
 
-#include <algorithm> // for iter_swap
+#include <algorithm> // for iter_swap, remove_if, sort
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace note;
 
@@ -26,7 +28,78 @@ struct NoteView {
     bool edit{false};
 };
 
-std::ostream& operator<<(std::ostream& os, const NoteView& note) {
+/**
+ * Orders for the tag and kid lists of a note
+ */
+enum class ListSort : uint8_t { Stored, Title, Recent };
+
+/**
+ * A sorted copy of a tag or kid list, updated only when the store changed
+ */
+struct SortedIds {
+    uint64_t version{UINT64_MAX};
+    ListSort sort{ListSort::Stored};
+    std::vector<NoteId> ids;
+};
+
+/**
+ * Per note state of the tag and kid lists: order, current page and sort caches
+ */
+struct NoteListState {
+    ListSort sort{ListSort::Stored};
+    uint32_t tagPage{0};
+    uint32_t kidPage{0};
+    SortedIds tags;
+    SortedIds kids;
+};
+
+/**
+ * State of the search panel, results are filled in from the search worker
+ */
+struct SearchState {
+    bool show{false};
+    std::string query;
+    std::vector<NoteId> results;
+    size_t scanned{0};
+    bool searching{false};
+};
+
+/**
+ * State of the graph window: visibility, zoom and the world point at its center
+ */
+struct GraphState {
+    bool show{false};
+    float zoom{0.1f};
+    float panX{0.0f};
+    float panY{0.0f};
+};
+
+/**
+ * State of the diagnostics window: frame timings and memory use
+ */
+struct DiagnosticsState {
+    bool show{false};
+};
+
+/**
+ * Memory held by a ViewState, in bytes, counted like the store's MemoryStats
+ */
+struct ViewMemoryStats {
+    size_t visible{0};      // open notes
+    size_t listStates{0};   // notes with list state
+    size_t visibleBytes{0}; // the open notes list in use
+    size_t editBytes{0};    // the edit strings in use
+    size_t searchBytes{0};  // the search query and results in use
+    size_t sortedBytes{0};  // sorted tag and kid lists in use
+    size_t tableBytes{0};   // nodes and buckets of the list state map and the open note set
+    size_t slackBytes{0};   // capacity of the strings and lists beyond their size
+
+    size_t totalBytes() const noexcept {
+        return visibleBytes + editBytes + searchBytes + sortedBytes + tableBytes + slackBytes;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const NoteView& note) {
     return os << "id: " << note.id << std::endl;
 }
 
@@ -39,12 +112,135 @@ std::ostream& operator<<(std::ostream& os, const NoteView& note) {
 class ViewState {
 private:
     std::vector<NoteView> visible;
+    std::unordered_set<NoteId> visibleIds;  // the ids of 'visible', for 'isVisible'
     EditNote editNote;
+    tokenizer::Tokenizer tokenizer;
+    SearchState search;
+    GraphState graph;
+    DiagnosticsState diagnostics;
+    std::unordered_map<NoteId, NoteListState> lists;
     bool editMode {false};
     bool dirty {false};
+    // ids and capacity of all sorted lists, kept up to date by 'sorted' and 'removeId'
+    mutable size_t sortedIds {0};
+    mutable size_t sortedCapacity {0};
+    // 'sorted' only: the notes of a list that changed since it was sorted
+    mutable std::vector<NoteId> moved;
+
+    /**
+     * Moves the members of 'source' changed since 'cache' was sorted to their
+     * new place. False if the members don't add up, the list must be sorted again.
+     */
+    template<typename Before>
+    bool mergeChanged(SortedIds& cache, const std::vector<NoteId>& source, Before before,
+                      const NoteStore& store) const {
+        auto changed = [&](NoteId id) { return store.getNote(id).modified > cache.version; };
+        moved.clear();
+        for (NoteId id : source) {
+            if (changed(id)) moved.push_back(id);
+        }
+        auto kept = std::remove_if(cache.ids.begin(), cache.ids.end(), changed);
+        size_t i = static_cast<size_t>(kept - cache.ids.begin());
+        if (i + moved.size() != source.size()) return false;
+        std::sort(moved.begin(), moved.end(), before);
+
+        // merged from the back, the kept ids are still in order
+        cache.ids.resize(source.size());
+        size_t j = moved.size();
+        size_t out = source.size();
+        while (j > 0) {
+            if (i > 0 && before(moved[j - 1], cache.ids[i - 1])) cache.ids[--out] = cache.ids[--i];
+            else cache.ids[--out] = moved[--j];
+        }
+        return true;
+    }
+
+    // the stats with 'ids' sorted ids in use and 'capacity' allocated for them
+    ViewMemoryStats memoryStats(size_t ids, size_t capacity) const noexcept {
+        ViewMemoryStats stats;
+        stats.visible = visible.size();
+        stats.listStates = lists.size();
+        stats.visibleBytes = visible.size() * sizeof(NoteView);
+        for (const std::string* s : {&editNote.title, &editNote.content, &editNote.tags, &editNote.kids}) {
+            stats.editBytes += usedBytes(*s);
+            stats.slackBytes += slackBytes(*s);
+        }
+        stats.searchBytes = usedBytes(search.query) + search.results.size() * sizeof(NoteId);
+        stats.sortedBytes = ids * sizeof(NoteId);
+        // a node: the key and state, the next pointer
+        constexpr size_t listNode = sizeof(std::pair<const NoteId, NoteListState>) + sizeof(void*);
+        constexpr size_t idNode = sizeof(NoteId) + sizeof(void*);
+        stats.tableBytes = lists.size() * listNode + lists.bucket_count() * sizeof(void*) +
+                           visibleIds.size() * idNode + visibleIds.bucket_count() * sizeof(void*);
+        stats.slackBytes += slackBytes(search.query) +
+                            (visible.capacity() - visible.size()) * sizeof(NoteView) +
+                            (search.results.capacity() - search.results.size()) * sizeof(NoteId) +
+                            (capacity - ids) * sizeof(NoteId) +
+                            moved.capacity() * sizeof(NoteId);
+        return stats;
+    }
 public:
     const std::vector<NoteView>& view() const noexcept { return visible; }
     EditNote& getEditNote() { return editNote; }
+    SearchState& getSearch() { return search; }
+    GraphState& getGraph() { return graph; }
+    DiagnosticsState& getDiagnostics() { return diagnostics; }
+    NoteListState& getLists(NoteId id) { return lists[id]; }
+
+    /**
+     * Returns 'source' in the order of 'sort'. The sorted copy lives in 'cache',
+     * a list state of this view, and is kept up to date instead of sorted again:
+     * * Unchanged store and order: the copy as it is.
+     * * Other notes changed: only the members changed since (their 'modified'
+     *   is newer) are sorted and merged back in, O(n + k log k) for k of them.
+     * * The note holding 'source' changed ('listVersion', its 'modified'), so
+     *   members may have been removed, or the order changed: sorted again.
+     */
+    const std::vector<NoteId>& sorted(SortedIds& cache, const std::vector<NoteId>& source, uint64_t listVersion,
+                                      ListSort sort, const NoteStore& store) const {
+        if (sort == ListSort::Stored) return source;
+        if (cache.version == store.version() && cache.sort == sort) return cache.ids;
+
+        auto before = [&](NoteId a, NoteId b) {
+            const NoteData& na = store.getNote(a);
+            const NoteData& nb = store.getNote(b);
+            if (sort == ListSort::Title) return na.title != nb.title ? na.title < nb.title : a < b;
+            // most recently changed first
+            return na.modified != nb.modified ? na.modified > nb.modified : a < b;
+        };
+        sortedIds -= cache.ids.size();
+        sortedCapacity -= cache.ids.capacity();
+        bool current = cache.sort == sort && cache.version != UINT64_MAX && listVersion <= cache.version;
+        if (!current || !mergeChanged(cache, source, before, store)) {
+            cache.ids.assign(source.begin(), source.end());
+            std::sort(cache.ids.begin(), cache.ids.end(), before);
+        }
+        sortedIds += cache.ids.size();
+        sortedCapacity += cache.ids.capacity();
+        cache.version = store.version();
+        cache.sort = sort;
+        return cache.ids;
+    }
+
+    /**
+     * Memory held by the view state, without a walk of the list states:
+     * 'sorted' and 'removeId' keep the totals of their sorted lists.
+     */
+    ViewMemoryStats memoryStats() const noexcept { return memoryStats(sortedIds, sortedCapacity); }
+
+    /**
+     * 'memoryStats' counted again from every list state, to check the running totals.
+     */
+    ViewMemoryStats recountMemoryStats() const noexcept {
+        size_t ids = 0, capacity = 0;
+        for (const auto& [id, state] : lists) {
+            for (const SortedIds* cache : {&state.tags, &state.kids}) {
+                ids += cache->ids.size();
+                capacity += cache->ids.capacity();
+            }
+        }
+        return memoryStats(ids, capacity);
+    }
 
     const NoteView& getNote(NoteId id) const {
         for (auto& note : visible) {
@@ -53,6 +249,8 @@ public:
         throw std::out_of_range("Error!  Could not find: " + std::to_string(id) + " in 'visible'!");
     }
 
+    bool isVisible(NoteId id) const noexcept { return visibleIds.count(id) != 0; }
+
     NoteView& getNote(NoteId id) {
         for (auto& note : visible) {
             if (note.id == id) return note;
@@ -60,9 +258,9 @@ public:
         throw std::out_of_range("Error!  Could not find: " + std::to_string(id) + " in 'visible'!");
     }
     
-    void addFromKids(const std::vector<NoteId>& kids, const NoteStore& store) {
+    void addFromKids(const std::vector<NoteId>& kids) {
         for (const auto& kid : kids) {
-            visible.emplace_back(kid);
+            if (visibleIds.insert(kid).second) visible.emplace_back(kid);
         }
     }
 
@@ -89,17 +287,15 @@ public:
     }
     
     /**
-     * Adds 'id' into 'visible'
+     * Adds 'id' into 'visible', after 'after_id' or at the end if 'after_id'
+     * isn't visible (ex: 0).
      */
-    void addId(NoteId id, NoteId after_id) {
+    void addId(NoteId id, NoteId after_id = 0) {
         LOG_DEBUG() << "opening: " << id << ", after: " << after_id;
-        for (auto it = visible.begin(); it != visible.end(); ++it) {
-            if (it->id == id) {
-                LOG_DEBUG() << "found id: " << id << ", returning";
-                return;
-            }
+        if (!visibleIds.insert(id).second) {
+            LOG_DEBUG() << "found id: " << id << ", returning";
+            return;
         }
-        
         for (auto it = visible.begin(); it != visible.end(); ++it) {
             if (it->id == after_id) {
                 LOG_DEBUG() << "found after_id: " << after_id << ", inserting: " << id;
@@ -111,12 +307,35 @@ public:
         visible.emplace_back(id);
     }
 
+    /**
+     * Removes 'id' from 'visible' with its list state, an edit of it is dropped.
+     */
+    void removeId(NoteId id) {
+        LOG_DEBUG() << "closing: " << id;
+        for (auto it = visible.begin(); it != visible.end(); ++it) {
+            if (it->id == id) {
+                if (it->edit) editMode = false;
+                visible.erase(it);
+                visibleIds.erase(id);
+                break;
+            }
+        }
+        // the list state of a closed note goes with it
+        if (auto it = lists.find(id); it != lists.end()) {
+            for (const SortedIds* cache : {&it->second.tags, &it->second.kids}) {
+                sortedIds -= cache->ids.size();
+                sortedCapacity -= cache->ids.capacity();
+            }
+            lists.erase(it);
+        }
+    }
+
     bool getEditMode() const {return editMode;}
     
     /**
      * Sets the the specific note to edit mode
      */
-    void startEdit(NoteId id, const NoteDataStrings& note = {}) {
+    void startEdit(NoteId id, const NoteDataView& note = {}) {
         LOG_DEBUG() << "starting edit of id: " << id << ", editMode: " << (editMode ? "true" : "false");
         if (note.title.empty())
             return;
@@ -133,27 +352,36 @@ public:
     }
 
     /**
-     * Copies the content of the input note to ImGuiViewers' editNote.
+     * Copies the content of the input note to ImGuiViewers' editNote, straight
+     * from the store: the edit strings are the only copy.
      */
-    void setEditNote(const NoteDataStrings& note, std::string delimiter = " ") {
+    void setEditNote(const NoteDataView& note, std::string_view delimiter = " ") {
         editNote.title = note.title;
         LOG_DEBUG() << "setting editNote title: " << editNote.title;
         editNote.content = note.content;
+        // appended in place, the edit strings keep their buffers from the last edit
         editNote.tags.clear();
-        for (const auto& tag : note.tags) {
-            editNote.tags = editNote.tags + delimiter + tag;
-        }
+        for (std::string_view tag : note.tags) appendWord(editNote.tags, tag, delimiter);
         editNote.kids.clear();
-        for (const auto& kid : note.kids) {
-            editNote.kids = editNote.kids + delimiter + kid;
+        for (std::string_view kid : note.kids) appendWord(editNote.kids, kid, delimiter);
+    }
+
+    // titles with spaces or commas are quoted, the tokenizer reads them back as one word
+    static void appendWord(std::string& line, std::string_view word, std::string_view delimiter) {
+        line += delimiter;
+        if (tokenizer::Tokenizer::needsQuotes(word)) {
+            tokenizer::Tokenizer::appendQuoted(line, word);
+        } else {
+            line += word;
         }
     }
 
     void copyFromEdit(NoteDataStrings& note) {
         note.title = editNote.title;
         note.content = editNote.content;
-        note.tags = parseWords(editNote.tags);
-        note.kids = parseWords(editNote.kids);
+        // in the order they were typed, an unchanged edit gives back the stored lists
+        tokenizer.tokenize(editNote.tags, note.tags);
+        tokenizer.tokenize(editNote.kids, note.kids);
     }
 
     void stopEdit(NoteId id) {
@@ -0,0 +1,78 @@
+// Writes a synthetic notes file for scale and load tests, see note::WikiGenerator.
+//      ex: notewiki_gen -n 10000000 --seed 7 -o big.json
+#include <fcntl.h>      // for ::open
+#include <iostream>
+#include <string>
+#include <unistd.h>     // for ::close
+
+#include <cxxopts.hpp>
+#include "buffered_writer.h"
+#include "wiki_gen.hpp"
+
+int main(int argc, char* argv[]) {
+    note::WikiGenOptions gen;
+    std::string output;
+    try {
+        cxxopts::Options opts("notewiki_gen", "Writes a synthetic notes file, the same for the same options and seed");
+        opts.add_options()
+            ("n,notes", "Number of notes (default 1000)", cxxopts::value<uint64_t>())
+            ("o,output", "File to write, stdout if not given", cxxopts::value<std::string>())
+            ("seed", "Random seed (default 1)", cxxopts::value<uint64_t>())
+            ("content-median", "Median content size in bytes (default 300)", cxxopts::value<size_t>())
+            ("content-sigma", "Spread of the log-normal content size (default 1.0)", cxxopts::value<double>())
+            ("content-max", "Largest content in bytes (default 65536)", cxxopts::value<size_t>())
+            ("links", "Share of content words that are [[links]] (default 0.02)", cxxopts::value<double>())
+            ("tags", "Most tags per note, up to 16 (default 3)", cxxopts::value<size_t>())
+            ("tag-skew", "Power-law exponent of tag popularity (default 1.1)", cxxopts::value<double>())
+            ("hubs", "Mega-hub notes, the first is 'default' (default 1)", cxxopts::value<size_t>())
+            ("hub-share", "Share of notes tagged with a hub (default 0.1)", cxxopts::value<double>())
+            ("depth", "Levels of the tag hierarchy, 0 or 1: flat (default 4)", cxxopts::value<size_t>())
+            ("cycles", "Share of notes that close a tag cycle (default 0.001)", cxxopts::value<double>())
+            ("h,help", "Show help");
+        auto result = opts.parse(argc, argv);
+        if (result.count("help")) {
+            std::cout << opts.help() << "\n";
+            return 0;
+        }
+        if (result.count("notes")) gen.notes = result["notes"].as<uint64_t>();
+        if (result.count("output")) output = result["output"].as<std::string>();
+        if (result.count("seed")) gen.seed = result["seed"].as<uint64_t>();
+        if (result.count("content-median")) gen.contentMedian = result["content-median"].as<size_t>();
+        if (result.count("content-sigma")) gen.contentSigma = result["content-sigma"].as<double>();
+        if (result.count("content-max")) gen.contentMax = result["content-max"].as<size_t>();
+        if (result.count("links")) gen.linkShare = result["links"].as<double>();
+        if (result.count("tags")) gen.maxTags = result["tags"].as<size_t>();
+        if (result.count("tag-skew")) gen.tagSkew = result["tag-skew"].as<double>();
+        if (result.count("hubs")) gen.hubs = result["hubs"].as<size_t>();
+        if (result.count("hub-share")) gen.hubShare = result["hub-share"].as<double>();
+        if (result.count("depth")) gen.depth = result["depth"].as<size_t>();
+        if (result.count("cycles")) gen.cycleShare = result["cycles"].as<double>();
+    } catch (const cxxopts::exceptions::exception& e) {
+        std::cout << "Argument error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (gen.maxTags > note::WikiGenerator::maxTagLimit) {
+        std::cout << "Argument error: --tags is over " << note::WikiGenerator::maxTagLimit << "\n";
+        return 1;
+    }
+
+    int fd = 1;
+    if (!output.empty()) {
+        fd = ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cerr << "cannot write " << output << "\n";
+            return 1;
+        }
+    }
+    bool ok;
+    {
+        BufferedWriter out(fd, 4 << 20);
+        note::WikiGenerator(gen).write(out);
+        out.flush();
+        ok = out.ok();
+    }
+    if (fd != 1) ok = ::close(fd) == 0 && ok;
+    if (!ok) std::cerr << "write failed\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// The cost of a LOG_* statement on the calling thread: encoding, the push into
+// the thread's ring and waking the logger. Every output is off, so the logger
+// thread only drains the rings; a producer that outruns it waits like it would
+// under the default BLOCK policy. BM_LogWritten adds the logger thread's side.
+// BM_FileSink* compare the file sink with the ofstream and endl it replaced.
+// Linked into notewiki_bench.
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "file_sink.h"
+#include "logger.h"
+
+namespace {
+
+void quietLogger(LogLevel level = LogLevel::INFO) {
+    Logger& logger = Logger::getInstance();
+    logger.enableConsoleLogging(false);
+    logger.setLogLevel(level);
+}
+
+// Below the log level at run time: the check, no operand is evaluated.
+void BM_LogDisabled(benchmark::State& state) {
+    quietLogger(LogLevel::WARNING);
+    int64_t i = 0;
+    for (auto _ : state) {
+        LOG_INFO() << "note " << ++i << " skipped";
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_LogDisabled);
+
+// Text and numbers, past the small string buffer, formatted on the logger thread.
+void BM_LogDeferred(benchmark::State& state) {
+    quietLogger();
+    Logger::getInstance().setDeferredFormatting(true);
+    int64_t i = 0;
+    for (auto _ : state) {
+        LOG_INFO() << "loaded note " << ++i << " in " << 0.25 << " ms from the store";
+    }
+    Logger::getInstance().waitForQueueToEmpty();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogDeferred)->ThreadRange(1, 4)->UseRealTime();
+
+// The same message formatted on the calling thread.
+void BM_LogEager(benchmark::State& state) {
+    quietLogger();
+    Logger::getInstance().setDeferredFormatting(false);
+    int64_t i = 0;
+    for (auto _ : state) {
+        LOG_INFO() << "loaded note " << ++i << " in " << 0.25 << " ms from the store";
+    }
+    Logger::getInstance().waitForQueueToEmpty();
+    Logger::getInstance().setDeferredFormatting(true);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogEager)->ThreadRange(1, 4)->UseRealTime();
+
+// Batches of 1000 messages until the logger thread has written them as text lines
+// to a file sink on /dev/null. Arg: 1 deferred, 0 eager formatting.
+void BM_LogWritten(benchmark::State& state) {
+    constexpr int64_t batch = 1000;
+    quietLogger();
+    Logger& logger = Logger::getInstance();
+    logger.setDeferredFormatting(state.range(0) != 0);
+    logger.enableFileLogging("/dev/null");
+    int64_t i = 0;
+    for (auto _ : state) {
+        for (int64_t n = 0; n < batch; ++n) {
+            LOG_INFO() << "loaded note " << ++i << " in " << 0.25 << " ms from the store";
+        }
+        logger.waitForQueueToEmpty();
+    }
+    logger.enableFileLogging("");
+    logger.setDeferredFormatting(true);
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_LogWritten)->Arg(0)->Arg(1)->UseRealTime();
+
+constexpr int64_t sinkLines = 100'000;
+
+std::string sinkPath() {
+    return (std::filesystem::temp_directory_path() / ("bench_file_sink_" + std::to_string(::getpid()) + ".log")).string();
+}
+
+// 80 byte lines, the size of a short log line with its timestamp
+const std::string& sinkLine() {
+    static const std::string line(79, 'x');
+    return line;
+}
+
+// 'sinkLines' lines into a fresh file, closed (and so flushed) at the end.
+void BM_FileSinkWrite(benchmark::State& state) {
+    std::string path = sinkPath();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove(path);
+        FileSink sink;
+        sink.open(path);
+        state.ResumeTiming();
+        for (int64_t n = 0; n < sinkLines; ++n) sink.write(sinkLine(), false);
+        sink.close();
+    }
+    std::filesystem::remove(path);
+    state.SetItemsProcessed(state.iterations() * sinkLines);
+    state.SetBytesProcessed(state.iterations() * sinkLines * static_cast<int64_t>(sinkLine().size() + 1));
+}
+BENCHMARK(BM_FileSinkWrite)->Unit(benchmark::kMillisecond);
+
+// What file logging did before FileSink: an ofstream flushed by endl on every line.
+void BM_FileSinkOfstreamEndl(benchmark::State& state) {
+    std::string path = sinkPath();
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::ofstream file(path, std::ios::trunc);
+        state.ResumeTiming();
+        for (int64_t n = 0; n < sinkLines; ++n) file << sinkLine() << std::endl;
+        file.close();
+    }
+    std::filesystem::remove(path);
+    state.SetItemsProcessed(state.iterations() * sinkLines);
+    state.SetBytesProcessed(state.iterations() * sinkLines * static_cast<int64_t>(sinkLine().size() + 1));
+}
+BENCHMARK(BM_FileSinkOfstreamEndl)->Unit(benchmark::kMillisecond);
+
+} // namespace
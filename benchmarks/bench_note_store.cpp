@@ -0,0 +1,199 @@
+// NoteStore operations on stores of 1k, 100k and 1M notes.
+//      run: notewiki_bench --benchmark_out=notewiki_bench.json --benchmark_out_format=json
+//      or:  cmake --build build --target bench_json
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>      // for ::open
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>  // for std::as_const
+#include <vector>
+#include <unistd.h>     // for ::close
+
+#include "buffered_writer.h"
+#include "note.hpp"
+#include "wiki_gen.hpp"
+
+using note::NoteId;
+using note::NoteStore;
+
+namespace {
+
+constexpr uint64_t seed = 0x5eed;
+
+// The wiki every benchmark of a size runs on: the default shape with short contents,
+// so the 1M notes file stays near 250MB.
+const note::WikiGenerator& generator(size_t notes) {
+    static std::map<size_t, std::unique_ptr<note::WikiGenerator>> generators;
+    auto& gen = generators[notes];
+    if (!gen) gen = std::make_unique<note::WikiGenerator>(note::WikiGenOptions{.notes = notes, .seed = seed, .contentMedian = 100});
+    return *gen;
+}
+
+// A JSON store of 'notes' notes, written once per size and reused by every benchmark.
+const std::string& datasetFile(size_t notes) {
+    static std::map<size_t, std::string> files;
+    if (auto it = files.find(notes); it != files.end()) return it->second;
+
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("notewiki_bench_" + std::to_string(notes) + ".json")).string();
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    {
+        BufferedWriter out(fd, 4 << 20);
+        generator(notes).write(out);
+    }
+    ::close(fd);
+    return files.emplace(notes, path).first->second;
+}
+
+// A loaded store per size, shared by the read-only benchmarks, copied by the others.
+NoteStore& loadedStore(size_t notes) {
+    static std::map<size_t, std::unique_ptr<NoteStore>> stores;
+    auto& store = stores[notes];
+    if (!store) store = std::make_unique<NoteStore>(datasetFile(notes));
+    return *store;
+}
+
+void sizes(benchmark::internal::Benchmark* b) {
+    b->Arg(1'000)->Arg(100'000)->Arg(1'000'000);
+}
+
+void BM_LoadJson(benchmark::State& state) {
+    size_t notes = static_cast<size_t>(state.range(0));
+    const std::string& file = datasetFile(notes);
+    for (auto _ : state) {
+        NoteStore store(file);
+        benchmark::DoNotOptimize(store.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(file)));
+}
+BENCHMARK(BM_LoadJson)->Apply(sizes)->Unit(benchmark::kMillisecond);
+
+void BM_SaveJson(benchmark::State& state) {
+    size_t notes = static_cast<size_t>(state.range(0));
+    NoteStore store = loadedStore(notes);
+    std::string out = datasetFile(notes) + ".saved";
+    for (auto _ : state) store.save_json_file(out);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::filesystem::remove(out);
+}
+BENCHMARK(BM_SaveJson)->Apply(sizes)->Unit(benchmark::kMillisecond);
+
+void BM_GetId(benchmark::State& state) {
+    size_t notes = static_cast<size_t>(state.range(0));
+    NoteStore& store = loadedStore(notes);
+    std::vector<std::string> titles;
+    std::mt19937_64 rng(seed);
+    for (int i = 0; i < 4096; ++i) titles.push_back(generator(notes).title(rng() % notes));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(std::as_const(store).getId(titles[i++ & 4095]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetId)->Apply(sizes);
+
+void BM_GetNote(benchmark::State& state) {
+    size_t notes = static_cast<size_t>(state.range(0));
+    const NoteStore& store = loadedStore(notes);
+    std::vector<NoteId> ids;
+    std::mt19937_64 rng(seed);
+    for (int i = 0; i < 4096; ++i) ids.push_back(static_cast<NoteId>(1 + rng() % store.lastId()));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&store.getNote(ids[i++ & 4095]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetNote)->Apply(sizes);
+
+void BM_GetNoteStrings(benchmark::State& state) {
+    size_t notes = static_cast<size_t>(state.range(0));
+    NoteStore& store = loadedStore(notes);
+    std::vector<NoteId> ids;
+    std::mt19937_64 rng(seed);
+    for (int i = 0; i < 4096; ++i) ids.push_back(static_cast<NoteId>(1 + rng() % store.lastId()));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store.getNoteStrings(ids[i++ & 4095]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetNoteStrings)->Apply(sizes);
+
+// The same reads as BM_GetNoteStrings, the tag and kid titles are resolved, not copied.
+void BM_GetNoteView(benchmark::State& state) {
+    size_t notes = static_cast<size_t>(state.range(0));
+    const NoteStore& store = loadedStore(notes);
+    std::vector<NoteId> ids;
+    std::mt19937_64 rng(seed);
+    for (int i = 0; i < 4096; ++i) ids.push_back(static_cast<NoteId>(1 + rng() % store.lastId()));
+    size_t i = 0;
+    for (auto _ : state) {
+        note::NoteDataView note = store.getNoteView(ids[i++ & 4095]);
+        size_t bytes = note.title.size() + note.content.size();
+        for (std::string_view tag : note.tags) bytes += tag.size();
+        for (std::string_view kid : note.kids) bytes += kid.size();
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetNoteView)->Apply(sizes);
+
+// Popular tags (low ids) get long kid lists, appending to them is part of the cost.
+void BM_AddNote(benchmark::State& state) {
+    size_t notes = static_cast<size_t>(state.range(0));
+    NoteStore store = loadedStore(notes);
+    // tags are picked from all notes with the same power-law as the generated ones
+    const note::WikiGenerator& gen = generator(notes);
+    note::PowerLaw pick(notes, gen.options().tagSkew);
+    note::SplitMix64 rng{seed};
+    auto tags = [&] {
+        std::vector<std::string> result(rng.below(gen.options().maxTags + 1));
+        for (auto& tag : result) tag = gen.title(pick(rng));
+        return result;
+    };
+    // titles and tags are made in batches outside the timing
+    std::vector<std::pair<std::string, std::vector<std::string>>> batch(4096);
+    size_t added = 0;
+    for (auto _ : state) {
+        size_t slot = added % batch.size();
+        if (slot == 0) {
+            state.PauseTiming();
+            for (size_t i = 0; i < batch.size(); ++i) batch[i] = {"added " + std::to_string(added + i), tags()};
+            state.ResumeTiming();
+        }
+        ++added;
+        store.addNote(std::move(batch[slot].first), "new content", std::move(batch[slot].second), {});
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AddNote)->Apply(sizes);
+
+void BM_UpdateNote(benchmark::State& state) {
+    size_t notes = static_cast<size_t>(state.range(0));
+    NoteStore store = loadedStore(notes);
+    std::vector<std::pair<NoteId, note::NoteDataStrings>> targets;
+    std::mt19937_64 rng(seed);
+    for (int i = 0; i < 1024; ++i) {
+        NoteId id = static_cast<NoteId>(1 + rng() % store.lastId());
+        targets.emplace_back(id, store.getNoteStrings(id));
+    }
+    const std::string contents[2] = {"edited content", "edited content, again"};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& [id, strings] = targets[i & 1023];
+        // alternate the content so no update is a no-op
+        store.updateNote(id, strings.title, contents[(i++ >> 10) & 1], strings.tags, strings.kids);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UpdateNote)->Apply(sizes);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,213 @@
+// Draws the ImGui viewer for a number of frames with no window and no GPU, and
+// reports the CPU time and draw list size of the frames, phase by phase.
+//      ex: notewiki_render_bench --notes 100000 --frames 2000
+//
+// The renderer runs against a null backend: a synthetic display size and mouse,
+// and font textures that are "uploaded" as soon as ImGui asks for them. Frame
+// times are the UI thread's CPU time from ImGui::NewFrame to ImGui::Render, the
+// graph layout threads are not part of them.
+#include <algorithm>
+#include <cstdio>
+#include <ctime>        // for clock_gettime
+#include <fcntl.h>      // for ::open
+#include <filesystem>
+#include <iostream>
+#include <iterator>     // for std::size
+#include <shared_mutex>
+#include <string>
+#include <unistd.h>     // for ::close
+#include <vector>
+
+#include <cxxopts.hpp>
+#include "buffered_writer.h"
+#include "note.hpp"
+#include "note_renderer.hpp"
+#include "wiki_gen.hpp"
+
+namespace {
+
+int64_t threadCpuNanos() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * The scripted phases, each runs for an equal share of the frames.
+ */
+enum class Phase { Idle, Scroll, Edit, Graph };
+constexpr const char* phaseNames[] = {"idle", "scroll", "edit", "graph"};
+constexpr size_t phaseCount = std::size(phaseNames);
+
+struct FrameStats {
+    std::vector<int64_t> nanos;
+    std::vector<int> vertices;
+};
+
+// The null renderer: marks the textures ImGui wants created or updated as uploaded.
+void updateTextures() {
+#if IMGUI_VERSION_NUM >= 19200
+    for (ImTextureData* tex : ImGui::GetPlatformIO().Textures) {
+        if (tex->Status == ImTextureStatus_WantCreate || tex->Status == ImTextureStatus_WantUpdates) {
+            tex->SetTexID(static_cast<ImTextureID>(1));
+            tex->SetStatus(ImTextureStatus_OK);
+        } else if (tex->Status == ImTextureStatus_WantDestroy && tex->UnusedFrames > 0) {
+            tex->SetTexID(ImTextureID_Invalid);
+            tex->SetStatus(ImTextureStatus_Destroyed);
+        }
+    }
+#endif
+}
+
+// A generated wiki, through a temporary file so it loads like a real one.
+std::string generateStore(const note::WikiGenOptions& options) {
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("notewiki_render_bench_" + std::to_string(::getpid()) + ".json")).string();
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return {};
+    {
+        BufferedWriter out(fd, 4 << 20);
+        note::WikiGenerator(options).write(out);
+    }
+    ::close(fd);
+    return path;
+}
+
+int64_t percentile(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    note::WikiGenOptions gen{.notes = 10000};
+    std::string storePath;
+    size_t frames = 1200;
+    size_t open = 100;
+    float width = 1280.0f;
+    float height = 800.0f;
+    try {
+        cxxopts::Options opts("notewiki_render_bench", "Measures the ImGui viewer's CPU cost per frame without a GPU");
+        opts.add_options()
+            ("n,notes", "Notes of the generated wiki (default 10000)", cxxopts::value<uint64_t>())
+            ("seed", "Seed of the generated wiki (default 1)", cxxopts::value<uint64_t>())
+            ("s,store", "Use this notes file instead of a generated wiki", cxxopts::value<std::string>())
+            ("f,frames", "Frames to draw, split between the phases (default 1200)", cxxopts::value<size_t>())
+            ("open", "Kids of 'default' to show, 0: all of them like the viewer (default 100)", cxxopts::value<size_t>())
+            ("width", "Display width (default 1280)", cxxopts::value<float>())
+            ("height", "Display height (default 800)", cxxopts::value<float>())
+            ("h,help", "Show help");
+        auto result = opts.parse(argc, argv);
+        if (result.count("help")) {
+            std::cout << opts.help() << "\n";
+            return 0;
+        }
+        if (result.count("notes")) gen.notes = result["notes"].as<uint64_t>();
+        if (result.count("seed")) gen.seed = result["seed"].as<uint64_t>();
+        if (result.count("store")) storePath = result["store"].as<std::string>();
+        if (result.count("frames")) frames = result["frames"].as<size_t>();
+        if (result.count("open")) open = result["open"].as<size_t>();
+        if (result.count("width")) width = result["width"].as<float>();
+        if (result.count("height")) height = result["height"].as<float>();
+    } catch (const cxxopts::exceptions::exception& e) {
+        std::cout << "Argument error: " << e.what() << "\n";
+        return 1;
+    }
+
+    bool generated = storePath.empty();
+    if (generated) {
+        storePath = generateStore(gen);
+        if (storePath.empty()) {
+            std::cerr << "cannot write the generated wiki\n";
+            return 1;
+        }
+    }
+    NoteStore store(storePath);
+    if (generated) std::filesystem::remove(storePath);
+
+    std::shared_mutex storeMtx;
+    ViewState view;
+    EventQueue events;
+    GraphLayout graph{store, storeMtx};
+    auto kids = store.getKids("default");
+    if (open > 0 && kids.size() > open) kids.resize(open);
+    view.addFromKids(kids);
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(width, height);
+    io.DeltaTime = 1.0f / 60.0f;
+#if IMGUI_VERSION_NUM >= 19200
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+#endif
+    ImFont* font = io.Fonts->AddFontDefault();
+#if IMGUI_VERSION_NUM < 19200
+    unsigned char* pixels;
+    int atlas_w, atlas_h;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &atlas_w, &atlas_h);
+#endif
+    NoteRenderer renderer;
+    renderer.setFonts(font, font);
+
+    FrameStats stats[phaseCount];
+    Phase phase = Phase::Idle;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        auto next = static_cast<Phase>(frame * phaseCount / frames);
+        if (next != phase || frame == 0) {
+            // leave the previous phase, enter the next one
+            if (phase == Phase::Edit && !view.view().empty()) view.stopEdit(view.view().front().id);
+            if (next == Phase::Edit && !view.view().empty()) {
+                NoteId id = view.view().front().id;
+                view.startEdit(id, store.getNoteView(id));
+            }
+            view.getGraph().show = next == Phase::Graph;
+            graph.setActive(next == Phase::Graph);
+            phase = next;
+        }
+
+        io.AddMousePosEvent(width * 0.5f, height * 0.5f);
+        if (phase == Phase::Scroll) io.AddMouseWheelEvent(0.0f, -1.0f);
+
+        int64_t start = threadCpuNanos();
+        ImGui::NewFrame();
+        // the notes fill the display, the tool windows open on top
+        ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(io.DisplaySize, ImGuiCond_FirstUseEver);
+        ImGui::Begin("NoteWiki");
+        ImGui::End();
+        renderer.renderFrame(RenderCtx{store, view, events, graph});
+        ImGui::Render();
+        int64_t elapsed = threadCpuNanos() - start;
+
+        updateTextures();
+        auto& phaseStats = stats[static_cast<size_t>(phase)];
+        phaseStats.nanos.push_back(elapsed);
+        phaseStats.vertices.push_back(ImGui::GetDrawData()->TotalVtxCount);
+        // nothing clicks, but hovering may still queue events
+        Event e;
+        while (events.try_pop(e)) {}
+    }
+    graph.setActive(false);
+    ImGui::DestroyContext();
+
+    std::printf("%zu notes, %zu shown, %zu frames at %.0fx%.0f\n",
+                store.size(), view.view().size(), frames, width, height);
+    std::printf("%-8s %8s %10s %10s %10s %10s %12s %12s\n",
+                "phase", "frames", "p50 us", "p90 us", "p99 us", "max us", "vertices", "max vertices");
+    for (size_t p = 0; p < phaseCount; ++p) {
+        FrameStats& s = stats[p];
+        if (s.nanos.empty()) continue;
+        std::sort(s.nanos.begin(), s.nanos.end());
+        double vertices = 0;
+        for (int v : s.vertices) vertices += v;
+        std::printf("%-8s %8zu %10.1f %10.1f %10.1f %10.1f %12.0f %12d\n", phaseNames[p], s.nanos.size(),
+                    percentile(s.nanos, 0.50) / 1e3, percentile(s.nanos, 0.90) / 1e3,
+                    percentile(s.nanos, 0.99) / 1e3, s.nanos.back() / 1e3,
+                    vertices / static_cast<double>(s.vertices.size()),
+                    *std::max_element(s.vertices.begin(), s.vertices.end()));
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+// parseWords against the Tokenizer on tag and kid lines of 8 to 4096 words,
+// a quarter of them repeated. Linked into notewiki_bench.
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parser.h"
+#include "tokenizer.h"
+
+namespace {
+
+// 'words' words of 3 to 20 letters separated by ", " or " ", one in four a repeat
+std::string tagLine(size_t words) {
+    std::mt19937_64 rng(0x5eed);
+    std::vector<std::string> unique;
+    std::string line;
+    for (size_t i = 0; i < words; ++i) {
+        if (!unique.empty() && rng() % 4 == 0) {
+            line += unique[rng() % unique.size()];
+        } else {
+            std::string word(3 + rng() % 18, 'a');
+            for (char& c : word) c = static_cast<char>('a' + rng() % 26);
+            unique.push_back(word);
+            line += word;
+        }
+        line += rng() % 2 ? ", " : " ";
+    }
+    return line;
+}
+
+void lineSizes(benchmark::internal::Benchmark* b) {
+    b->RangeMultiplier(8)->Range(8, 4096);
+}
+
+void BM_ParseWords(benchmark::State& state) {
+    std::string line = tagLine(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parseWords(line));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * line.size()));
+}
+BENCHMARK(BM_ParseWords)->Apply(lineSizes);
+
+// Views into the line, the list and the hash set reused as on the edit path.
+void BM_Tokenize(benchmark::State& state) {
+    std::string line = tagLine(static_cast<size_t>(state.range(0)));
+    tokenizer::Tokenizer tokenizer;
+    std::vector<std::string_view> words;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tokenizer.tokenize(line, words));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * line.size()));
+}
+BENCHMARK(BM_Tokenize)->Apply(lineSizes);
+
+// Owned strings like parseWords returns, in the order of the line.
+void BM_TokenizeStrings(benchmark::State& state) {
+    std::string line = tagLine(static_cast<size_t>(state.range(0)));
+    tokenizer::Tokenizer tokenizer;
+    for (auto _ : state) {
+        std::vector<std::string> words;
+        benchmark::DoNotOptimize(tokenizer.tokenize(line, words));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * line.size()));
+}
+BENCHMARK(BM_TokenizeStrings)->Apply(lineSizes);
+
+} // namespace
@@ -1,15 +1,20 @@
 #pragma once
 #include "logger.h"
+#include "trace.h"
 
 #include <nlohmann/json.hpp>
 
 #include <algorithm> // for iter_swap
+#include <chrono>
 #include <iostream> // for cin
 #include <stdio.h>
 #include <string>
 #include <unordered_set>
 #include <vector>
 #include <fstream>
+#include <iterator>     // for std::forward_iterator_tag
+#include <string_view>
+#include <unordered_map>
 
 namespace note {
 
@@ -25,6 +30,8 @@ struct NoteData {
     std::string content{};
     std::vector<NoteId> tags{};
     std::vector<NoteId> kids{};
+    uint64_t modified{0};   // store version of the last change, orders notes by recency
+    bool placeholder{false};    // made for a reference to a missing title, until the note itself is written
 };
 
 /**
@@ -37,7 +44,121 @@ struct NoteDataStrings {
     std::vector<std::string> kids{};
 };
 
-std::ostream& operator<<(std::ostream& os, const NoteDataStrings& note) {
+/**
+ * The titles of a tag or kid list, looked up in the store as they are read:
+ * nothing is copied, the string_views point into the store's notes.
+ *
+ * example:
+ *      for (std::string_view tag : store.getNoteView(id).tags) out.write(tag);
+ */
+class TitleRange {
+public:
+    using Notes = std::unordered_map<NoteId, NoteData>;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+
+        iterator() = default;
+        iterator(const Notes* notes, const NoteId* id) : notes(notes), id(id) {}
+
+        std::string_view operator*() const { return notes->at(*id).title; }
+        iterator& operator++() noexcept {
+            ++id;
+            return *this;
+        }
+        iterator operator++(int) noexcept {
+            iterator before = *this;
+            ++id;
+            return before;
+        }
+        bool operator==(const iterator& other) const noexcept { return id == other.id; }
+
+    private:
+        const Notes* notes{nullptr};
+        const NoteId* id{nullptr};
+    };
+
+    TitleRange() = default;
+    TitleRange(const Notes& notes, const std::vector<NoteId>& ids) : notes(&notes), list(&ids) {}
+
+    iterator begin() const noexcept { return list ? iterator(notes, list->data()) : iterator(); }
+    iterator end() const noexcept { return list ? iterator(notes, list->data() + list->size()) : iterator(); }
+    size_t size() const noexcept { return list ? list->size() : 0; }
+    bool empty() const noexcept { return size() == 0; }
+    std::string_view operator[](size_t i) const { return notes->at((*list)[i]).title; }
+    // the ids behind the titles
+    const std::vector<NoteId>& ids() const noexcept {
+        static const std::vector<NoteId> none;
+        return list ? *list : none;
+    }
+
+private:
+    const Notes* notes{nullptr};
+    const std::vector<NoteId>* list{nullptr};
+};
+
+/**
+ * A note as views into the NoteStore, the read-only counterpart of
+ * NoteDataStrings without a single copy.
+ * * Valid until the next change of the store: every change bumps the store's
+ *   version, 'NoteStore::isCurrent' tells if the view may still be read.
+ * * A view of a missing note is empty, 'id' is then 0.
+ */
+struct NoteDataView {
+    NoteId id{0};
+    std::string_view title;
+    std::string_view content;
+    TitleRange tags;
+    TitleRange kids;
+    uint64_t version{0};    // the store version it was taken at
+};
+
+/**
+ * Memory held by a NoteStore, in bytes. Strings count their heap buffer (none
+ * while they fit the small string buffer), hash tables a guess of the node
+ * overhead plus their bucket arrays.
+ */
+struct MemoryStats {
+    size_t notes{0};
+    size_t placeholders{0}; // notes made by a reference to a missing title, never written themselves
+    size_t edges{0};        // tag links, every one is also a kid link
+    size_t titleBytes{0};   // note titles in use
+    size_t contentBytes{0}; // note contents in use
+    size_t indexBytes{0};   // title index keys in use
+    size_t listBytes{0};    // tag and kid ids in use
+    size_t tableBytes{0};   // nodes and buckets of the notes map and the title index
+    size_t slackBytes{0};   // capacity of the strings and lists beyond their size
+
+    size_t totalBytes() const noexcept {
+        return titleBytes + contentBytes + indexBytes + listBytes + tableBytes + slackBytes;
+    }
+};
+
+// heap bytes of a string in use and beyond its size, none while it fits the small string buffer
+inline size_t usedBytes(const std::string& s) noexcept {
+    static const size_t small = std::string().capacity();
+    return s.capacity() > small ? s.size() + 1 : 0;
+}
+inline size_t slackBytes(const std::string& s) noexcept {
+    static const size_t small = std::string().capacity();
+    return s.capacity() > small ? s.capacity() - s.size() : 0;
+}
+
+// streamed straight from the store, unlike NoteDataStrings nothing is concatenated first
+inline std::ostream& operator<<(std::ostream& os, const NoteDataView& note) {
+    os << "Title: " << note.title << "\n  tags: ";
+    for (std::string_view tag : note.tags) os << tag << ", ";
+    os << "\n  content: \n    " << note.content << "\n  kids: ";
+    for (std::string_view kid : note.kids) os << kid << ", ";
+    return os << std::endl;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const NoteDataStrings& note) {
     std::string tags;
     for(const auto& tag: note.tags) tags += tag + ", ";
     std::string kids;
@@ -51,6 +172,7 @@ std::ostream& operator<<(std::ostream& os, const NoteDataStrings& note) {
 /**
  * Class to manage note data objects.
  * next_id: 'NoteId's start from 1 so we can use 0 as an empty value.
+ * version: bumped by every change, caches built from the store compare against it.
  */
 class NoteStore {
 private:
@@ -58,19 +180,83 @@ private:
     std::unordered_map<std::string, NoteId> title_to_id;
     // std::unordered_map<NoteId, std::vector<std::string>> kids;
     NoteId next_id {1};
+    uint64_t version_ {0};
+    std::chrono::steady_clock::duration loadTime{};
+    std::chrono::steady_clock::duration saveTime{};
+    // everything but the table sizes, kept up to date by every change of 'data' and 'title_to_id'
+    MemoryStats usage;
+
+    // applies 'op(total, bytes)' to every total of 'usage' that 'note' adds to
+    template<typename Op>
+    static void account(MemoryStats& stats, const NoteData& note, Op op) noexcept {
+        op(stats.placeholders, note.placeholder ? 1 : 0);
+        op(stats.edges, note.tags.size());
+        op(stats.titleBytes, usedBytes(note.title));
+        op(stats.contentBytes, usedBytes(note.content));
+        op(stats.listBytes, (note.tags.size() + note.kids.size()) * sizeof(NoteId));
+        op(stats.slackBytes, slackBytes(note.title) + slackBytes(note.content) +
+                             (note.tags.capacity() - note.tags.size() +
+                              note.kids.capacity() - note.kids.size()) * sizeof(NoteId));
+    }
+    void count(const NoteData& note) noexcept {
+        account(usage, note, [](size_t& total, size_t bytes) { total += bytes; });
+    }
+    void uncount(const NoteData& note) noexcept {
+        account(usage, note, [](size_t& total, size_t bytes) { total -= bytes; });
+    }
+    void countKey(const std::string& key) noexcept {
+        usage.indexBytes += usedBytes(key);
+        usage.slackBytes += slackBytes(key);
+    }
 
-    // ensure a stable NoteId for notes and tags
-    NoteId getId(const std::string& title) {
+    // runs 'change' on 'note' and moves the accounting from the old to the new note
+    template<typename Change>
+    void modify(NoteData& note, Change&& change) {
+        uncount(note);
+        change();
+        count(note);
+    }
+
+    // hash map nodes: the value, the next pointer and, for string keys, the cached hash
+    size_t tableBytes() const noexcept {
+        constexpr size_t noteNode = sizeof(std::pair<const NoteId, NoteData>) + sizeof(void*);
+        constexpr size_t indexNode = sizeof(std::pair<const std::string, NoteId>) + 2 * sizeof(void*);
+        return data.size() * noteNode + data.bucket_count() * sizeof(void*) +
+               title_to_id.size() * indexNode + title_to_id.bucket_count() * sizeof(void*);
+    }
+
+    // 'ids' are the notes titled 'titles', in order, without adding any missing title
+    bool sameIds(const std::vector<NoteId>& ids, const std::vector<std::string>& titles) const {
+        if (ids.size() != titles.size()) return false;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (findId(titles[i]) != ids[i]) return false;
+        }
+        return true;
+    }
+
+    // ensure a stable NoteId for notes and tags, a new title gets a placeholder
+    // note stamped with 'version': the version of the change that needs it
+    NoteId getId(const std::string& title, uint64_t version) {
         if (auto it = title_to_id.find(title); it != title_to_id.end()) {
-            LOG_DEBUG() << "found id for: " << title << ", id: " << it->second;
+            LOG_EVERY_N(DEBUG, 1000) << "found id for: " << title << ", id: " << it->second;
             return it->second;
         }
         NoteId id = next_id++;
-        LOG_DEBUG() << "adding title: " << title << ", id: " << id;
-        title_to_id.emplace(title, id);
-        data[id] = {title, ""};  // placeholder
+        LOG_EVERY_N(DEBUG, 1000) << "adding title: " << title << ", id: " << id;
+        countKey(title_to_id.emplace(title, id).first->first);
+        NoteData& note = data[id];
+        note = {title, "", {}, {}, version, true};
+        count(note);
         return id;
     };
+
+    // a placeholder made here is a change of its own
+    NoteId getId(const std::string& title) {
+        NoteId next = next_id;
+        NoteId id = getId(title, version_ + 1);
+        if (next_id != next) ++version_;
+        return id;
+    }
 public:
     NoteStore(std::string storage_path) {
         LOG_DEBUG() << "loading NoteStore from path: " << storage_path;
@@ -87,7 +273,17 @@ public:
         throw std::out_of_range("Error!  Could not find: " + title + " in title_to_id!");
     };
 
+    /**
+     * Returns 0 instead of throwing when 'title' is not in the store.
+     */
+    NoteId findId(const std::string& title) const {
+        auto it = title_to_id.find(title);
+        return it != title_to_id.end() ? it->second : 0;
+    }
+
     bool load_json_file(std::string json_file) {
+        TRACE_SCOPE("load_json_file");
+        auto start = std::chrono::steady_clock::now();
         std::ifstream file(json_file);
         if (!file.is_open()) {
             LOG_ERROR() << "Failed to open file: " << json_file;
@@ -116,23 +312,31 @@ public:
             }
             auto [it, inserted] = data.try_emplace(this_id);
             auto& n = it->second;
-            n.title = title;
-            n.content = content;
-            n.tags = tag_ids;
+            modify(n, [&] {
+                n.title = title;
+                n.content = content;
+                n.tags = tag_ids;
+                n.placeholder = false;
+            });
+            n.modified = ++version_;
             title_to_id[title] = this_id;
-            LOG_DEBUG() << "imported note: \n" << getNoteStrings(this_id);
+            LOG_DEBUG() << "imported note: \n" << getNoteView(this_id);
             // add this title to the tags' kids
             for (const auto& tag : tags) {
                 LOG_DEBUG() << "adding " << title << " as a kid to " << tag;
-                NoteId tag_id = getId(tag);
-                data[tag_id].kids.emplace_back(this_id);
+                NoteData& tag_note = data[getId(tag)];
+                modify(tag_note, [&] { tag_note.kids.emplace_back(this_id); });
             }
         }
+        ++version_;
+        loadTime = std::chrono::steady_clock::now() - start;
 
         return true;
     }
 
     void save_json_file(std::string json_file) {
+        TRACE_SCOPE("save_json_file");
+        auto start = std::chrono::steady_clock::now();
         std::ofstream outfile(json_file);
         if (!outfile.is_open()) {
             LOG_ERROR() << "Could not open file for writing!\n";
@@ -147,12 +351,11 @@ public:
             };
 
             std::vector<std::string> tags;
-            NoteData tag;
+            tags.reserve(value.second.tags.size());
             for (const auto& tag_id : value.second.tags) {
-                tag = getNote(tag_id);
-                tags.emplace_back(tag.title);
+                tags.emplace_back(getNote(tag_id).title);
             }
-            json_note["tags"] = tags;
+            json_note["tags"] = std::move(tags);
 
             json_array.push_back(json_note);
         }
@@ -161,6 +364,7 @@ public:
         if (!outfile) {
             LOG_ERROR() << "Write failed\n";
         }
+        saveTime = std::chrono::steady_clock::now() - start;
     }
 
     /**
@@ -173,6 +377,54 @@ public:
         addNote(title, content, tags, {});
     }
 
+    /**
+     * NoteIds are handed out densely from 1 to 'lastId()', so the store can be
+     * scanned in id ranges (ex: by a background search) without holding iterators.
+     */
+    NoteId lastId() const noexcept { return next_id - 1; }
+    uint64_t version() const noexcept { return version_; }
+    size_t size() const noexcept { return data.size(); }
+
+    // durations of the last successful load and the last save, zero if none yet
+    std::chrono::steady_clock::duration lastLoadDuration() const noexcept { return loadTime; }
+    std::chrono::steady_clock::duration lastSaveDuration() const noexcept { return saveTime; }
+
+    /**
+     * Memory held by the store, kept up to date by every change: no scan of the notes.
+     * Changes through the non-const 'getNote' and 'getKids' references are not seen.
+     */
+    MemoryStats memoryStats() const noexcept {
+        MemoryStats stats = usage;
+        stats.notes = data.size();
+        stats.tableBytes = tableBytes();
+        return stats;
+    }
+
+    /**
+     * 'memoryStats' counted again from every note, to check the running totals.
+     */
+    MemoryStats recountMemoryStats() const {
+        MemoryStats stats;
+        for (const auto& [id, note] : data) {
+            account(stats, note, [](size_t& total, size_t bytes) { total += bytes; });
+        }
+        for (const auto& [title, id] : title_to_id) {
+            stats.indexBytes += usedBytes(title);
+            stats.slackBytes += slackBytes(title);
+        }
+        stats.notes = data.size();
+        stats.tableBytes = tableBytes();
+        return stats;
+    }
+
+    /**
+     * Returns nullptr instead of throwing when 'id' is not in the store.
+     */
+    const NoteData* findNote(NoteId id) const {
+        auto it = data.find(id);
+        return it != data.end() ? &it->second : nullptr;
+    }
+
     const NoteData& getNote(const NoteId& id) const {return data.at(id);}
     NoteData& getNote(const NoteId& id) {return data.at(id);}
     const NoteData& getNote(const std::string& title) const {
@@ -184,20 +436,40 @@ public:
         return getNote(id);
     }
 
-    NoteDataStrings getNoteStrings(const NoteId& id) {
-        std::string title;
-        std::string content;
-        std::vector<std::string> tags;
-        std::vector<std::string> kids;
+    /**
+     * The note with its tags and kids as titles, built in place: one allocation
+     * per string that doesn't fit the small string buffer, one per list.
+     */
+    NoteDataStrings getNoteStrings(const NoteId& id) const {
+        NoteDataStrings strings;
+        if (const auto& search = data.find(id); search != data.end()) {
+            const NoteData& note = search->second;
+            strings.title = note.title;
+            strings.content = note.content;
+            strings.tags.reserve(note.tags.size());
+            for (const auto& tag: note.tags) strings.tags.emplace_back(getNote(tag).title);
+            strings.kids.reserve(note.kids.size());
+            for (const auto& kid: note.kids) strings.kids.emplace_back(getNote(kid).title);
+        }
+        return strings;
+    }
+
+    /**
+     * The note with its tags and kids as views into the store, no copy at all.
+     * Read it before the next change of the store, see NoteDataView.
+     */
+    NoteDataView getNoteView(NoteId id) const {
+        NoteDataView view;
         if (const auto& search = data.find(id); search != data.end()) {
-            title = search->second.title;
-            content = search->second.content;
-            for (const auto& tag: search->second.tags) tags.emplace_back(getNote(tag).title);
-            for (const auto& kid: search->second.kids) kids.emplace_back(getNote(kid).title);
+            const NoteData& note = search->second;
+            view = {id, note.title, note.content, TitleRange(data, note.tags), TitleRange(data, note.kids), version_};
         }
-        return {title, content, tags, kids};
+        return view;
     }
 
+    // 'view' was taken at the current version, nothing it points to changed since
+    bool isCurrent(const NoteDataView& view) const noexcept { return view.version == version_; }
+
     NoteDataStrings getNoteStrings(const std::string& title) {
         NoteId id = getId(title);
         return getNoteStrings(id);
@@ -207,21 +479,30 @@ public:
                  std::string content,
                  std::vector<std::string> tags,
                  std::vector<std::string> kids) {
-        NoteId id = getId(title);
+        // one change: the note, its new tags and kids get the same version
+        uint64_t version = version_ + 1;
+        NoteId id = getId(title, version);
         LOG_DEBUG() << "adding note: " << title << ", id: " << id;
 
         //convert tags and kids into NoteIds
         std::vector<NoteId> tag_ids;
-        for (const auto& tag : tags) tag_ids.emplace_back(getId(tag));
+        tag_ids.reserve(tags.size());
+        for (const auto& tag : tags) tag_ids.emplace_back(getId(tag, version));
         std::vector<NoteId> kid_ids;
-        for (const auto& kid: kids) kid_ids.emplace_back(getId(kid));
-        data[id] = NoteData{title, content, tag_ids, kid_ids};
+        kid_ids.reserve(kids.size());
+        for (const auto& kid: kids) kid_ids.emplace_back(getId(kid, version));
+        NoteData& note = data[id];
+        modify(note, [&] {
+            note = NoteData{std::move(title), std::move(content), std::move(tag_ids), std::move(kid_ids), version};
+        });
+        version_ = version;
 
         // add 'this' as a kid to its tags
         NoteId tag_id;
         for (const auto& tag : tags) {
-            tag_id = getId(tag);
-            data[tag_id].kids.emplace_back(id);
+            tag_id = getId(tag, version);
+            NoteData& tag_note = data[tag_id];
+            modify(tag_note, [&] { tag_note.kids.emplace_back(id); });
             LOG_DEBUG() << "added: " << id << ", as a kid to note: " << getNote(tag_id).title;
             LOG_DEBUG() << "kids[0]: " << getNote(tag_id).kids[0];
         }
@@ -232,32 +513,49 @@ public:
                     const std::string& content,
                     const std::vector<std::string>& tags,
                     const std::vector<std::string>& kids) {
+        TRACE_SCOPE("updateNote");
         auto& note = getNote(id);
         bool title_changed = (note.title != new_title ? true : false);
 
-        std::vector<NoteId> tag_ids;
-        for (const auto& tag : tags) tag_ids.emplace_back(getId(tag));
-        std::vector<NoteId> kid_ids;
-        for (const auto& kid : kids) kid_ids.emplace_back(getId(kid));
-        // check if new data is exactly the same as the old
-        if ((note.title == new_title) && (note.content == content) && 
-            (note.tags == tag_ids) && (note.kids == kid_ids)) {
+        // check if new data is exactly the same as the old, before building anything
+        if (!title_changed && (note.content == content) &&
+            sameIds(note.tags, tags) && sameIds(note.kids, kids)) {
             return;
         }
 
-        LOG_DEBUG() << "update_note: \n" << getNoteStrings(id);
+        // new tags and kids get the version of this change
+        uint64_t version = version_ + 1;
+        std::vector<NoteId> tag_ids;
+        tag_ids.reserve(tags.size());
+        for (const auto& tag : tags) tag_ids.emplace_back(getId(tag, version));
+        std::vector<NoteId> kid_ids;
+        kid_ids.reserve(kids.size());
+        for (const auto& kid : kids) kid_ids.emplace_back(getId(kid, version));
+
+        LOG_RATE_LIMITED(DEBUG, std::chrono::seconds(1)) << "update_note: \n" << getNoteView(id);
         // update the children of a tag, removing old_title, adding the new_title
         if (title_changed) {
             for (const auto& tag_id : tag_ids) {
-                auto it = std::find(data[tag_id].kids.begin(), data[tag_id].kids.end(), id);
-                if (it != data.at(tag_id).kids.end()) {
-                    std::iter_swap(it, data[tag_id].kids.end() - 1); // Move target to end
-                    data[tag_id].kids.pop_back();                    // Remove it
-                }
-                data[tag_id].kids.emplace_back(id);
+                NoteData& tag_note = data[tag_id];
+                modify(tag_note, [&] {
+                    auto it = std::find(tag_note.kids.begin(), tag_note.kids.end(), id);
+                    if (it != tag_note.kids.end()) {
+                        std::iter_swap(it, tag_note.kids.end() - 1); // Move target to end
+                        tag_note.kids.pop_back();                    // Remove it
+                    }
+                    tag_note.kids.emplace_back(id);
+                });
             }
         }
-        data[id] = {new_title, content, tag_ids, kid_ids};
+        // assigned in place, the strings keep their buffers when the new text fits
+        modify(note, [&] {
+            note.title = new_title;
+            note.content = content;
+            note.tags = std::move(tag_ids);
+            note.kids = std::move(kid_ids);
+            note.placeholder = false;
+        });
+        note.modified = version_ = version;
     }
 
     std::vector<NoteId>& getKids(std::string title) {
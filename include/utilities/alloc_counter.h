@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>  // for std::size_t, std::max_align_t
+#include <cstdlib>  // for std::malloc(), std::aligned_alloc(), std::free()
+#include <new>      // for std::bad_alloc, std::align_val_t, std::nothrow_t
+
+/**
+ * Counting replacements for the global allocation functions, the plain,
+ * array, aligned and nothrow forms. Every 'operator new' bumps a per-thread
+ * counter, so a thread can measure how many heap allocations a piece of code
+ * made without seeing allocations from other threads (ex: the logger thread).
+ *
+ * The replacement functions are not inline, so include this header from
+ * exactly one translation unit of a binary.
+ *
+ * example:
+ *      alloc_counter::Scope scope;
+ *      renderNotes(ctx);
+ *      assert(scope.allocations() == 0);
+ */
+namespace alloc_counter {
+
+inline thread_local std::size_t t_allocations = 0;
+inline thread_local std::size_t t_bytes = 0;
+
+inline std::size_t allocations() noexcept { return t_allocations; }
+inline std::size_t bytes() noexcept { return t_bytes; }
+
+/**
+ * Remembers the counters at construction, reports what was allocated since.
+ */
+class Scope {
+private:
+    std::size_t start_allocations;
+    std::size_t start_bytes;
+public:
+    Scope() noexcept : start_allocations(t_allocations), start_bytes(t_bytes) {}
+
+    std::size_t allocations() const noexcept { return t_allocations - start_allocations; }
+    std::size_t bytes() const noexcept { return t_bytes - start_bytes; }
+
+    void reset() noexcept {
+        start_allocations = t_allocations;
+        start_bytes = t_bytes;
+    }
+};
+
+// nullptr when out of memory, over-aligned blocks come from aligned_alloc, free() releases both
+inline void* counted_alloc(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) noexcept {
+    ++t_allocations;
+    t_bytes += size;
+    if (size == 0) size = 1;
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+    // aligned_alloc takes a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+inline void* counted_new(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+    if (void* p = counted_alloc(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace alloc_counter
+
+// Not inlined: a free() inlined at a call site next to the new-expression it
+// pairs with trips -Wmismatched-new-delete.
+#define ALLOC_COUNTER_REPLACEMENT __attribute__((noinline))
+
+ALLOC_COUNTER_REPLACEMENT void* operator new(std::size_t size) { return alloc_counter::counted_new(size); }
+ALLOC_COUNTER_REPLACEMENT void* operator new[](std::size_t size) { return alloc_counter::counted_new(size); }
+ALLOC_COUNTER_REPLACEMENT void* operator new(std::size_t size, std::align_val_t al) {
+    return alloc_counter::counted_new(size, static_cast<std::size_t>(al));
+}
+ALLOC_COUNTER_REPLACEMENT void* operator new[](std::size_t size, std::align_val_t al) {
+    return alloc_counter::counted_new(size, static_cast<std::size_t>(al));
+}
+ALLOC_COUNTER_REPLACEMENT void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc_counter::counted_alloc(size);
+}
+ALLOC_COUNTER_REPLACEMENT void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc_counter::counted_alloc(size);
+}
+ALLOC_COUNTER_REPLACEMENT void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return alloc_counter::counted_alloc(size, static_cast<std::size_t>(al));
+}
+ALLOC_COUNTER_REPLACEMENT void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return alloc_counter::counted_alloc(size, static_cast<std::size_t>(al));
+}
+
+ALLOC_COUNTER_REPLACEMENT void operator delete(void* p) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete[](void* p) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+ALLOC_COUNTER_REPLACEMENT void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cerrno>       // for errno, EINTR
+#include <charconv>     // for std::to_chars
+#include <cstdint>
+#include <cstring>      // for std::memcpy
+#include <memory>       // for std::unique_ptr
+#include <string>
+#include <string_view>
+#include <unistd.h>     // for ::write
+
+/**
+ * Collects output in one large buffer and hands it to a file descriptor with
+ * as few 'write' calls as possible, unlike std::cout there is no locale,
+ * sync_with_stdio or per-line flushing in the way.
+ * * Writes larger than the buffer bypass it.
+ * * After a failed write (ex: EPIPE when the reader went away) 'ok' returns
+ *   false and further output is discarded.
+ * * The destructor flushes.
+ *
+ * example:
+ *      BufferedWriter out;         // stdout
+ *      out.write("id: ");
+ *      out.number(42);
+ *      out.put('\n');
+ */
+class BufferedWriter {
+public:
+    static constexpr size_t defaultCapacity = 1 << 20;
+
+    explicit BufferedWriter(int fd = 1, size_t capacity = defaultCapacity) :
+        fd(fd), capacity(capacity), buffer(new char[capacity]) {}
+
+    ~BufferedWriter() { flush(); }
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool ok() const noexcept { return ok_; }
+    size_t buffered() const noexcept { return used; }
+
+    void write(std::string_view text) {
+        if (text.empty()) return;
+        if (text.size() > capacity - used) {
+            flush();
+            if (text.size() >= capacity) {
+                writeAll(text.data(), text.size());
+                return;
+            }
+        }
+        std::memcpy(buffer.get() + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    void put(char c) {
+        if (used == capacity) flush();
+        buffer[used++] = c;
+    }
+
+    void number(uint64_t value) {
+        char digits[20];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        write(std::string_view(digits, static_cast<size_t>(end - digits)));
+    }
+
+    void flush() {
+        if (used == 0) return;
+        writeAll(buffer.get(), used);
+        used = 0;
+    }
+
+private:
+    int fd;
+    size_t capacity;
+    std::unique_ptr<char[]> buffer;
+    size_t used{0};
+    bool ok_{true};
+
+    void writeAll(const char* data, size_t size) {
+        while (ok_ && size > 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                ok_ = false;
+                return;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+};
+
+/**
+ * Same interface as BufferedWriter, appends to a string instead of a file descriptor.
+ */
+class StringWriter {
+public:
+    explicit StringWriter(std::string& target) : target(target) {}
+
+    bool ok() const noexcept { return true; }
+    void write(std::string_view text) { target.append(text); }
+    void put(char c) { target.push_back(c); }
+    void number(uint64_t value) {
+        char digits[20];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        target.append(digits, static_cast<size_t>(end - digits));
+    }
+    void flush() {}
+
+private:
+    std::string& target;
+};
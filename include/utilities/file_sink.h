@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cerrno>       // for errno, EINTR
+#include <chrono>
+#include <cstdio>       // for std::rename, std::remove
+#include <cstring>      // for std::memcpy
+#include <memory>       // for std::unique_ptr
+#include <string>
+#include <string_view>
+#include <fcntl.h>      // for ::open
+#include <spawn.h>      // for posix_spawnp
+#include <sys/stat.h>   // for ::fstat
+#include <sys/wait.h>   // for ::waitpid
+#include <unistd.h>     // for ::write, ::fdatasync, ::close
+
+extern char** environ;
+
+struct FileSinkOptions {
+    size_t bufferSize = 1 << 20;        // userspace buffer
+    size_t flushBytes = 256 * 1024;     // flush once this much is buffered
+    std::chrono::milliseconds flushInterval{1000};  // or once the oldest buffered line is this old
+    size_t rotateBytes = 0;             // start a new file at this size, 0: never
+    std::chrono::seconds rotateInterval{0}; // or after this long, 0: never
+    size_t keepFiles = 5;               // rotated files kept as <path>.1 (newest) ... <path>.<keepFiles>
+    bool compress = false;              // gzip rotated files in a background process
+    bool sync = false;                  // fdatasync after every flush
+};
+
+/**
+ * Appends lines to a log file through a large userspace buffer.
+ * * The buffer is written out when it holds 'flushBytes', when its oldest line is
+ *   'flushInterval' old (checked on every write and by 'flushIfDue'), and right
+ *   away for urgent lines (the Logger marks ERROR messages urgent).
+ * * Rotation renames <path> to <path>.1, shifting older files up, and opens a new
+ *   <path>. With 'compress' the rotated file is gzipped by a child process.
+ * * Not thread-safe, the Logger only uses it from its own thread.
+ *
+ * example:
+ *      FileSink sink;
+ *      sink.open("notewiki.log", {.rotateBytes = 64 << 20, .compress = true});
+ *      sink.write("a line", false);
+ */
+class FileSink {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FileSink() = default;
+    ~FileSink() { close(); }
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    bool open(const std::string& path, FileSinkOptions options = {}) {
+        close();
+        this->path = path;
+        this->options = options;
+        if (options.bufferSize == 0) this->options.bufferSize = 1;
+        buffer.reset(new char[this->options.bufferSize]);
+        return openFile();
+    }
+
+    void close() {
+        if (fd < 0) return;
+        flush();
+        ::close(fd);
+        fd = -1;
+        waitForCompression();
+    }
+
+    bool isOpen() const noexcept { return fd >= 0; }
+    const std::string& filePath() const noexcept { return path; }
+    size_t buffered() const noexcept { return used; }
+
+    /**
+     * Appends 'line' and a newline.
+     */
+    void write(std::string_view line, bool urgent) {
+        if (fd < 0) return;
+        Clock::time_point now = Clock::now();
+        if (used == 0) oldest = now;
+        append(line);
+        append("\n");
+        if (urgent || used >= options.flushBytes || now - oldest >= options.flushInterval) flush();
+        if (rotationDue(now)) rotate();
+    }
+
+    // Flushes if the oldest buffered line is older than 'flushInterval'.
+    void flushIfDue() {
+        if (used > 0 && Clock::now() - oldest >= options.flushInterval) flush();
+        reapCompression();
+    }
+
+    void flush() {
+        if (fd < 0 || used == 0) return;
+        writeAll(buffer.get(), used);
+        fileBytes += used;
+        used = 0;
+        if (options.sync) ::fdatasync(fd);
+    }
+
+    void rotate() {
+        if (fd < 0) return;
+        flush();
+        ::close(fd);
+        fd = -1;
+        // the previous child may still be reading <path>.1
+        waitForCompression();
+
+        std::string suffix = options.compress ? ".gz" : "";
+        std::remove(rotatedName(options.keepFiles, suffix).c_str());
+        for (size_t i = options.keepFiles; i > 1; --i) {
+            std::rename(rotatedName(i - 1, suffix).c_str(), rotatedName(i, suffix).c_str());
+        }
+        if (options.keepFiles == 0) {
+            std::remove(path.c_str());
+        } else {
+            std::string rotated = rotatedName(1, "");
+            std::rename(path.c_str(), rotated.c_str());
+            if (options.compress) compress(rotated);
+        }
+        openFile();
+    }
+
+private:
+    std::string path;
+    FileSinkOptions options;
+    std::unique_ptr<char[]> buffer;
+    size_t used{0};
+    size_t fileBytes{0};
+    int fd{-1};
+    Clock::time_point opened;
+    Clock::time_point oldest;   // when the first buffered line came in
+    pid_t compressor{-1};
+
+    bool openFile() {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        struct stat st{};
+        fileBytes = ::fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+        opened = Clock::now();
+        return true;
+    }
+
+    std::string rotatedName(size_t index, const std::string& suffix) const {
+        return path + "." + std::to_string(index) + suffix;
+    }
+
+    void append(std::string_view text) {
+        while (!text.empty()) {
+            if (used == options.bufferSize) flush();
+            size_t n = std::min(text.size(), options.bufferSize - used);
+            std::memcpy(buffer.get() + used, text.data(), n);
+            used += n;
+            text.remove_prefix(n);
+        }
+    }
+
+    void writeAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;     // nowhere left to report it, the line is lost
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    bool rotationDue(Clock::time_point now) const {
+        if (options.rotateBytes > 0 && fileBytes + used >= options.rotateBytes) return true;
+        return options.rotateInterval.count() > 0 && now - opened >= options.rotateInterval;
+    }
+
+    void compress(const std::string& file) {
+        char gzip[] = "gzip";
+        char force[] = "-f";
+        std::string target = file;
+        char* argv[] = {gzip, force, target.data(), nullptr};
+        if (::posix_spawnp(&compressor, "gzip", nullptr, nullptr, argv, environ) != 0) compressor = -1;
+    }
+
+    void reapCompression() {
+        if (compressor > 0 && ::waitpid(compressor, nullptr, WNOHANG) != 0) compressor = -1;
+    }
+
+    void waitForCompression() {
+        if (compressor > 0) ::waitpid(compressor, nullptr, 0);
+        compressor = -1;
+    }
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>    // for std::min, std::sort
+#include <atomic>       // for std::atomic_ref
+#include <cstdint>
+#include <cstring>      // for std::memcpy, std::memcmp
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>      // for ::open
+#include <sys/mman.h>   // for ::mmap, ::munmap
+#include <sys/stat.h>   // for ::fstat
+#include <unistd.h>     // for ::ftruncate, ::close
+
+// One record read back from a flight recorder file.
+struct FlightRecord {
+    uint64_t seq;           // 1 for the first record ever written
+    int64_t timestamp;      // nanoseconds since the epoch, system clock
+    uint64_t thread;        // low 16 bits of the thread id hash, as in thread_id_to_hex
+    uint8_t level;          // a LogLevel
+    std::string args;       // log_args encoded message, may be cut short
+};
+
+/**
+ * A ring of fixed size records in a memory mapped file, written by the logging
+ * threads themselves: no formatting, no queue, no system call per record.
+ * * The mapping is shared, so the kernel keeps the records when the process dies,
+ *   'load' reads them back after a crash or from a live process.
+ * * Writers claim slots with one fetch_add, a slot's sequence number is zeroed while
+ *   it is written, readers drop slots that changed under them.
+ * * Messages longer than a slot are cut, log_args decoding stops at the cut.
+ *
+ * example:
+ *      FlightRecorder recorder;
+ *      recorder.open("notewiki.flight", 1 << 16);
+ *      recorder.record(level, timestamp_ns, thread, args);
+ *      std::vector<FlightRecord> last = FlightRecorder::load("notewiki.flight", 100, error);
+ */
+class FlightRecorder {
+public:
+    static constexpr char magic[8] = {'N', 'W', 'F', 'L', 'I', 'G', 'H', 'T'};
+    static constexpr uint32_t version = 1;
+    static constexpr size_t headerSize = 64;
+    static constexpr size_t slotHeaderSize = 32;
+
+    FlightRecorder() = default;
+    ~FlightRecorder() { close(); }
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    /**
+     * Maps 'path' sized for 'slots' records of 'slotSize' bytes, starting a new ring
+     * unless the file already holds one of the same shape.
+     */
+    bool open(const std::string& path, size_t slots = 1 << 16, size_t slotSize = 256) {
+        close();
+        if (slots == 0 || slotSize <= slotHeaderSize || slotSize > slotHeaderSize + UINT16_MAX) return false;
+        slotSize = (slotSize + 7) & ~size_t{7};     // keeps the sequence numbers aligned
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        size_t size = headerSize + slots * slotSize;
+        struct stat st{};
+        bool reuse = ::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == size;
+        // a new ring starts from a zeroed file
+        if ((!reuse && ::ftruncate(fd, 0) != 0) || ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        base = static_cast<char*>(mapped);
+        mappedSize = size;
+        if (!reuse || !sameShape(base, slots, slotSize)) {
+            std::memset(base, 0, size);
+            std::memcpy(base, magic, sizeof(magic));
+            put<uint32_t>(base + 8, version);
+            put<uint32_t>(base + 12, static_cast<uint32_t>(slotSize));
+            put<uint64_t>(base + 16, slots);
+        }
+        slotCount = slots;
+        this->slotSize = slotSize;
+        return true;
+    }
+
+    void close() {
+        if (base) ::munmap(base, mappedSize);
+        base = nullptr;
+        mappedSize = 0;
+        slotCount = 0;
+    }
+
+    bool isOpen() const noexcept { return base != nullptr; }
+
+    // Records one message, lock free and safe to call from any thread.
+    void record(uint8_t level, int64_t timestamp, uint64_t thread, std::string_view args) noexcept {
+        if (!base) return;
+        uint64_t seq = std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(base + 24))
+                           .fetch_add(1, std::memory_order_relaxed) + 1;
+        char* slot = base + headerSize + ((seq - 1) % slotCount) * slotSize;
+        std::atomic_ref<uint64_t> slotSeq(*reinterpret_cast<uint64_t*>(slot));
+        slotSeq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        size_t length = std::min(args.size(), slotSize - slotHeaderSize);
+        put<int64_t>(slot + 8, timestamp);
+        put<uint64_t>(slot + 16, thread);
+        put<uint8_t>(slot + 24, level);
+        put<uint16_t>(slot + 26, static_cast<uint16_t>(length));
+        std::memcpy(slot + slotHeaderSize, args.data(), length);
+        slotSeq.store(seq, std::memory_order_release);
+    }
+
+    // Records 'text' as a single log_args string without allocating, ex: from a signal handler.
+    void recordText(uint8_t level, int64_t timestamp, uint64_t thread, std::string_view text) noexcept {
+        char args[128];
+        uint32_t length = static_cast<uint32_t>(std::min(text.size(), sizeof(args) - 5));
+        args[0] = 5;    // log_args::ArgType::String
+        std::memcpy(args + 1, &length, sizeof(length));
+        std::memcpy(args + 5, text.data(), length);
+        record(level, timestamp, thread, std::string_view(args, 5 + length));
+    }
+
+    /**
+     * Reads the last 'count' records of the file at 'path', oldest first.
+     * Returns nothing and sets 'error' if it is not a flight recorder file.
+     */
+    static std::vector<FlightRecord> load(const std::string& path, size_t count, std::string& error) {
+        std::vector<FlightRecord> records;
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st{};
+        if (fd < 0 || ::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < headerSize) {
+            error = "cannot read " + path;
+            if (fd >= 0) ::close(fd);
+            return records;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            error = "cannot map " + path;
+            return records;
+        }
+        const char* data = static_cast<const char*>(mapped);
+        uint32_t slotSize = get<uint32_t>(data + 12);
+        uint64_t slots = get<uint64_t>(data + 16);
+        if (std::memcmp(data, magic, sizeof(magic)) != 0 || get<uint32_t>(data + 8) != version ||
+            slotSize <= slotHeaderSize || slots == 0 || headerSize + slots * slotSize != size) {
+            error = path + " is not a flight recorder file";
+            ::munmap(mapped, size);
+            return records;
+        }
+
+        records.reserve(std::min<uint64_t>(slots, count));
+        for (uint64_t i = 0; i < slots; ++i) {
+            const char* slot = data + headerSize + i * slotSize;
+            std::atomic_ref<uint64_t> slotSeq(*reinterpret_cast<uint64_t*>(const_cast<char*>(slot)));
+            uint64_t seq = slotSeq.load(std::memory_order_acquire);
+            if (seq == 0) continue;
+            FlightRecord record{seq, get<int64_t>(slot + 8), get<uint64_t>(slot + 16), get<uint8_t>(slot + 24), {}};
+            size_t length = std::min<size_t>(get<uint16_t>(slot + 26), slotSize - slotHeaderSize);
+            record.args.assign(slot + slotHeaderSize, length);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slotSeq.load(std::memory_order_relaxed) != seq) continue;   // rewritten while copying
+            records.push_back(std::move(record));
+        }
+        ::munmap(mapped, size);
+
+        std::sort(records.begin(), records.end(),
+                  [](const FlightRecord& a, const FlightRecord& b) { return a.seq < b.seq; });
+        if (records.size() > count) records.erase(records.begin(), records.end() - static_cast<ptrdiff_t>(count));
+        return records;
+    }
+
+private:
+    char* base{nullptr};
+    size_t mappedSize{0};
+    size_t slotCount{0};
+    size_t slotSize{0};
+
+    template<typename T>
+    static void put(char* at, T value) noexcept { std::memcpy(at, &value, sizeof(value)); }
+
+    template<typename T>
+    static T get(const char* at) noexcept {
+        T value;
+        std::memcpy(&value, at, sizeof(value));
+        return value;
+    }
+
+    static bool sameShape(const char* data, size_t slots, size_t slotSize) {
+        return std::memcmp(data, magic, sizeof(magic)) == 0 && get<uint32_t>(data + 8) == version &&
+               get<uint32_t>(data + 12) == slotSize && get<uint64_t>(data + 16) == slots;
+    }
+};
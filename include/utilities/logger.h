@@ -1,22 +1,34 @@
 #pragma once
 
-// remote logging dependencies
-#include <arpa/inet.h>          // for sockaddr_in, htons(), inet_pton()
-#include <cstring>              // for strerror(), strlen()
-#include <sys/socket.h>         // for AF_INET, SOCK_STREAM, socket(), send()
-// other
+#include <array>
 #include <atomic>               // for std::atomic<>
+#include <charconv>             // for std::to_chars()
+#include <cmath>                // for std::isfinite()
 #include <chrono>               // for std::put_time(), std::setfill(), std::setw(), 
 #include <condition_variable>   // for std::condition_variable
-#include <fstream>              // for std::ofstream
+#include <csignal>              // for sigaction(), raise()
+#include <cstring>              // for std::memcpy()
+#include <cstdio>               // for std::snprintf()
+#include <ctime>                // for localtime_r(), strftime()
 #include <functional>           // for std::function
+#include <limits>               // for std::numeric_limits
 #include <iostream>             // for std::cout
+#include <memory>               // for std::shared_ptr, std::unique_ptr
 #include <mutex>                // for std::mutex, std::lock_guard<>
 #include <queue>                // for std::priority_queue
 #include <sstream>              // for std::ostringstream
 #include <thread>               // for std::thread
+#include <type_traits>
+#include <unordered_map>
+#include <utility>              // for std::swap()
+#include <vector>
+#include <unistd.h>             // for isatty()
 
+#include "file_sink.h"          // for FileSink
+#include "flight_recorder.h"    // for FlightRecorder
+#include "remote_sink.h"        // for RemoteSink
 #include "thread_id.h"          // for thread_id_to_hex()
+#include "trace.h"              // for TRACE_SCOPE
 #include "color.h"              // for terminal colors.
 
 // an enum for various levels of logging
@@ -27,8 +39,50 @@ enum struct LogLevel : uint8_t {
     DEBUG
 };
 
-// a buffer size for remote server response
-#define BUFFER_SIZE 1024
+// The least severe level compiled into the program, set from CMake with
+// NOTEWIKI_LOG_MIN_LEVEL. Call sites below it are removed by the LOG_* macros,
+// ex: -DLOG_MIN_LEVEL=1 keeps ERROR and WARNING only.
+#ifndef LOG_MIN_LEVEL
+    #define LOG_MIN_LEVEL 3
+#endif
+
+// false if messages at 'level' can never be logged by this build.
+// DEBUG messages also need DEBUGGING.
+constexpr bool logCompiledIn(LogLevel level) {
+#ifndef DEBUGGING
+    if (level == LogLevel::DEBUG) return false;
+#endif
+    return static_cast<int>(level) <= LOG_MIN_LEVEL;
+}
+
+// Per call site state of LOG_EVERY_N and LOG_RATE_LIMITED.
+class LogSampler {
+public:
+    // true for the 1st, (n+1)th, (2n+1)th... call
+    bool everyN(uint64_t n) noexcept {
+        return n <= 1 || count.fetch_add(1, std::memory_order_relaxed) % n == 0;
+    }
+
+    // true at most once per 'interval', concurrent callers race for the slot
+    bool atMostEvery(std::chrono::nanoseconds interval) noexcept {
+        int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        int64_t next = nextAllowed.load(std::memory_order_relaxed);
+        if (now < next) return false;
+        return nextAllowed.compare_exchange_strong(next, now + interval.count(), std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t> nextAllowed{std::numeric_limits<int64_t>::min()};
+};
+
+// What a thread does when its log ring buffer is full:
+// BLOCK waits for the logger thread, the DROP_* policies count the dropped message.
+enum struct OverflowPolicy : uint8_t {
+    BLOCK,
+    DROP_NEWEST,
+    DROP_OLDEST
+};
 
 // LogMessage object that includes a log level, timestamp, message, thread id, 
 // and supports comparison based on timestamp
@@ -37,6 +91,7 @@ struct LogMessage {
     std::chrono::system_clock::time_point timestamp;
     std::string message;
     std::thread::id thread_id;
+    std::string args{};     // deferred formatting: encoded arguments, see 'log_args', formatted on the logger thread
 
     bool operator<(const LogMessage& other) const {
         return timestamp < other.timestamp;
@@ -48,6 +103,230 @@ struct LogMessage {
     }
 };
 
+// Compact binary encoding of the values streamed into a log message, so the
+//   text formatting can happen on the logger thread.
+// * Every value is a type byte followed by its raw bytes, strings carry a length.
+// * Decoding prints values the way an std::ostream with default flags would.
+// * A key before a value makes it a structured field, kept out of the message text.
+namespace log_args {
+
+enum class ArgType : uint8_t { Int, UInt, Double, Bool, Char, String, Key };
+static_assert(static_cast<uint8_t>(ArgType::String) == 5, "FlightRecorder::recordText writes 5");
+
+template<typename T>
+inline constexpr bool encodable =
+    std::is_arithmetic_v<T> || std::is_convertible_v<const T&, std::string_view>;
+
+inline void encodeString(std::string& out, std::string_view text) {
+    uint32_t length = static_cast<uint32_t>(text.size());
+    out.push_back(static_cast<char>(ArgType::String));
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.append(text);
+}
+
+template<typename T>
+inline void encode(std::string& out, const T& value) {
+    static_assert(encodable<T>);
+    auto raw = [&out](ArgType type, const auto& v) {
+        out.push_back(static_cast<char>(type));
+        out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    };
+    if constexpr (std::is_same_v<T, bool>) {
+        raw(ArgType::Bool, static_cast<uint8_t>(value));
+    } else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+        raw(ArgType::Char, static_cast<char>(value));
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        raw(ArgType::Int, static_cast<int64_t>(value));
+    } else if constexpr (std::is_integral_v<T>) {
+        raw(ArgType::UInt, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        raw(ArgType::Double, static_cast<double>(value));
+    } else if constexpr (std::is_pointer_v<T>) {
+        encodeString(out, value ? std::string_view(value) : std::string_view("(null)"));
+    } else {
+        encodeString(out, std::string_view(value));
+    }
+}
+
+// Marks the next value as the field 'key', see 'logField'.
+inline void encodeKey(std::string& out, std::string_view key) {
+    uint32_t length = static_cast<uint32_t>(key.size());
+    out.push_back(static_cast<char>(ArgType::Key));
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.append(key);
+}
+
+// One decoded value, 'key' is empty for values of the message text.
+struct Arg {
+    ArgType type;
+    std::string_view key;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        bool b;
+        char c;
+    };
+    std::string_view text;
+};
+
+// Calls 'fn(const Arg&)' for every value in 'args', stops at malformed input.
+template<typename F>
+inline void forEach(std::string_view args, F&& fn) {
+    auto read = [&args](auto& v) {
+        if (args.size() < sizeof(v)) return false;
+        std::memcpy(&v, args.data(), sizeof(v));
+        args.remove_prefix(sizeof(v));
+        return true;
+    };
+    auto readText = [&](std::string_view& text) {
+        uint32_t length;
+        if (!read(length) || args.size() < length) return false;
+        text = args.substr(0, length);
+        args.remove_prefix(length);
+        return true;
+    };
+    Arg arg{};
+    while (!args.empty()) {
+        arg.type = static_cast<ArgType>(args.front());
+        args.remove_prefix(1);
+        bool ok = false;
+        switch (arg.type) {
+            case ArgType::Int: ok = read(arg.i); break;
+            case ArgType::UInt: ok = read(arg.u); break;
+            case ArgType::Double: ok = read(arg.d); break;
+            case ArgType::Bool: {
+                uint8_t v;
+                ok = read(v);
+                arg.b = v != 0;
+                break;
+            }
+            case ArgType::Char: ok = read(arg.c); break;
+            case ArgType::String: ok = readText(arg.text); break;
+            case ArgType::Key:
+                if (!readText(arg.key)) return;
+                continue;
+        }
+        if (!ok) return;
+        fn(arg);
+        arg.key = {};
+    }
+}
+
+// Appends the text of one value the way an std::ostream with default flags would.
+inline void appendText(const Arg& arg, std::string& out) {
+    char buffer[32];
+    switch (arg.type) {
+        case ArgType::Int: out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), arg.i).ptr); break;
+        case ArgType::UInt: out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), arg.u).ptr); break;
+        case ArgType::Double: out.append(buffer, static_cast<size_t>(std::snprintf(buffer, sizeof(buffer), "%g", arg.d))); break;
+        case ArgType::Bool: out.push_back(arg.b ? '1' : '0'); break;
+        case ArgType::Char: out.push_back(arg.c); break;
+        case ArgType::String: out.append(arg.text); break;
+        default: break;
+    }
+}
+
+// Appends the text of all values in 'args' to 'out', fields follow as " key=value".
+inline void decode(std::string_view args, std::string& out) {
+    bool fields = false;
+    forEach(args, [&](const Arg& arg) {
+        if (arg.key.empty()) appendText(arg, out);
+        else fields = true;
+    });
+    if (!fields) return;
+    forEach(args, [&](const Arg& arg) {
+        if (arg.key.empty()) return;
+        out.push_back(' ');
+        out.append(arg.key);
+        out.push_back('=');
+        appendText(arg, out);
+    });
+}
+
+// Appends 'text' as a quoted JSON string.
+inline void appendJsonString(std::string_view text, std::string& out) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    size_t plain = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(text.substr(plain, i - plain));
+        plain = i + 1;
+        switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                out.append("\\u00");
+                out.push_back(hex[c >> 4]);
+                out.push_back(hex[c & 0xf]);
+        }
+    }
+    out.append(text.substr(plain));
+    out.push_back('"');
+}
+
+// Appends one value as JSON: numbers and booleans bare, the rest as strings.
+// Doubles get the shortest text that reads back to the same value, not the 6 digits of the text format.
+inline void appendJson(const Arg& arg, std::string& out) {
+    switch (arg.type) {
+        case ArgType::Double: {
+            if (!std::isfinite(arg.d)) {
+                out.append("null");
+                return;
+            }
+            char buffer[32];
+            out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), arg.d).ptr);
+            break;
+        }
+        case ArgType::Int:
+        case ArgType::UInt:
+            appendText(arg, out);
+            break;
+        case ArgType::Bool: out.append(arg.b ? "true" : "false"); break;
+        case ArgType::Char: appendJsonString(std::string_view(&arg.c, 1), out); break;
+        default: appendJsonString(arg.text, out); break;
+    }
+}
+
+// Appends ',"key":value' for every field in 'args'.
+inline void decodeJsonFields(std::string_view args, std::string& out) {
+    forEach(args, [&](const Arg& arg) {
+        if (arg.key.empty()) return;
+        out.push_back(',');
+        appendJsonString(arg.key, out);
+        out.push_back(':');
+        appendJson(arg, out);
+    });
+}
+
+} // namespace log_args
+
+// A structured field of a log message, kept out of the text and written as a
+// key of its own by JSON_LINES outputs.
+//      ex.: LOG_INFO() << "opened note" << logField("id", id);
+template<typename T>
+struct LogField {
+    std::string_view key;
+    const T& value;
+};
+
+template<typename T>
+LogField<T> logField(std::string_view key, const T& value) {
+    return {key, value};
+}
+
+// Layout of the lines of an output:
+// TEXT is "timestamp [LEVEL] [þr:id] message key=value", JSON_LINES one JSON object per line.
+enum struct LogFormat : uint8_t {
+    TEXT,
+    JSON_LINES
+};
+
 // A thread-safe priority queue to send messages to, so working threads aren't
 //   blocked from slow I/O
 // A priority queue with std::greater<T> means the smallest time/oldest timestamp gets
@@ -96,6 +375,80 @@ public:
     }
 };
 
+// A bounded ring buffer filled by a single producer thread, the Logger keeps
+//   one per logging thread so producers never share a lock.
+// * Slots carry sequence numbers (as in Dmitry Vyukov's bounded queue), poppers
+//   claim slots with a CAS, so the producer may pop too, ex: to drop its oldest
+//   message when the ring is full.
+// * Pushes and pops swap items with the slots instead of moving them, so what a
+//   popper leaves in a slot goes back to the producer, ex: a string's capacity.
+// * The capacity is rounded up to a power of two.
+template<typename T>
+class ThreadRingBuffer {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> head{0};    // next slot to pop
+    alignas(64) size_t tail{0};                 // next slot to push, producer only
+
+    static size_t roundUp(size_t n) {
+        size_t capacity = 2;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
+    }
+
+public:
+    explicit ThreadRingBuffer(size_t capacity) : mask(roundUp(capacity) - 1), slots(new Slot[mask + 1]) {
+        for (size_t i = 0; i <= mask; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const noexcept { return mask + 1; }
+
+    // Producer only. Swaps 'item' with the slot's leftover only if there was room.
+    // 'item' must hold a valid value either way, ex: not an uninitialized int.
+    bool try_push(T& item) {
+        Slot& slot = slots[tail & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != tail) return false;
+        using std::swap;
+        swap(slot.item, item);
+        slot.sequence.store(tail + 1, std::memory_order_release);
+        ++tail;
+        return true;
+    }
+
+    // Swaps the item with 'out', whose old value is left in the slot: 'out' must
+    // hold a valid value, it goes back into the ring.
+    bool try_pop(T& out) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    using std::swap;
+                    swap(out, slot.item);
+                    slot.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // empty
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool empty() const {
+        size_t pos = head.load(std::memory_order_acquire);
+        return slots[pos & mask].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+};
+
 #ifdef LOGGER_TEST_HOOKS
 using LogTestObserver = void(*)(const LogMessage&);
 inline std::atomic<LogTestObserver> g_testObserver{nullptr}; // internal linkage
@@ -107,6 +460,9 @@ inline void setLogTestObserver(LogTestObserver cb) {
 // Logger class is a singleton, so should only be constructed once.
 // default: logging to console: true, logging to file: false.
 // * The processing of the logs is in its own thread so as not to delay other threads
+// * Every logging thread writes into its own ThreadRingBuffer, the logger thread
+//   drains them and merges the messages by timestamp. What happens when a ring is
+//   full is set with 'setOverflowPolicy'.
 // * Along with the macros defined below allows the use of the '<<' operator:
 //      ex.: LOG_INFO() << "variable: " << var;
 // * Timestamp format can be customized with 'setTimestampFormatter'
@@ -116,31 +472,67 @@ public:
 
     // Helper class, allows using << for a log message.
     // Nested so it has access to Loggers' functions.
+    // * Numbers and strings are stored with 'log_args::encode', not formatted here.
+    // * The first value of another type (ex: a manipulator or a class with its own
+    //   operator<<) creates an ostringstream, everything after it is formatted there.
+    // * 'logField' values are encoded with their key, see LogField.
+    // * The encoding goes into a buffer recycled through the thread's ring, so once
+    //   the buffers are warm a message allocates nothing on the calling thread.
     class LogStream {
     private:
         Logger& logger;
-        std::ostringstream oss;
         LogLevel level;
+        bool enabled;
         std::chrono::system_clock::time_point timestamp;
+        std::string args;
+        std::unique_ptr<std::ostringstream> fallback;
 
     public:
         LogStream(Logger& logger, LogLevel level) :
-            logger(logger), level(level), timestamp(std::chrono::system_clock::now()) {}
+            logger(logger), level(level), enabled(logger.isLoggingLevel(level)),
+            timestamp(enabled ? std::chrono::system_clock::now() : std::chrono::system_clock::time_point{}) {
+            if (enabled) args = logger.recycledArgs();
+        }
 
         // Overload << operator to accumulate strings/variables.
         template<typename T>
         LogStream& operator<<(const T& msg) {
-            if (logger.isLoggingLevel(level)) {
-                oss << msg;
+            if (!enabled) return *this;
+            if constexpr (log_args::encodable<T>) {
+                if (!fallback) {
+                    log_args::encode(args, msg);
+                    return *this;
+                }
+            }
+            if (!fallback) fallback = std::make_unique<std::ostringstream>();
+            *fallback << msg;
+            return *this;
+        }
+
+        // Fields end the ostringstream of the text so far, the text goes on after them.
+        template<typename T>
+        LogStream& operator<<(const LogField<T>& field) {
+            if (!enabled) return *this;
+            if (fallback) {
+                log_args::encodeString(args, fallback->view());
+                fallback.reset();
+            }
+            log_args::encodeKey(args, field.key);
+            if constexpr (log_args::encodable<T>) {
+                log_args::encode(args, field.value);
+            } else {
+                std::ostringstream text;
+                text << field.value;
+                log_args::encodeString(args, text.view());
             }
             return *this;
         }
 
         // Destructor sends accumulated message to logger
         ~LogStream() {
-            if (logger.isLoggingLevel(level)) {
-                logger.logMessage(level, timestamp, oss.str());
-            }
+            if (!enabled) return;
+            if (fallback) log_args::encodeString(args, fallback->view());
+            logger.logMessage(level, timestamp, std::move(args));
         }
     };
 
@@ -157,6 +549,9 @@ public:
         logToConsole = enable;
     }
 
+    // Console lines are colored by level, by default only when stdout is a terminal.
+    void setConsoleColor(bool enable) noexcept { consoleColor = enable; }
+
     /**
      * @brief Enables or disables file logging.
      * 
@@ -164,50 +559,107 @@ public:
      * Call this function during the setup phase or ensure it is properly synchronized if called at runtime.
      * 
      * @param filename The filename to log to. If empty, disables file logging.
+     * @param options buffering, flushing and rotation of the file, see FileSink.
+     * @param format TEXT lines or JSON_LINES records for log shippers.
      */
-    void enableFileLogging(const std::string& filename) {
+    void enableFileLogging(const std::string& filename, FileSinkOptions options = {},
+                           LogFormat format = LogFormat::TEXT) {
+        std::lock_guard<std::mutex> lock(outputMtx);
         // If an empty string is given, it is a call to disable file logging
         if (filename.empty()) {
-            if (fileStream.is_open()) {
-                fileStream.close();
-            }
+            fileSink.close();
             logToFile = false;
-            this->filename.clear();
         } else {
-            // Close the current file if we are opening a new file
-            if (fileStream.is_open() && filename != this->filename) {
-                fileStream.close();
-            }
-            // Open the new file
-            fileStream.open(filename, std::ios::out | std::ios::app);
-            if (!fileStream) {
+            if (!fileSink.open(filename, options)) {
+                logToFile = false;
+                updateStructuredOutput();
                 throw std::runtime_error("Unable to open file: " + filename);
             }
+            fileFormat = format;
             logToFile = true;
-            this->filename = filename;
         }
+        updateStructuredOutput();
     }
 
+    // Messages at this level or more severe are flushed to the log file right away,
+    // ERROR always is.
+    void setFileFlushLevel(LogLevel level) noexcept { fileFlushLevel = level; }
+
     /**
      * @brief Enables remote logging with a valid IP addres or disables remote logging with an empty string
      * 
-     * This function is not thread-safe and should not be called concurrently from multiple threads.
-     * Call this function during the setup phase or ensure it is properly synchronized if called at runtime.
+     * Lines are sent in batches from the logger thread, see RemoteSink. The connection
+     * is made in the background and retried with backoff, logging never blocks on it.
      * 
      * @param ip_address string with a valid IP address, or empty string to disable remote logging
      * @param port the port to use for the remote connection
+     * @param format TEXT lines or JSON_LINES records for log shippers.
+     * @return false if 'ip_address' is not a valid IPv4 address
      */
-    void enableServerLogging(std::string ip_address = "127.0.0.1", int port = 8080) {
-        std::lock_guard<std::mutex> lock(serverMtx);
-        close_socket();
-        if (ip_address.empty()) {
-            logToServer = false;
-            return;
-        }
-        setup_socket();
-        setup_address(ip_address, port);
-        connect_address();
+    bool enableServerLogging(std::string ip_address = "127.0.0.1", int port = 8080,
+                             RemoteSinkOptions options = {}, LogFormat format = LogFormat::TEXT) {
+        std::lock_guard<std::mutex> lock(outputMtx);
+        remoteSink.close();
+        logToServer = false;
+        updateStructuredOutput();
+        if (ip_address.empty()) return true;
+        if (!remoteSink.open(ip_address, port, options)) return false;
+        remoteFormat = format;
         logToServer = true;
+        updateStructuredOutput();
+        return true;
+    }
+
+    // Lines the remote sink could not keep while the server was slow or away.
+    uint64_t droppedRemoteLines() {
+        std::lock_guard<std::mutex> lock(outputMtx);
+        return remoteSink.droppedLines();
+    }
+
+    // true if a message at 'level' would be logged now, the LOG_* macros check it
+    // before evaluating any operand. The flight recorder takes every level.
+    bool isLoggingLevel(LogLevel level) const {
+        if (!logCompiledIn(level)) return false;
+        return flightRecording.load(std::memory_order_relaxed) || isOutputLevel(level);
+    }
+
+    /**
+     * @brief Enables or disables the flight recorder.
+     *
+     * Every message, whatever the log level, is also copied by the logging thread into a
+     * memory mapped ring of 'slots' records at 'path', see FlightRecorder. Messages below
+     * the log level go nowhere else. Read the file with notewiki_flightdump.
+     *
+     * Like 'enableFileLogging' call it during setup, not while other threads log.
+     *
+     * @param path the ring file, if empty, disables the flight recorder.
+     * @return false if the file could not be created or mapped
+     */
+    bool enableFlightRecorder(const std::string& path, size_t slots = 1 << 16) {
+        flightRecording = false;
+        recorder.close();
+        if (path.empty()) return true;
+        if (!recorder.open(path, slots)) return false;
+        flightRecording = true;
+        return true;
+    }
+
+    /**
+     * @brief Flushes the logs when the program crashes.
+     *
+     * On SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT the signal is recorded in the
+     * flight recorder, the logger thread gets up to a second to write out the queued
+     * messages and flush the log file, then the previous handler is restored and the
+     * signal raised again. Best effort: the crashed thread may hold a lock it needs.
+     */
+    void installCrashHandlers() {
+        struct sigaction action{};
+        action.sa_handler = &Logger::onCrash;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_NODEFER;
+        for (size_t i = 0; i < crashSignals.size(); ++i) {
+            sigaction(crashSignals[i], &action, &previousCrashActions()[i]);
+        }
     }
 
     // Used by the LOG_* macros below to allow '<<' operation.
@@ -218,213 +670,489 @@ public:
     // Allows customizing the timestamp.
     // To reset formatter to default use 'nullptr' as input
     void setTimestampFormatter(TimestampFormatter formatter) {
-        std::lock_guard<std::mutex> lock(queueMtx);
+        std::lock_guard<std::mutex> lock(outputMtx);
         this->formatter = formatter;
     }
 
     // To ensure that the queue is empty before manipulating the logger
     void waitForQueueToEmpty() {
         std::unique_lock<std::mutex> lock(queueMtx);
-        queueCv.wait(lock, [this] { return logQueue.empty(); });
+        emptyCv.wait(lock, [this] { return !busy && buffersEmpty(); });
     }
 
     void setLogLevel(LogLevel lvl) noexcept { loglevel_ = lvl; }
+    LogLevel getLogLevel() const noexcept { return loglevel_; }
+
+    void setOverflowPolicy(OverflowPolicy policy) noexcept { overflowPolicy = policy; }
+
+    // On (the default): messages are formatted on the logger thread.
+    // Off: they are formatted on the calling thread, before they are queued.
+    void setDeferredFormatting(bool enable) noexcept { deferredFormatting = enable; }
+
+    // Ring size for threads that log for the first time after this call.
+    void setThreadBufferCapacity(size_t capacity) noexcept { threadBufferCapacity = capacity; }
+
+    // Messages lost to the DROP_* overflow policies since the start.
+    uint64_t droppedMessages() {
+        std::lock_guard<std::mutex> lock(registryMtx);
+        return droppedTotal + droppedInRegistry();
+    }
 
 private:
     Logger() : logToConsole(true),
                logToFile(false),
                logToServer(false),
-               active_socket(-1),
                done(false) {
         loggerThread = std::thread(&Logger::processQueue, this);
     }
 
     ~Logger() {
         done = true;
-        queueCv.notify_all();
+        wakeLogger();
         if (loggerThread.joinable()) {
             loggerThread.join();
         }
-        if (fileStream.is_open()) {
-            fileStream.close();
+        fileSink.close();
+        remoteSink.drain(std::chrono::milliseconds(200));
+    }
+
+    // A logging thread's ring, registered with the logger on its first message.
+    // The registry keeps it until it is drained after the thread exited.
+    struct ThreadBuffer {
+        explicit ThreadBuffer(size_t capacity) : ring(capacity) {}
+        ThreadRingBuffer<LogMessage> ring;
+        LogMessage spare;   // owning thread only, what the last push got back from the ring
+        std::atomic<uint64_t> dropped{0};   // written by the owning thread only
+        std::atomic<bool> orphaned{false};  // the owning thread has exited
+    };
+
+    struct ThreadBufferHandle {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~ThreadBufferHandle() {
+            if (buffer) buffer->orphaned.store(true, std::memory_order_release);
         }
+    };
+
+    ThreadBuffer& threadBuffer() {
+        thread_local ThreadBufferHandle handle;
+        if (!handle.buffer) {
+            handle.buffer = std::make_shared<ThreadBuffer>(threadBufferCapacity.load(std::memory_order_relaxed));
+            std::lock_guard<std::mutex> lock(registryMtx);
+            registry.push_back(handle.buffer);
+            registryVersion.fetch_add(1, std::memory_order_release);
+        }
+        return *handle.buffer;
+    }
+
+    // Strings larger than this are not recycled, one long message shouldn't pin
+    // its size in every slot it goes through.
+    static constexpr size_t maxRecycledBytes = 1024;
+
+    static void trimRecycled(std::string& text) {
+        if (text.capacity() > maxRecycledBytes) std::string().swap(text);
+        text.clear();
+    }
+
+    // The calling thread's spare argument buffer, empty, with the capacity of an older message.
+    std::string recycledArgs() {
+        std::string args = std::move(threadBuffer().spare.args);
+        trimRecycled(args);
+        return args;
     }
 
-    // Adds a LogMessage object to the log queue.
+    static void countDrop(ThreadBuffer& buffer) {
+        buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    bool isOutputLevel(LogLevel level) const {
+#ifdef DEBUGGING
+        if (level == LogLevel::DEBUG) {
+            return true;
+        }
+#endif
+        return (level <= loglevel_ ? true : false);
+    }
+
+    static constexpr std::array<int, 5> crashSignals{SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+    static std::array<struct sigaction, crashSignals.size()>& previousCrashActions() {
+        static std::array<struct sigaction, crashSignals.size()> actions{};
+        return actions;
+    }
+
+    static void onCrash(int sig) {
+        getInstance().flushForCrash(sig);
+        for (size_t i = 0; i < crashSignals.size(); ++i) {
+            if (crashSignals[i] == sig) sigaction(sig, &previousCrashActions()[i], nullptr);
+        }
+        raise(sig);
+    }
+
+    // Signal handler side of 'installCrashHandlers', only try_lock and sleeps.
+    void flushForCrash(int sig) {
+        if (flightRecording.load(std::memory_order_relaxed)) {
+            char text[] = "fatal signal 00";
+            text[sizeof(text) - 3] = static_cast<char>('0' + sig / 10 % 10);
+            text[sizeof(text) - 2] = static_cast<char>('0' + sig % 10);
+            auto now = std::chrono::system_clock::now().time_since_epoch();
+            recorder.recordText(static_cast<uint8_t>(LogLevel::ERROR),
+                                std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(),
+                                std::hash<std::thread::id>{}(std::this_thread::get_id()) & 0xffff,
+                                std::string_view(text, sizeof(text) - 1));
+        }
+        // no notify, it isn't async-signal-safe: the logger thread wakes up on its own within 100ms
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        bool drained = false;
+        while (!drained && std::chrono::steady_clock::now() < deadline) {
+            if (registryMtx.try_lock()) {
+                drained = true;
+                for (const auto& buffer : registry) drained = drained && buffer->ring.empty();
+                registryMtx.unlock();
+            }
+            // empty rings are not enough: a batch is popped before it is written.
+            // 'busy' stays set from before the pop until a drain finds nothing left.
+            drained = drained && !busy.load();
+            if (!drained) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (outputMtx.try_lock()) {
+                fileSink.flush();
+                std::cout.flush();
+                outputMtx.unlock();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Adds a LogMessage object to the calling thread's ring buffer.
+    // 'args' is encoded with 'log_args'. The message is built in the thread's
+    // spare one, whose strings the ring hands back after the logger wrote them.
     void logMessage(const LogLevel level,
                     const std::chrono::system_clock::time_point& timestamp,
-                    const std::string& message) {
+                    std::string args) {
         std::thread::id thread_id = std::this_thread::get_id();
-        LogMessage msg{level, timestamp, message, thread_id};
+        ThreadBuffer& buffer = threadBuffer();
+        LogMessage& msg = buffer.spare;
+        msg.args = std::move(args);
+        if (flightRecording.load(std::memory_order_relaxed)) {
+            recorder.record(static_cast<uint8_t>(level),
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count(),
+                            std::hash<std::thread::id>{}(thread_id) & 0xffff, msg.args);
+            if (!isOutputLevel(level)) return;
+        }
+        msg.level = level;
+        msg.timestamp = timestamp;
+        msg.thread_id = thread_id;
+        trimRecycled(msg.message);
+        bool deferred = deferredFormatting.load(std::memory_order_relaxed);
+        if (!deferred) log_args::decode(msg.args, msg.message);
+        // JSON_LINES outputs read the fields from the arguments, the text is kept as well
+        if (!deferred && !structuredOutput.load(std::memory_order_relaxed)) msg.args.clear();
 #ifdef LOGGER_TEST_HOOKS
-        if (auto cb = g_testObserver.load(std::memory_order_acquire)) cb(msg);
+        if (auto cb = g_testObserver.load(std::memory_order_acquire)) {
+            LogMessage seen = msg;
+            if (deferred) log_args::decode(seen.args, seen.message);
+            seen.args.clear();
+            cb(seen);
+        }
 #endif
+        if (!buffer.ring.try_push(msg)) {
+            switch (overflowPolicy.load(std::memory_order_relaxed)) {
+                case OverflowPolicy::BLOCK:
+                    do {
+                        wakeLogger();
+                        std::this_thread::yield();
+                    } while (!buffer.ring.try_push(msg));
+                    break;
+                case OverflowPolicy::DROP_NEWEST:
+                    countDrop(buffer);
+                    return;
+                case OverflowPolicy::DROP_OLDEST: {
+                    LogMessage oldest;
+                    while (!buffer.ring.try_push(msg)) {
+                        // the logger thread may free a slot first, then nothing is dropped
+                        if (buffer.ring.try_pop(oldest)) countDrop(buffer);
+                    }
+                    break;
+                }
+            }
+        }
+        // pairs with the fence in 'processQueue': either the logger sees this
+        // message before it sleeps, or this thread sees it sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) wakeLogger();
+    }
+
+    // outputMtx must be held
+    void updateStructuredOutput() {
+        structuredOutput = (logToFile && fileFormat == LogFormat::JSON_LINES) ||
+                           (logToServer && remoteFormat == LogFormat::JSON_LINES);
+    }
+
+    void wakeLogger() {
         std::lock_guard<std::mutex> lock(queueMtx);
-        logQueue.emplace(msg);
         queueCv.notify_one();
     }
 
-    // Helper function to format the timestamp.
-    std::string formatTimestamp(const std::chrono::system_clock::time_point& timestamp) const {
+    // registryMtx must be held
+    uint64_t droppedInRegistry() const {
+        uint64_t dropped = 0;
+        for (const auto& buffer : registry) dropped += buffer->dropped.load(std::memory_order_relaxed);
+        return dropped;
+    }
+
+    bool buffersEmpty() {
+        std::lock_guard<std::mutex> lock(registryMtx);
+        for (const auto& buffer : registry) {
+            if (!buffer->ring.empty()) return false;
+        }
+        return true;
+    }
+
+    // Helper function to format the timestamp, logger thread only.
+    // Default format "YYYY-MM-DD hh:mm:ss.mmm.uuu.nnn"
+    // (mmm is milliseconds, uuu is microseconds, nnn is nanoseconds)
+    // The date and time part is formatted once per second.
+    void appendTimestamp(std::string& out, const std::chrono::system_clock::time_point& timestamp) {
         if (formatter) {
-            return formatter(timestamp);
-        } else {
-            // Default format "YYYY-MM-DD hh:mm:ss.mmm.uuu.nnn" 
-            // (mmm is milliseconds, uuu is microseconds, nnn is nanoseconds)
-            auto duration = timestamp.time_since_epoch();
-            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
-            auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration) - 
-                std::chrono::duration_cast<std::chrono::milliseconds>(seconds);
-            auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration) - 
-                std::chrono::duration_cast<std::chrono::microseconds>(seconds + milliseconds);
-            auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration) - 
-                std::chrono::duration_cast<std::chrono::nanoseconds>(seconds + milliseconds + microseconds);
-
-            // Convert to time_t to get the time as a string
-            std::time_t time_t_seconds = std::chrono::system_clock::to_time_t(timestamp);
-            std::tm* tm = std::localtime(&time_t_seconds);
-
-            // Format the time as a string
-            std::ostringstream oss;
-            oss << std::put_time(tm, "%Y-%m-%d %H:%M:%S") << '.'
-                << std::setw(3) << std::setfill('0') << milliseconds.count() << '.'
-                << std::setw(3) << std::setfill('0') << microseconds.count() << '.'
-                << std::setw(3) << std::setfill('0') << nanoseconds.count();
-
-            return oss.str();
-        }
-    }
-
-    // Remote server connection helper functions.
-    void close_socket() {
-        if (active_socket != -1) {
-            close(active_socket);
-            active_socket = -1;
-        }
-    }
-
-    // Remote server basic socket setup.
-    void setup_socket() {
-        const int max_tries = 5;
-        int count = 0;
-        bool active = false;
-        while (!active && count < max_tries) {
-            if ((active_socket = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
-            }
-            else active = true;
-            ++count;
+            out += formatter(timestamp);
+            return;
         }
-        if (!active) {
-            std::cerr << "Creating a socket failed: " << strerror(errno) << ": " << active_socket;
-            exit(EXIT_FAILURE);
+        auto duration = timestamp.time_since_epoch();
+        auto seconds = std::chrono::floor<std::chrono::seconds>(duration);
+        if (seconds.count() != cachedSecond) {
+            cachedSecond = seconds.count();
+            std::time_t time_t_seconds = static_cast<std::time_t>(cachedSecond);
+            std::tm tm{};
+            localtime_r(&time_t_seconds, &tm);
+            char prefix[32];
+            size_t length = std::strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &tm);
+            cachedPrefix.assign(prefix, length);
+        }
+        out += cachedPrefix;
+
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration - seconds).count();
+        char fraction[12] = {'.', '0', '0', '0', '.', '0', '0', '0', '.', '0', '0', '0'};
+        for (int pos : {11, 10, 9, 7, 6, 5, 3, 2, 1}) {
+            fraction[pos] = static_cast<char>('0' + nanoseconds % 10);
+            nanoseconds /= 10;
         }
+        out.append(fraction, sizeof(fraction));
     }
 
-    // Remote server address setup.
-    void setup_address(std::string ip_address = "127.0.0.1", int port = 8080) {
-        address.sin_family = AF_INET;
-        // address.sin_addr.s_addr = INADDR_ANY;
-        address.sin_port = htons(port);
+    // The id of the thread in hex, logger thread only
+    const std::string& threadHex(std::thread::id id) {
+        auto it = threadHexes.find(id);
+        if (it == threadHexes.end()) {
+            // ids of exited threads pile up, start over once in a while
+            if (threadHexes.size() > 1024) threadHexes.clear();
+            it = threadHexes.emplace(id, thread_id_to_hex(id)).first;
+        }
+        return it->second;
+    }
 
-        // Converting IPv4 and IPv6 addresses from text to binary form
-        if (inet_pton(AF_INET, ip_address.c_str(), &address.sin_addr) <= 0) {
-            std::cerr << "Invalid address/ Address not supported";
-            exit(EXIT_FAILURE);
+    // "YYYY-MM-DDThh:mm:ss.nnnnnnnnnZ" in UTC, whatever the text formatter is, logger thread only
+    void appendIsoTimestamp(std::string& out, const std::chrono::system_clock::time_point& timestamp) {
+        auto duration = timestamp.time_since_epoch();
+        auto seconds = std::chrono::floor<std::chrono::seconds>(duration);
+        if (seconds.count() != cachedIsoSecond) {
+            cachedIsoSecond = seconds.count();
+            std::time_t time_t_seconds = static_cast<std::time_t>(cachedIsoSecond);
+            std::tm tm{};
+            gmtime_r(&time_t_seconds, &tm);
+            char prefix[32];
+            size_t length = std::strftime(prefix, sizeof(prefix), "%Y-%m-%dT%H:%M:%S.", &tm);
+            cachedIsoPrefix.assign(prefix, length);
         }
+        out += cachedIsoPrefix;
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration - seconds).count();
+        char fraction[10] = {'0', '0', '0', '0', '0', '0', '0', '0', '0', 'Z'};
+        for (int pos = 8; pos >= 0; --pos) {
+            fraction[pos] = static_cast<char>('0' + nanoseconds % 10);
+            nanoseconds /= 10;
+        }
+        out.append(fraction, sizeof(fraction));
     }
 
-    // Remote server connection.
-    void connect_address() {
-        // Connecting to the server
-        if (connect(active_socket, (struct sockaddr *)&address, sizeof(address)) < 0) {
-            std::cerr << "Connection Failed";
-            exit(EXIT_FAILURE);
+    // "timestamp [LEVEL] [þr:id] message key=value"
+    void formatText(const LogMessage& log, std::string& out) {
+        out.clear();
+        appendTimestamp(out, log.timestamp);
+        out += " [";
+        out += logLevelToString(log.level);
+        out += "] [þr:";
+        out += threadHex(log.thread_id);
+        out += "] ";
+        // formatted on the calling thread, the arguments may be kept for JSON outputs
+        if (!log.message.empty() || log.args.empty()) out += log.message;
+        else log_args::decode(log.args, out);
+    }
+
+    // {"ts":"...","level":"INFO","thread":"id","msg":"message","key":value}
+    void formatJson(const LogMessage& log, std::string& out) {
+        out.clear();
+        out += "{\"ts\":\"";
+        appendIsoTimestamp(out, log.timestamp);
+        out += "\",\"level\":\"";
+        out += logLevelToString(log.level);
+        out += "\",\"thread\":\"";
+        out += threadHex(log.thread_id);
+        out += "\",\"msg\":";
+        if (log.args.empty()) {
+            log_args::appendJsonString(log.message, out);
+        } else {
+            jsonText.clear();
+            log_args::forEach(log.args, [&](const log_args::Arg& arg) {
+                if (arg.key.empty()) log_args::appendText(arg, jsonText);
+            });
+            log_args::appendJsonString(jsonText, out);
+            log_args::decodeJsonFields(log.args, out);
         }
+        out += '}';
     }
 
-    // Send message to remote server.
-    void send_message(int active_socket, std::string message) {
-        if (active_socket < 0) {
-            std::cerr << "Trying to send a message to a non-socket: " << active_socket;
-            return;
+
+    // Writes one message to every enabled output, the console is flushed
+    // once per batch in 'drainBuffers', the file follows its own flush policy.
+    // Each format is built at most once, into a reused line.
+    void writeLog(const LogMessage& log) {
+        bool console = logToConsole, file = logToFile, server = logToServer;
+        bool text = console || (file && fileFormat == LogFormat::TEXT) || (server && remoteFormat == LogFormat::TEXT);
+        bool json = (file && fileFormat == LogFormat::JSON_LINES) || (server && remoteFormat == LogFormat::JSON_LINES);
+        if (text) formatText(log, line);
+        if (json) formatJson(log, jsonLine);
+
+        if (console) {
+            if (consoleColor) std::cout << logLevelToColor(log.level) << line << color::RESET << '\n';
+            else std::cout << line << '\n';
+        }
+        if (file) {
+            fileSink.write(fileFormat == LogFormat::TEXT ? line : jsonLine,
+                           log.level <= fileFlushLevel.load(std::memory_order_relaxed));
+        }
+        if (server) {
+            remoteSink.write(remoteFormat == LogFormat::TEXT ? line : jsonLine);
+        }
+    }
+
+    void flushOutputs() {
+        if (logToConsole) std::cout.flush();
+    }
+
+    // Re-reads the registry if threads came or went, and forgets drained rings of exited threads.
+    void refreshBuffers(std::vector<std::shared_ptr<ThreadBuffer>>& buffers, uint64_t& seen) {
+        std::lock_guard<std::mutex> lock(registryMtx);
+        for (auto it = registry.begin(); it != registry.end();) {
+            if ((*it)->orphaned.load(std::memory_order_acquire) && (*it)->ring.empty()) {
+                droppedTotal += (*it)->dropped.load(std::memory_order_relaxed);
+                it = registry.erase(it);
+                registryVersion.fetch_add(1, std::memory_order_release);
+            } else {
+                ++it;
+            }
         }
+        uint64_t version = registryVersion.load(std::memory_order_acquire);
+        if (version == seen) return;
+        seen = version;
+        buffers = registry;
+    }
 
-        // get thread id string
-        std::string id =  "[þr:" + thread_id_to_hex() + "] ";
+    // Takes what is in the rings and writes it out oldest first, returns the number of messages.
+    size_t drainBuffers(const std::vector<std::shared_ptr<ThreadBuffer>>& buffers,
+                        std::vector<std::vector<LogMessage>>& batches) {
+        using Head = std::pair<std::chrono::system_clock::time_point, size_t>;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        std::vector<size_t> next(buffers.size(), 0);
 
-        // Sending a message to the server
-        ssize_t sent_bytes = send(active_socket, message.c_str(), strlen(message.c_str()), 0);
-        if (sent_bytes == -1) {
-            std::cerr << "Failed to send message: " << strerror(errno);
-            exit(EXIT_FAILURE);
+        // the batches keep their messages between drains: popping swaps the
+        // ones written last time back into the rings, for the producers to reuse
+        batches.resize(buffers.size());
+        std::vector<size_t> sizes(buffers.size(), 0);
+        size_t total = 0;
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            auto& batch = batches[i];
+            // at most one ring's worth, so a thread blocked on a full ring can't starve the others
+            size_t limit = buffers[i]->ring.capacity();
+            size_t& size = sizes[i];
+            while (size < limit) {
+                if (size == batch.size()) batch.emplace_back();
+                if (!buffers[i]->ring.try_pop(batch[size])) break;
+                ++size;
+            }
+            if (size > 0) heads.emplace(batch.front().timestamp, i);
+            total += size;
         }
 
-        // Reading the server's response
-        ssize_t received_bytes = read(active_socket, buffer, BUFFER_SIZE);
-        if (received_bytes < 0) {
-            std::cerr << "Failed to read from server: " << strerror(errno);
-            exit(EXIT_FAILURE);
+        if (total == 0) return 0;
+
+        // k-way merge: every batch is already in timestamp order
+        // traced only when there is something to write, not on every idle wakeup
+        TRACE_SCOPE("logger_drain");
+        std::lock_guard<std::mutex> lock(outputMtx);
+        while (!heads.empty()) {
+            size_t i = heads.top().second;
+            heads.pop();
+            writeLog(batches[i][next[i]]);
+            if (++next[i] < sizes[i]) heads.emplace(batches[i][next[i]].timestamp, i);
         }
-        //buffer[received_bytes] = '\0'; // Null-terminate the buffer
-        //std::cout << id << "inside logger::send_message() response from server: " << buffer << ", bytes: " << received_bytes << "\n";
+        flushOutputs();
+        return total;
+    }
+
+    bool anyPending(const std::vector<std::shared_ptr<ThreadBuffer>>& buffers, uint64_t seen) const {
+        if (registryVersion.load(std::memory_order_acquire) != seen) return true;
+        for (const auto& buffer : buffers) {
+            if (!buffer->ring.empty()) return true;
+        }
+        return false;
     }
-    /* end of remote server connection functions*/
 
     // Function that loops in the Logger thread
     void processQueue() {
-        while (!done) {
-            std::unique_lock<std::mutex> lock(queueMtx);
-            queueCv.wait(lock, [this] { return !logQueue.empty() || done; });
+        Tracer::instance().setThreadName("logger");
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::vector<std::vector<LogMessage>> batches;
+        uint64_t seen = ~0ull;
+        uint64_t reported_drops = 0;
 
-            if (done && logQueue.empty()) {
-                break;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(queueMtx);
+                busy = true;
             }
+            refreshBuffers(buffers, seen);
+            size_t written = drainBuffers(buffers, batches);
 
-            while (!logQueue.empty()) {
-                const LogMessage& log = logQueue.top();
-                logQueue.pop();
-                lock.unlock();
-                std::chrono::system_clock::time_point timestamp = log.timestamp;
-                std::string message = log.message;
-                LogLevel level = log.level;
-                // get thread id string
-                std::string thread_id =  "[þr:" + thread_id_to_hex(log.thread_id) + "] ";
-
-                auto color = color::RED;
-                std::ostringstream output;
-                output << logLevelToColor(level) \
-                       << formatTimestamp(timestamp) \
-                       << " [" << logLevelToString(level) << "] " \
-                       << thread_id \
-                       << message \
-                       << color::RESET \
-                       ;
-
-                if (logToConsole) {
-                    std::cout << output.str() << std::endl;
-                }
-                if (logToFile && fileStream.is_open()) {
-                    fileStream << output.str() << std::endl;
-                }
-                if (logToServer && active_socket > 0) {
-                    send_message(active_socket, output.str());
-                }
-
-                lock.lock();
+            if (uint64_t drops = droppedMessages(); drops > reported_drops) {
+                std::lock_guard<std::mutex> lock(outputMtx);
+                writeLog({LogLevel::WARNING, std::chrono::system_clock::now(),
+                          "logger dropped " + std::to_string(drops - reported_drops) + " messages",
+                          std::this_thread::get_id()});
+                flushOutputs();
+                reported_drops = drops;
+            }
+            if (logToFile || logToServer) {
+                std::lock_guard<std::mutex> lock(outputMtx);
+                fileSink.flushIfDue();
+                remoteSink.poll();
             }
+            if (written > 0) continue;
+
+            std::unique_lock<std::mutex> lock(queueMtx);
+            busy = false;
             // let other threads know the queue is empty,
             // ex: threads waiting on waitForQueueToEmpty()
-            queueCv.notify_all();
-        }
-    }
+            emptyCv.notify_all();
+            if (done) break;
 
-    bool isLoggingLevel(LogLevel level) const {
-#ifdef DEBUGGING
-        if (level == LogLevel::DEBUG) {
-            return true;
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // the timeout also drives time based file flushes and the remote sink
+            queueCv.wait_for(lock, std::chrono::milliseconds(100),
+                             [&] { return done || anyPending(buffers, seen); });
+            sleeping.store(false, std::memory_order_relaxed);
         }
-#endif
-        return (level <= loglevel_ ? true : false);
     }
 
     // Helper function to return the log level color.
@@ -439,16 +1167,14 @@ private:
     }
 
     // Helper function to return the log level as a string
-    std::string logLevelToString(LogLevel level) const {
-        std::ostringstream oss;
+    std::string_view logLevelToString(LogLevel level) const {
         switch (level) {
-            case LogLevel::DEBUG: oss << "DEBUG"; break;
-            case LogLevel::INFO: oss << "INFO"; break;
-            case LogLevel::WARNING: oss << "WARNING"; break;
-            case LogLevel::ERROR: oss << "ERROR"; break;
-            default: break;
+            case LogLevel::DEBUG: return "DEBUG";
+            case LogLevel::INFO: return "INFO";
+            case LogLevel::WARNING: return "WARNING";
+            case LogLevel::ERROR: return "ERROR";
+            default: return "";
         }
-        return oss.str();
     }
 
     std::atomic<bool> done;
@@ -456,25 +1182,73 @@ private:
     std::atomic<bool> logToFile;
     std::atomic<bool> logToServer;
     std::atomic<LogLevel> loglevel_ = {LogLevel::WARNING};
-    std::ofstream fileStream;
-    std::string filename;
-    ThreadSafePriorityQueue<LogMessage> logQueue;
+    std::atomic<OverflowPolicy> overflowPolicy{OverflowPolicy::BLOCK};
+    std::atomic<bool> deferredFormatting{true};
+    std::atomic<size_t> threadBufferCapacity{4096};
+    std::atomic<LogLevel> fileFlushLevel{LogLevel::ERROR};
+    std::atomic<bool> consoleColor{isatty(STDOUT_FILENO) == 1};
+    FileSink fileSink;
+    FlightRecorder recorder;
+    std::atomic<bool> flightRecording{false};
+    LogFormat fileFormat{LogFormat::TEXT};      // guarded by 'outputMtx'
+    LogFormat remoteFormat{LogFormat::TEXT};    // guarded by 'outputMtx'
+    std::atomic<bool> structuredOutput{false};  // a JSON_LINES output is on, see 'logMessage'
+    // rings of all logging threads, guarded by 'registryMtx'
+    std::vector<std::shared_ptr<ThreadBuffer>> registry;
+    std::atomic<uint64_t> registryVersion{0};
+    uint64_t droppedTotal{0};   // drops of rings already removed from 'registry'
+    std::mutex registryMtx;
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> busy{false};  // the logger thread is draining, set under 'queueMtx'
     std::thread loggerThread;
     std::mutex queueMtx;
-    std::mutex serverMtx;
-    int active_socket;
-    struct sockaddr_in address;
-    char buffer[BUFFER_SIZE] = {0};
+    std::mutex outputMtx;      // guards 'formatter' and the outputs
+    RemoteSink remoteSink;
     std::condition_variable queueCv;
+    std::condition_variable emptyCv;
     TimestampFormatter formatter;
+    // logger thread only: the lines being written and formatting caches
+    std::string line;
+    std::string jsonLine;
+    std::string jsonText;
+    int64_t cachedSecond{-1};
+    std::string cachedPrefix;
+    int64_t cachedIsoSecond{-1};
+    std::string cachedIsoPrefix;
+    std::unordered_map<std::thread::id, std::string> threadHexes;
+};
+
+// Turns the streamed LogStream into void, the type of the other branch of the
+// LOG_* macros' '?:'. '&' binds looser than '<<', so it applies to the whole stream.
+struct LogVoidify {
+    void operator&(const Logger::LogStream&) const noexcept {}
 };
 
 // logging macros
-#define LOG_ERROR() Logger::getInstance().log(LogLevel::ERROR)
-#define LOG_WARNING() Logger::getInstance().log(LogLevel::WARNING)
-#define LOG_INFO() Logger::getInstance().log(LogLevel::INFO)
-#ifdef DEBUGGING
-    #define LOG_DEBUG() Logger::getInstance().log(LogLevel::DEBUG)
-#else
-    #define LOG_DEBUG() if (false) Logger::getInstance().log(LogLevel::DEBUG)
-#endif
+// Each expands to a single '?:' expression ending in a LogStream, so the streamed
+// operands are only evaluated when the message is logged, and an unbraced
+// 'if (x) LOG_*() << ...; else ...' binds as written. 'logCompiledIn' is a
+// constant: call sites below LOG_MIN_LEVEL fold away at compile time.
+#define LOG_AT(level) \
+    !(logCompiledIn(level) && Logger::getInstance().isLoggingLevel(level)) ? (void)0 \
+    : LogVoidify() & Logger::getInstance().log(level)
+
+#define LOG_ERROR() LOG_AT(LogLevel::ERROR)
+#define LOG_WARNING() LOG_AT(LogLevel::WARNING)
+#define LOG_INFO() LOG_AT(LogLevel::INFO)
+#define LOG_DEBUG() LOG_AT(LogLevel::DEBUG)
+
+// The sampler of one call site: every lambda expression is a type of its own.
+#define LOG_SAMPLER() ([]() -> LogSampler& { static LogSampler logSampler; return logSampler; }())
+
+// Logs the 1st, (n+1)th, (2n+1)th... message of this call site, ex: LOG_EVERY_N(DEBUG, 1000) << id;
+#define LOG_EVERY_N(level, n) \
+    !(logCompiledIn(LogLevel::level) && Logger::getInstance().isLoggingLevel(LogLevel::level) && \
+      LOG_SAMPLER().everyN(n)) ? (void)0 \
+    : LogVoidify() & Logger::getInstance().log(LogLevel::level)
+
+// Logs at most one message of this call site per 'interval', ex: LOG_RATE_LIMITED(WARNING, 1s) << err;
+#define LOG_RATE_LIMITED(level, interval) \
+    !(logCompiledIn(LogLevel::level) && Logger::getInstance().isLoggingLevel(LogLevel::level) && \
+      LOG_SAMPLER().atMostEvery(interval)) ? (void)0 \
+    : LogVoidify() & Logger::getInstance().log(LogLevel::level)
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>    // for std::min
+#include <cctype>       // for std::isalnum
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A small Markdown parser producing a render-AST: a flat list of blocks
+ * (headings, paragraphs, list items, code blocks, quotes, rules), each holding
+ * inline spans (text, `code`, *emphasis*, **strong**, [[links]]).
+ *
+ * Parsing is incremental by block: every block remembers a hash of its source
+ * text, and 'parse' moves unchanged blocks over from the previous document
+ * instead of parsing them again.
+ *
+ * example:
+ *      markdown::Document doc = markdown::parse(content);
+ *      doc = markdown::parse(edited_content, std::move(doc));
+ */
+namespace markdown {
+
+enum class SpanType : uint8_t { Text, Code, Emphasis, Strong, Link };
+
+struct Span {
+    SpanType type;
+    std::string text;       // for links: the title of the target note
+    uint32_t target{0};     // for links: resolved by the user, ex: a NoteId
+    std::string label{};    // for links: the text shown, empty to show the title
+
+    std::string_view shown() const { return label.empty() ? std::string_view(text) : std::string_view(label); }
+};
+
+enum class BlockType : uint8_t { Paragraph, Heading, ListItem, CodeBlock, Quote, Rule };
+
+struct Block {
+    BlockType type{BlockType::Paragraph};
+    uint8_t level{0};       // heading level 1-6, list nesting depth
+    uint32_t number{0};     // ordered list number, 0 for bullets
+    uint64_t hash{0};       // hash of the block's source text
+    std::string code;       // content of code blocks
+    std::vector<Span> spans;
+    // layout hints for renderers, size of the block the last time it was drawn
+    float layoutWidth{0.0f};
+    float layoutHeight{0.0f};
+};
+
+struct Document {
+    std::vector<Block> blocks;
+    size_t reusedBlocks{0}; // blocks moved over from the previous document
+};
+
+// FNV-1a, good enough to tell edited blocks apart
+inline uint64_t hashText(std::string_view text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+namespace detail {
+
+inline std::string_view trimLeft(std::string_view line) {
+    size_t start = line.find_first_not_of(" \t");
+    return start == std::string_view::npos ? std::string_view{} : line.substr(start);
+}
+
+inline bool isBlank(std::string_view line) { return trimLeft(line).empty(); }
+
+inline bool isFence(std::string_view line) { return trimLeft(line).substr(0, 3) == "```"; }
+
+inline bool isRule(std::string_view line) {
+    std::string_view t = trimLeft(line);
+    if (t.size() < 3 || (t[0] != '-' && t[0] != '*' && t[0] != '_')) return false;
+    for (char c : t) {
+        if (c != t[0] && c != ' ') return false;
+    }
+    return true;
+}
+
+inline int headingLevel(std::string_view line) {
+    int level = 0;
+    while (level < static_cast<int>(line.size()) && line[level] == '#') ++level;
+    if (level == 0 || level > 6 || level >= static_cast<int>(line.size()) || line[level] != ' ') return 0;
+    return level;
+}
+
+/**
+ * Length of a list marker ("- ", "* ", "+ ", "12. ") after the indentation, 0 if none.
+ * 'number' is set for ordered lists.
+ */
+inline size_t listMarker(std::string_view line, uint32_t& number) {
+    std::string_view t = trimLeft(line);
+    if (t.size() >= 2 && (t[0] == '-' || t[0] == '*' || t[0] == '+') && t[1] == ' ') {
+        number = 0;
+        return 2;
+    }
+    size_t digits = 0;
+    uint32_t value = 0;
+    while (digits < t.size() && digits < 9 && t[digits] >= '0' && t[digits] <= '9') {
+        value = value * 10 + static_cast<uint32_t>(t[digits] - '0');
+        ++digits;
+    }
+    if (digits > 0 && digits + 1 < t.size() && t[digits] == '.' && t[digits + 1] == ' ') {
+        number = value;
+        return digits + 2;
+    }
+    return 0;
+}
+
+inline void addSpan(std::vector<Span>& spans, SpanType type, std::string_view text) {
+    if (text.empty()) return;
+    if (type == SpanType::Text && !spans.empty() && spans.back().type == SpanType::Text) {
+        spans.back().text.append(text);
+        return;
+    }
+    spans.push_back(Span{type, std::string(text)});
+}
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+/**
+ * Splits inline text into spans. Unclosed markers are kept as plain text.
+ * Emphasis and strong markers only open before and close after a non-space,
+ * "2 * 3 * 4" stays text.
+ */
+inline void parseInline(std::string_view text, std::vector<Span>& spans) {
+    size_t plain = 0;
+    size_t i = 0;
+    auto closeWith = [&](std::string_view open, std::string_view close, SpanType type) {
+        size_t start = i + open.size();
+        bool flanked = type == SpanType::Emphasis || type == SpanType::Strong;
+        if (flanked && (start >= text.size() || isSpace(text[start]))) return false;
+        size_t end = text.find(close, start);
+        while (flanked && end != std::string_view::npos && end > start && isSpace(text[end - 1])) {
+            end = text.find(close, end + 1);
+        }
+        if (end == std::string_view::npos || end == start) return false;
+        addSpan(spans, SpanType::Text, text.substr(plain, i - plain));
+        std::string_view inner = text.substr(start, end - start);
+        if (type == SpanType::Link) {
+            // [[target|label]] shows the label, links to the target
+            size_t bar = inner.find('|');
+            Span link{type, std::string(inner.substr(0, bar))};
+            if (bar != std::string_view::npos) link.label = std::string(inner.substr(bar + 1));
+            spans.push_back(std::move(link));
+        } else {
+            addSpan(spans, type, inner);
+        }
+        i = end + close.size();
+        plain = i;
+        return true;
+    };
+
+    while (i < text.size()) {
+        char c = text[i];
+        bool matched = false;
+        if (c == '`') matched = closeWith("`", "`", SpanType::Code);
+        else if (c == '[' && text.substr(i, 2) == "[[") matched = closeWith("[[", "]]", SpanType::Link);
+        else if ((c == '*' || c == '_') && i + 1 < text.size() && text[i + 1] == c)
+            matched = closeWith(text.substr(i, 2), text.substr(i, 2), SpanType::Strong);
+        else if (c == '*' || (c == '_' && (i == 0 || !std::isalnum(static_cast<unsigned char>(text[i - 1])))))
+            matched = closeWith(text.substr(i, 1), text.substr(i, 1), SpanType::Emphasis);
+        if (!matched) ++i;
+    }
+    addSpan(spans, SpanType::Text, text.substr(plain));
+}
+
+/**
+ * Parses the source text of one block, see 'splitBlocks' for how blocks are cut.
+ */
+inline Block parseBlock(std::string_view source) {
+    Block block;
+    block.hash = hashText(source);
+    std::string_view first = source.substr(0, source.find('\n'));
+
+    if (isFence(first)) {
+        block.type = BlockType::CodeBlock;
+        size_t body = source.find('\n');
+        std::string_view code = body == std::string_view::npos ? std::string_view{} : source.substr(body + 1);
+        // drop the closing fence
+        size_t last_line = code.rfind('\n');
+        std::string_view tail = last_line == std::string_view::npos ? code : code.substr(last_line + 1);
+        if (isFence(tail)) code = last_line == std::string_view::npos ? std::string_view{} : code.substr(0, last_line);
+        block.code = std::string(code);
+        return block;
+    }
+    if (isRule(first) && first.find('\n') == std::string_view::npos && source.size() == first.size()) {
+        block.type = BlockType::Rule;
+        return block;
+    }
+    if (int level = headingLevel(first); level > 0) {
+        block.type = BlockType::Heading;
+        block.level = static_cast<uint8_t>(level);
+        parseInline(trimLeft(first.substr(level)), block.spans);
+        return block;
+    }
+
+    // join the lines of paragraphs, list items and quotes with spaces
+    std::string text;
+    uint32_t number = 0;
+    size_t marker = listMarker(first, number);
+    std::string_view trimmed = trimLeft(first);
+    if (marker > 0) {
+        block.type = BlockType::ListItem;
+        block.number = number;
+        block.level = static_cast<uint8_t>(std::min<size_t>((first.size() - trimmed.size()) / 2, 255));
+    } else if (!trimmed.empty() && trimmed[0] == '>') {
+        block.type = BlockType::Quote;
+    }
+
+    size_t start = 0;
+    bool first_line = true;
+    while (start <= source.size()) {
+        size_t end = source.find('\n', start);
+        if (end == std::string_view::npos) end = source.size();
+        std::string_view line = trimLeft(source.substr(start, end - start));
+        if (first_line && marker > 0) line = line.substr(marker);
+        if (block.type == BlockType::Quote && !line.empty() && line[0] == '>') line = trimLeft(line.substr(1));
+        if (!line.empty()) {
+            if (!text.empty()) text += ' ';
+            text.append(line);
+        }
+        first_line = false;
+        start = end + 1;
+    }
+    parseInline(text, block.spans);
+    return block;
+}
+
+/**
+ * Cuts 'source' into the source text of its blocks: blank lines end blocks,
+ * fenced code is one block, headings, rules and list items start new ones.
+ */
+inline std::vector<std::string_view> splitBlocks(std::string_view source) {
+    std::vector<std::string_view> blocks;
+    size_t block_start = std::string_view::npos;
+    bool in_fence = false;
+    auto close = [&](size_t end) {
+        if (block_start != std::string_view::npos) {
+            std::string_view block = source.substr(block_start, end - block_start);
+            while (!block.empty() && block.back() == '\n') block.remove_suffix(1);
+            blocks.push_back(block);
+        }
+        block_start = std::string_view::npos;
+    };
+
+    size_t start = 0;
+    while (start < source.size()) {
+        size_t end = source.find('\n', start);
+        size_t next = end == std::string_view::npos ? source.size() : end + 1;
+        std::string_view line = source.substr(start, next - start);
+        if (!line.empty() && line.back() == '\n') line.remove_suffix(1);
+
+        if (in_fence) {
+            if (isFence(line)) {
+                close(next);
+                in_fence = false;
+            }
+        } else if (isFence(line)) {
+            close(start);
+            block_start = start;
+            in_fence = true;
+        } else if (isBlank(line)) {
+            close(start);
+        } else {
+            uint32_t number;
+            bool starts_block = headingLevel(line) > 0 || isRule(line) || listMarker(line, number) > 0;
+            if (starts_block) close(start);
+            if (block_start == std::string_view::npos) block_start = start;
+            // headings and rules are always a single line
+            if (headingLevel(line) > 0 || isRule(line)) close(next);
+        }
+        start = next;
+    }
+    close(source.size());
+    return blocks;
+}
+
+} // namespace detail
+
+/**
+ * Parses 'source', moving blocks whose source text is unchanged over from 'previous'.
+ */
+inline Document parse(std::string_view source, Document previous = {}) {
+    std::unordered_multimap<uint64_t, size_t> known;
+    known.reserve(previous.blocks.size());
+    for (size_t i = 0; i < previous.blocks.size(); ++i) known.emplace(previous.blocks[i].hash, i);
+
+    Document doc;
+    for (std::string_view text : detail::splitBlocks(source)) {
+        uint64_t hash = hashText(text);
+        if (auto it = known.find(hash); it != known.end()) {
+            doc.blocks.push_back(std::move(previous.blocks[it->second]));
+            known.erase(it);
+            ++doc.reusedBlocks;
+        } else {
+            doc.blocks.push_back(detail::parseBlock(text));
+        }
+    }
+    return doc;
+}
+
+} // namespace markdown
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>   // for std::atomic<>
+#include <cstddef>  // for size_t
+#include <cstdint>  // for intptr_t
+#include <memory>   // for std::unique_ptr
+#include <utility>  // for std::move
+
+/**
+ * A bounded lock-free multi-producer/single-consumer ring buffer.
+ * * Every slot carries a sequence number (Dmitry Vyukov's bounded queue):
+ *   producers claim a position with a CAS on 'tail' and publish the slot by
+ *   storing its sequence, the consumer only reads slots that were published.
+ * * 'try_push' never blocks, it returns false when the ring is full.
+ * * 'front', 'pop', 'try_pop' and 'empty' may only be called by the one consumer.
+ * * The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class MpscQueue {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUp(size_t n) {
+        size_t capacity = 2;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
+    }
+
+    const size_t capacity_;
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> tail{0};    // next position for producers
+    alignas(64) size_t head{0};                 // next position for the consumer
+
+public:
+    explicit MpscQueue(size_t capacity) :
+        capacity_(roundUp(capacity)), mask(capacity_ - 1), slots(new Slot[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    bool try_push(T value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // the consumer hasn't freed this slot yet: full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Consumer: the oldest published element, or nullptr if there is none.
+     */
+    T* front() noexcept {
+        Slot& slot = slots[head & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1) return nullptr;
+        return &slot.value;
+    }
+
+    /**
+     * Consumer: removes the element returned by 'front'.
+     */
+    void pop() noexcept {
+        slots[head & mask].sequence.store(head + capacity_, std::memory_order_release);
+        ++head;
+    }
+
+    bool try_pop(T& out) {
+        T* value = front();
+        if (!value) return false;
+        out = std::move(*value);
+        pop();
+        return true;
+    }
+
+    bool empty() const noexcept {
+        const Slot& slot = slots[head & mask];
+        return slot.sequence.load(std::memory_order_acquire) != head + 1;
+    }
+};
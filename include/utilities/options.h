@@ -11,6 +11,19 @@ struct Options {
     std::string app_name{"NoteWiki 0.0"};
     std::string storage_path; // file to load/save notes
     bool        verbose = false;
+    bool        log_json = false;   // log file as JSON lines, for log shippers
+    std::string flight_recorder;    // ring file of all log levels, kept after a crash
+    std::string trace;              // Chrome trace_event JSON of the traced spans, written at exit
+    // batch mode: run 'query' against 'query_by' (title|tag|content), print as 'format' (jsonl|tsv) and exit
+    std::optional<std::string> query;
+    std::string query_by{"title"};
+    std::string format{"jsonl"};
+    bool stats = false;                 // batch mode: print the memory held by the store as 'format' and exit
+    // daemon: '--daemon' serves the store on 'socket_path', otherwise a set 'socket_path' makes this a client
+    bool daemon = false;
+    std::string socket_path;
+    std::optional<std::string> get;     // client: print the note with this title
+    std::optional<std::string> update;  // client: replace this note's content with stdin
 };
 
 // parse without side effects; no I/O except returning an error
@@ -20,7 +33,7 @@ struct ParseResult {
     int                    exit_code = 0; // e.g. 0 for --help, 1 for bad args
 };
 
-ParseResult parse_options(int argc, char* argv[]) {
+inline ParseResult parse_options(int argc, char* argv[]) {
     ParseResult r;
 
     try {
@@ -28,6 +41,17 @@ ParseResult parse_options(int argc, char* argv[]) {
         opts.add_options()
             ("f,file", "Storage file to load", cxxopts::value<std::string>())
             ("v,verbose", "Verbose output")
+            ("log-json", "Write the log file as JSON lines")
+            ("flight-recorder", "Record every log level into this ring file, read it with notewiki_flightdump", cxxopts::value<std::string>())
+            ("trace", "Trace loads, saves, updates, frames and log drains, write them to this file at exit (Perfetto, chrome://tracing)", cxxopts::value<std::string>())
+            ("q,query", "Run a query, print the matching notes and exit", cxxopts::value<std::string>())
+            ("by", "Field to query: title (default), tag or content", cxxopts::value<std::string>())
+            ("format", "Query output: jsonl (default) or tsv", cxxopts::value<std::string>())
+            ("stats", "Print the memory held by the store and exit, as --format")
+            ("daemon", "Keep the store loaded and serve requests on --socket")
+            ("socket", "Unix socket of the daemon, with --daemon: where to serve", cxxopts::value<std::string>())
+            ("get", "Print the note with this title (client)", cxxopts::value<std::string>())
+            ("update", "Replace the content of this note with stdin (client)", cxxopts::value<std::string>())
             ("h,help", "Show help");
 
         auto result = opts.parse(argc, argv);
@@ -48,6 +72,33 @@ ParseResult parse_options(int argc, char* argv[]) {
         }
 
         o.verbose = result.count("verbose") > 0;
+        o.log_json = result.count("log-json") > 0;
+        if (result.count("flight-recorder")) o.flight_recorder = result["flight-recorder"].as<std::string>();
+        if (result.count("trace")) o.trace = result["trace"].as<std::string>();
+        if (result.count("query")) o.query = result["query"].as<std::string>();
+        if (result.count("by")) o.query_by = result["by"].as<std::string>();
+        if (result.count("format")) o.format = result["format"].as<std::string>();
+        o.stats = result.count("stats") > 0;
+        o.daemon = result.count("daemon") > 0;
+        if (result.count("socket")) o.socket_path = result["socket"].as<std::string>();
+        if (result.count("get")) o.get = result["get"].as<std::string>();
+        if (result.count("update")) o.update = result["update"].as<std::string>();
+        if (o.daemon && o.socket_path.empty()) o.socket_path = "notewiki.sock";
+        if ((o.get || o.update) && o.socket_path.empty()) {
+            r.error = "Argument error: --get and --update talk to a daemon, pass its --socket";
+            r.exit_code = 1;
+            return r;
+        }
+        if (o.query_by != "title" && o.query_by != "tag" && o.query_by != "content") {
+            r.error = "Argument error: --by must be title, tag or content";
+            r.exit_code = 1;
+            return r;
+        }
+        if (o.format != "jsonl" && o.format != "tsv") {
+            r.error = "Argument error: --format must be jsonl or tsv";
+            r.exit_code = 1;
+            return r;
+        }
         r.value = std::move(o);
         return r;
 
@@ -2,28 +2,32 @@
 
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
 
 /**
  * Turn a string 'words' with words separated by any character in 'delimiter' into
  * a vector of strings containing the words
  */
-std::vector<std::string> parseWords(std::string_view words, std::string delimiter = " ,") {
-    std::string word;
+inline std::vector<std::string> parseWords(std::string_view words, std::string_view delimiter = " ,") {
+    // one allocation for the list: at most one word more than there are delimiters
+    size_t most = 1;
+    for (char c : words) most += delimiter.find(c) != std::string_view::npos;
     std::vector<std::string> keys;
+    keys.reserve(most);
+
+    // words are built straight in the list, no temporary string per word
     size_t start = 0, next;
-    while ((next = words.find_first_of(delimiter, start)) != std::string::npos) {
-        word = words.substr(start, next - start);
-        if (!word.empty()) keys.emplace_back(word);
+    while ((next = words.find_first_of(delimiter, start)) != std::string_view::npos) {
+        if (next > start) keys.emplace_back(words.substr(start, next - start));
         start = next + 1;
     }
     // check for a final word
-    word = words.substr(start, words.size() - start);
-    if (!word.empty()) keys.emplace_back(word);
+    if (start < words.size()) keys.emplace_back(words.substr(start));
 
     // sort words and remove duplicates
     std::sort(keys.begin(), keys.end());
     keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
 
     return keys;
-}
\ No newline at end of file
+}
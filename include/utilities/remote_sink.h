@@ -0,0 +1,235 @@
+#pragma once
+
+#include <arpa/inet.h>      // for sockaddr_in, htons(), inet_pton()
+#include <algorithm>        // for std::min, std::count
+#include <cerrno>           // for errno, EINPROGRESS, EAGAIN
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <poll.h>           // for ::poll
+#include <sys/socket.h>     // for socket(), connect(), send(), recv()
+#include <unistd.h>         // for ::close
+
+struct RemoteSinkOptions {
+    size_t batchBytes = 64 * 1024;      // a frame is sent once its lines reach this size
+    std::chrono::milliseconds batchDelay{50};   // or once its oldest line is this old
+    size_t maxBuffered = 4 << 20;       // bytes kept while the server is slow or away, newer lines are dropped
+    std::chrono::milliseconds minBackoff{100};  // first reconnect delay, doubled per failure
+    std::chrono::milliseconds maxBackoff{10000};
+};
+
+/**
+ * Ships log lines to a TCP server without ever blocking the caller.
+ * * Lines are batched into frames: a 4 byte big-endian payload length, then the
+ *   lines, each ending in '\n'.
+ * * 'write' only appends to memory, 'poll' connects, sends what the socket takes
+ *   and reads away whatever the server answers (acknowledgements aren't waited for).
+ * * A failed or lost connection is retried with exponential backoff, a frame cut
+ *   off by a disconnect is dropped. While disconnected at most 'maxBuffered'
+ *   bytes are kept, later lines are counted in 'droppedLines'.
+ * * Not thread-safe, the Logger only uses it from its own thread.
+ */
+class RemoteSink {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RemoteSink() = default;
+    ~RemoteSink() { close(); }
+
+    RemoteSink(const RemoteSink&) = delete;
+    RemoteSink& operator=(const RemoteSink&) = delete;
+
+    /**
+     * Returns false if 'ip_address' isn't a valid IPv4 address. Connecting happens in 'poll'.
+     */
+    bool open(const std::string& ip_address, int port, RemoteSinkOptions options = {}) {
+        close();
+        address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        if (inet_pton(AF_INET, ip_address.c_str(), &address.sin_addr) <= 0) return false;
+        this->options = options;
+        configured = true;
+        backoff = options.minBackoff;
+        nextAttempt = Clock::now();
+        return true;
+    }
+
+    void close() {
+        disconnect();
+        configured = false;
+        frames.clear();
+        batch.clear();
+        buffered = 0;
+    }
+
+    bool isOpen() const noexcept { return configured; }
+    bool connected() const noexcept { return state == State::Connected; }
+    uint64_t droppedLines() const noexcept { return dropped; }
+    uint64_t sentFrames() const noexcept { return sent; }
+    uint64_t receivedBytes() const noexcept { return received; }
+
+    void write(std::string_view line) {
+        if (!configured) return;
+        if (buffered + line.size() + 1 > options.maxBuffered) {
+            ++dropped;
+            return;
+        }
+        if (batch.empty()) batchStart = Clock::now();
+        batch.append(line);
+        batch.push_back('\n');
+        buffered += line.size() + 1;
+        if (batch.size() >= options.batchBytes) sealBatch();
+    }
+
+    /**
+     * Does whatever network work is possible right now, never blocks.
+     */
+    void poll() {
+        if (!configured) return;
+        Clock::time_point now = Clock::now();
+        if (!batch.empty() && now - batchStart >= options.batchDelay) sealBatch();
+
+        if (state == State::Disconnected && now >= nextAttempt) startConnect();
+        if (state == State::Connecting) finishConnect();
+        if (state != State::Connected) return;
+
+        readAcknowledgements();
+        sendFrames();
+    }
+
+    /**
+     * Sends everything buffered, giving up after 'limit', ex: on shutdown.
+     */
+    void drain(std::chrono::milliseconds limit) {
+        if (!configured) return;
+        if (!batch.empty()) sealBatch();
+        Clock::time_point deadline = Clock::now() + limit;
+        while (!frames.empty() && Clock::now() < deadline) {
+            poll();
+            if (!frames.empty()) {
+                pollfd p{fd, static_cast<short>(state == State::Disconnected ? 0 : POLLOUT), 0};
+                ::poll(&p, fd >= 0 ? 1 : 0, 1);
+            }
+        }
+    }
+
+private:
+    enum class State { Disconnected, Connecting, Connected };
+
+    RemoteSinkOptions options;
+    sockaddr_in address{};
+    bool configured{false};
+    State state{State::Disconnected};
+    int fd{-1};
+    std::chrono::milliseconds backoff{0};
+    Clock::time_point nextAttempt;
+
+    std::string batch;              // lines of the frame being filled
+    Clock::time_point batchStart;
+    std::deque<std::string> frames; // sealed frames, header included
+    size_t frontSent{0};            // bytes of frames.front() already sent
+    size_t buffered{0};             // bytes in 'batch' and 'frames'
+    uint64_t dropped{0};
+    uint64_t sent{0};
+    uint64_t received{0};
+
+    void sealBatch() {
+        uint32_t length = static_cast<uint32_t>(batch.size());
+        std::string frame;
+        frame.reserve(4 + batch.size());
+        for (int shift = 24; shift >= 0; shift -= 8) frame.push_back(static_cast<char>((length >> shift) & 0xff));
+        frame.append(batch);
+        buffered += 4;
+        frames.push_back(std::move(frame));
+        batch.clear();
+    }
+
+    void disconnect() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        state = State::Disconnected;
+        // the server can't make sense of the rest of a frame
+        if (frontSent > 0 && !frames.empty()) {
+            const std::string& frame = frames.front();
+            dropped += static_cast<uint64_t>(std::count(frame.begin() + 4, frame.end(), '\n'));
+            buffered -= frame.size();
+            frames.pop_front();
+        }
+        frontSent = 0;
+    }
+
+    void retryLater() {
+        disconnect();
+        nextAttempt = Clock::now() + backoff;
+        backoff = std::min(backoff * 2, options.maxBackoff);
+    }
+
+    void startConnect() {
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            retryLater();
+            return;
+        }
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            connectedNow();
+        } else if (errno == EINPROGRESS) {
+            state = State::Connecting;
+        } else {
+            retryLater();
+        }
+    }
+
+    void finishConnect() {
+        pollfd p{fd, POLLOUT, 0};
+        if (::poll(&p, 1, 0) <= 0) return;  // still connecting
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            retryLater();
+            return;
+        }
+        connectedNow();
+    }
+
+    void connectedNow() {
+        state = State::Connected;
+        backoff = options.minBackoff;
+    }
+
+    void readAcknowledgements() {
+        char chunk[4096];
+        while (true) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+            if (n > 0) {
+                received += static_cast<uint64_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            retryLater();   // closed by the server, or an error
+            return;
+        }
+    }
+
+    void sendFrames() {
+        while (state == State::Connected && !frames.empty()) {
+            const std::string& frame = frames.front();
+            ssize_t n = ::send(fd, frame.data() + frontSent, frame.size() - frontSent, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) retryLater();
+                return;
+            }
+            frontSent += static_cast<size_t>(n);
+            if (frontSent == frame.size()) {
+                buffered -= frame.size();
+                frames.pop_front();
+                frontSent = 0;
+                ++sent;
+            }
+        }
+    }
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>            // for std::max, std::min
+#include <atomic>               // for std::atomic<>
+#include <condition_variable>   // for std::condition_variable
+#include <functional>           // for std::function
+#include <mutex>                // for std::mutex, std::lock_guard<>
+#include <thread>               // for std::thread
+#include <vector>
+
+/**
+ * A fixed set of worker threads for data-parallel loops.
+ * * 'parallel_for' splits [0, n) into chunks, the workers and the calling
+ *   thread take chunks until none are left, and it returns once all are done.
+ * * Only one 'parallel_for' runs at a time, concurrent callers are serialized.
+ *
+ * example:
+ *      ThreadPool pool(4);
+ *      pool.parallel_for(points.size(), [&](size_t begin, size_t end) {
+ *          for (size_t i = begin; i < end; ++i) move(points[i]);
+ *      });
+ */
+class ThreadPool {
+public:
+    using RangeFn = std::function<void(size_t, size_t)>;
+
+    // 'threads' is the number of extra workers, 0 runs everything on the caller
+    explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency()) - 1) {
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            done = true;
+        }
+        jobCv.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // threads taking part in a 'parallel_for', including the caller
+    size_t size() const noexcept { return workers.size() + 1; }
+
+    void parallel_for(size_t n, const RangeFn& fn, size_t min_chunk = 256) {
+        if (n == 0) return;
+        std::lock_guard<std::mutex> serial(callMtx);
+
+        size_t chunk = std::max(min_chunk, n / (size() * 4) + 1);
+        size_t chunks = (n + chunk - 1) / chunk;
+        if (workers.empty() || chunks == 1) {
+            fn(0, n);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job = &fn;
+            jobSize = n;
+            jobChunk = chunk;
+            nextChunk.store(0);
+            remaining.store(chunks);
+            ++generation;
+        }
+        jobCv.notify_all();
+
+        runChunks();
+
+        // also wait for late workers to leave 'runChunks', 'fn' dies with this call
+        std::unique_lock<std::mutex> lock(mtx);
+        doneCv.wait(lock, [this] { return remaining.load() == 0 && active == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex callMtx;
+    std::mutex mtx;
+    std::condition_variable jobCv;
+    std::condition_variable doneCv;
+    const RangeFn* job{nullptr};
+    size_t jobSize{0};
+    size_t jobChunk{0};
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<size_t> remaining{0};
+    uint64_t generation{0};
+    size_t active{0};   // workers inside 'runChunks', guarded by 'mtx'
+    bool done{false};
+
+    // takes chunks of the current job until there are none left
+    void runChunks() {
+        size_t chunks = (jobSize + jobChunk - 1) / jobChunk;
+        size_t c;
+        while ((c = nextChunk.fetch_add(1)) < chunks) {
+            size_t begin = c * jobChunk;
+            (*job)(begin, std::min(jobSize, begin + jobChunk));
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mtx);
+                doneCv.notify_all();
+            }
+        }
+    }
+
+    // Function that loops in every worker thread
+    void workerLoop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            jobCv.wait(lock, [&] { return done || (generation != seen && job); });
+            if (done) return;
+            seen = generation;
+            ++active;
+            lock.unlock();
+            runChunks();
+            lock.lock();
+            if (--active == 0) doneCv.notify_all();
+        }
+    }
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>  // for std::min
+#include <array>
+#include <bit>          // for std::countr_zero, std::popcount
+#include <cstdint>
+#include <cstring>      // for std::memcpy, std::memset
+#include <functional>   // for std::hash
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define TOKENIZER_X86 1
+#endif
+
+namespace tokenizer {
+
+namespace detail {
+
+/**
+ * One bit per byte of a 64 byte block: whitespace (any byte up to ' ') or ',',
+ * and '"'. Bytes from 0x80 (UTF-8) are never delimiters.
+ */
+struct BlockMasks {
+    uint64_t delimiters;
+    uint64_t quotes;
+};
+
+inline BlockMasks classifyScalar(const char* block) noexcept {
+    BlockMasks masks{0, 0};
+    for (unsigned i = 0; i < 64; ++i) {
+        unsigned char c = static_cast<unsigned char>(block[i]);
+        masks.delimiters |= static_cast<uint64_t>(c <= ' ' || c == ',') << i;
+        masks.quotes |= static_cast<uint64_t>(c == '"') << i;
+    }
+    return masks;
+}
+
+#ifdef TOKENIZER_X86
+// c <= ' ' unsigned is min(c, ' ') == c, two instructions instead of a compare per whitespace byte
+inline BlockMasks classifySse2(const char* block) noexcept {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    BlockMasks masks{0, 0};
+    for (unsigned i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i delimiter = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, space), v), _mm_cmpeq_epi8(v, comma));
+        masks.delimiters |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(delimiter))) << (16 * i);
+        masks.quotes |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << (16 * i);
+    }
+    return masks;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+inline BlockMasks classifyAvx2(const char* block) noexcept {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+    BlockMasks masks{0, 0};
+    for (unsigned i = 0; i < 2; ++i) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+        __m256i delimiter = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(v, space), v),
+                                            _mm256_cmpeq_epi8(v, comma));
+        masks.delimiters |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(delimiter))) << (32 * i);
+        masks.quotes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << (32 * i);
+    }
+    return masks;
+}
+#define TOKENIZER_AVX2 1
+#endif
+#endif
+
+// AVX2 when the CPU has it (checked once), SSE2 on any other x86-64, scalar elsewhere
+inline BlockMasks classify(const char* block) noexcept {
+#if defined(TOKENIZER_AVX2) && defined(__AVX2__)
+    return classifyAvx2(block);
+#elif defined(TOKENIZER_AVX2)
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2 ? classifyAvx2(block) : classifySse2(block);
+#elif defined(TOKENIZER_X86)
+    return classifySse2(block);
+#else
+    return classifyScalar(block);
+#endif
+}
+
+} // namespace detail
+
+/**
+ * Splits tag and kid lines into unique words without copying them: the tokens
+ * are string_views into the line, or strings built straight from them.
+ * * Words are separated by whitespace and commas, a word starting with '"'
+ *   runs to the next '"' and may hold both (ex: "multi word tag"). Inside
+ *   quotes a doubled '""' is one quote (ex: "say ""hi"""), see 'appendQuoted'.
+ *   Quotes inside an unquoted word are kept.
+ * * Duplicates are dropped with a small open addressing hash set, the tokens
+ *   keep the order of their first appearance. Nothing is sorted.
+ * * Delimiters are found 64 bytes at a time with SSE2 or AVX2, see 'detail::classify'.
+ * * No allocation: the output is reserved once for the line, the hash set
+ *   lives in the Tokenizer for lines up to 'inlineTokens' words and is
+ *   reused for longer ones. Only a quoted word with doubled quotes is
+ *   copied, into a buffer of the Tokenizer its string_view points into
+ *   until the next 'tokenize'.
+ *
+ * example:
+ *      tokenizer::Tokenizer tokenizer;
+ *      std::vector<std::string_view> tags;
+ *      tokenizer.tokenize(R"(rust, "data structures" rust)", tags);  // {"rust", "data structures"}
+ */
+class Tokenizer {
+public:
+    static constexpr size_t inlineTokens = 128;
+
+    /**
+     * Replaces 'out' (ex: std::vector<std::string_view> or std::vector<std::string>)
+     * with the unique tokens of 'text', returns their number.
+     */
+    template<typename Container>
+    size_t tokenize(std::string_view text, Container& out) {
+        out.clear();
+        unescaped.clear();
+        size_t most = maxTokens(text);
+        if (most == 0) return 0;
+        out.reserve(most);
+        uint32_t* slots = table(most);
+
+        Scanner scan(text);
+        size_t pos = 0;
+        while ((pos = scan.next(pos, false)) < text.size()) {
+            std::string_view word;
+            if (text[pos] == '"') {
+                word = quoted(text, pos);
+            } else {
+                size_t end = scan.next(pos, true);
+                word = text.substr(pos, end - pos);
+                pos = end;
+            }
+            if (!word.empty()) insert(word, out, slots);
+        }
+        return out.size();
+    }
+
+    /**
+     * An upper bound of the tokens of 'text': the words when quotes count as
+     * delimiters, plus the quotes. An unquoted token starts with its own such
+     * word, a quoted one with its own quote, even when it holds only delimiters (ex: ",").
+     */
+    static size_t maxTokens(std::string_view text) noexcept {
+        size_t count = 0;
+        uint64_t carry = 1;     // the text starts after a delimiter
+        for (size_t block = 0; block < text.size(); block += 64) {
+            detail::BlockMasks masks = load(text, block);
+            uint64_t separators = masks.delimiters | masks.quotes;
+            uint64_t starts = ~separators & ((separators << 1) | carry);
+            carry = separators >> 63;
+            count += static_cast<size_t>(std::popcount(starts) + std::popcount(masks.quotes));
+        }
+        return count;
+    }
+
+    // true if 'word' must be written in quotes to come back as one token
+    static bool needsQuotes(std::string_view word) noexcept {
+        if (!word.empty() && word.front() == '"') return true;
+        for (char c : word) {
+            if (static_cast<unsigned char>(c) <= ' ' || c == ',') return true;
+        }
+        return false;
+    }
+
+    // appends 'word' in quotes with its quotes doubled, 'tokenize' reads it back as one token
+    static void appendQuoted(std::string& line, std::string_view word) {
+        line += '"';
+        for (size_t quote; (quote = word.find('"')) != std::string_view::npos; word.remove_prefix(quote + 1)) {
+            line.append(word.substr(0, quote + 1));
+            line += '"';
+        }
+        line.append(word);
+        line += '"';
+    }
+
+private:
+    std::array<uint32_t, 2 * inlineTokens> inlineSlots{};
+    std::vector<uint32_t> heapSlots;
+    size_t mask{0};
+    std::string unescaped;
+
+    // a quote at 'quote' followed by another is a quote of the word, not its end
+    static bool doubled(std::string_view text, size_t quote) noexcept {
+        return quote != std::string_view::npos && quote + 1 < text.size() && text[quote + 1] == '"';
+    }
+
+    // the word of the quote at 'pos', 'pos' moves past its closing quote. An
+    // unterminated quote runs to the end.
+    std::string_view quoted(std::string_view text, size_t& pos) {
+        size_t start = pos + 1;
+        size_t end = text.find('"', start);
+        if (!doubled(text, end)) {
+            end = std::min(end, text.size());
+            pos = end + 1;
+            return text.substr(start, end - start);
+        }
+        // copied without the doubled quotes. All the words copied from 'text' fit
+        // in its size, the buffer never moves under the views taken before.
+        if (unescaped.capacity() < text.size()) unescaped.reserve(text.size());
+        size_t first = unescaped.size();
+        do {
+            unescaped.append(text.substr(start, end + 1 - start));
+            start = end + 2;
+            end = text.find('"', start);
+        } while (doubled(text, end));
+        end = std::min(end, text.size());
+        unescaped.append(text.substr(start, end - start));
+        pos = end + 1;
+        return std::string_view(unescaped).substr(first);
+    }
+
+    // masks of the block at 'offset', bytes past the end of 'text' are delimiters
+    static detail::BlockMasks load(std::string_view text, size_t offset) noexcept {
+        if (text.size() - offset >= 64) return detail::classify(text.data() + offset);
+        char padded[64];
+        std::memset(padded, ' ', sizeof(padded));
+        std::memcpy(padded, text.data() + offset, text.size() - offset);
+        return detail::classify(padded);
+    }
+
+    // finds the next delimiter or non-delimiter, classifying each block once
+    class Scanner {
+    public:
+        explicit Scanner(std::string_view text) : text(text) {}
+
+        // first position from 'pos' that is ('delimiter') or isn't a delimiter, text.size() if none
+        size_t next(size_t pos, bool delimiter) noexcept {
+            while (pos < text.size()) {
+                size_t block = pos & ~size_t{63};
+                if (block != loaded) {
+                    delimiters = load(text, block).delimiters;
+                    loaded = block;
+                }
+                uint64_t bits = (delimiter ? delimiters : ~delimiters) & (~uint64_t{0} << (pos - block));
+                if (bits != 0) return std::min(text.size(), block + static_cast<size_t>(std::countr_zero(bits)));
+                pos = block + 64;
+            }
+            return text.size();
+        }
+
+    private:
+        std::string_view text;
+        size_t loaded{~size_t{0}};
+        uint64_t delimiters{0};
+    };
+
+    // a cleared hash set of at least twice 'tokens' slots
+    uint32_t* table(size_t tokens) {
+        size_t capacity = 16;
+        while (capacity < 2 * tokens) capacity *= 2;
+        mask = capacity - 1;
+        uint32_t* slots = inlineSlots.data();
+        if (capacity > inlineSlots.size()) {
+            if (heapSlots.size() < capacity) heapSlots.resize(capacity);
+            slots = heapSlots.data();
+        }
+        std::memset(slots, 0, capacity * sizeof(uint32_t));
+        return slots;
+    }
+
+    // slots hold an index into 'out' plus one, 0 is empty. The table is at least
+    // twice 'maxTokens', it never fills up.
+    template<typename Container>
+    void insert(std::string_view token, Container& out, uint32_t* slots) {
+        size_t slot = std::hash<std::string_view>{}(token) & mask;
+        while (slots[slot] != 0) {
+            if (std::string_view(out[slots[slot] - 1]) == token) return;
+            slot = (slot + 1) & mask;
+        }
+        out.emplace_back(token);
+        slots[slot] = static_cast<uint32_t>(out.size());
+    }
+};
+
+} // namespace tokenizer
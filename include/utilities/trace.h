@@ -0,0 +1,271 @@
+#pragma once
+
+#include <atomic>       // for std::atomic<>
+#include <chrono>
+#include <cstdint>
+#include <memory>       // for std::shared_ptr, std::unique_ptr
+#include <new>          // for std::nothrow
+#include <mutex>        // for std::mutex, std::lock_guard<>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>      // for ::open
+#include <unistd.h>     // for ::close, ::getpid
+
+#include "buffered_writer.h"    // for BufferedWriter
+
+// One span: 'name' is a string literal, times are nanoseconds since the tracer started.
+struct TraceEvent {
+    const char* name;
+    int64_t begin;
+    int64_t duration;
+};
+
+/**
+ * Collects spans per thread and writes them as Chrome trace_event JSON, which
+ * Perfetto (ui.perfetto.dev) and chrome://tracing open as a timeline.
+ * * Disabled, a span costs one relaxed load and a branch, nothing is allocated.
+ * * Enabled, every thread appends to its own fixed size buffer: no lock and no
+ *   allocation after the thread's first span. A full buffer drops further spans
+ *   and counts them.
+ * * Buffers outlive their threads, 'write' reads them while threads keep recording.
+ *
+ * example:
+ *      Tracer::instance().enable();
+ *      {
+ *          TRACE_SCOPE("load_json_file");
+ *          ...
+ *      }
+ *      Tracer::instance().writeFile("notewiki.trace.json");
+ */
+class Tracer {
+public:
+    static constexpr size_t defaultCapacity = 1 << 16;
+
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    static bool enabled() noexcept { return on.load(std::memory_order_relaxed); }
+
+    // Starts recording, threads that record for the first time get 'eventsPerThread' slots.
+    void enable(size_t eventsPerThread = defaultCapacity) {
+        capacity.store(eventsPerThread, std::memory_order_relaxed);
+        on.store(true, std::memory_order_release);
+    }
+
+    void disable() noexcept { on.store(false, std::memory_order_relaxed); }
+
+    // nanoseconds since the tracer was created
+    int64_t now() const noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+    }
+
+    void record(const char* name, int64_t begin, int64_t end) {
+        if (!enabled()) return;
+        ThreadBuffer& buffer = threadBuffer();
+        size_t n = buffer.size.load(std::memory_order_relaxed);
+        if (!buffer.events) {
+            buffer.capacity = capacity.load(std::memory_order_relaxed);
+            buffer.events.reset(new (std::nothrow) TraceEvent[buffer.capacity]);
+            if (!buffer.events) buffer.capacity = 0;
+        }
+        if (n == buffer.capacity) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.events[n] = {name, begin, end - begin};
+        buffer.size.store(n + 1, std::memory_order_release);
+    }
+
+    // Names the calling thread in the trace, ex: "ui", "logger". Works while disabled.
+    void setThreadName(std::string_view name) {
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(registryMtx);
+        buffer.name = name;
+    }
+
+    // spans recorded and not cleared, over all threads
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& buffer : snapshot()) total += buffer->size.load(std::memory_order_acquire);
+        return total;
+    }
+
+    // spans lost to full buffers
+    uint64_t dropped() const {
+        uint64_t total = 0;
+        for (const auto& buffer : snapshot()) total += buffer->dropped.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    // Forgets the recorded spans. Only while no thread records, ex: between tests.
+    void clear() {
+        for (const auto& buffer : snapshot()) {
+            buffer->size.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Writes the spans recorded so far as a trace_event JSON object:
+     *      {"traceEvents":[{"name":"...","ph":"X","ts":12.345,"dur":6.789,"pid":1,"tid":1}, ...]}
+     * Times are microseconds, threads are numbered in the order they first traced.
+     */
+    template<typename Writer>
+    void write(Writer& out) const {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers = snapshot();
+        uint64_t pid = static_cast<uint64_t>(::getpid());
+        bool first = true;
+        auto separator = [&] {
+            out.write(first ? "\n" : ",\n");
+            first = false;
+        };
+        out.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        for (const auto& buffer : buffers) {
+            std::string name;
+            {
+                std::lock_guard<std::mutex> lock(registryMtx);
+                name = buffer->name;
+            }
+            if (!name.empty()) {
+                separator();
+                out.write("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+                out.number(pid);
+                out.write(",\"tid\":");
+                out.number(buffer->tid);
+                out.write(",\"args\":{\"name\":\"");
+                writeEscaped(out, name);
+                out.write("\"}}");
+            }
+            size_t n = buffer->size.load(std::memory_order_acquire);
+            for (size_t i = 0; i < n; ++i) {
+                const TraceEvent& event = buffer->events[i];
+                separator();
+                out.write("{\"name\":\"");
+                writeEscaped(out, event.name);
+                out.write("\",\"ph\":\"X\",\"ts\":");
+                writeMicros(out, event.begin);
+                out.write(",\"dur\":");
+                writeMicros(out, event.duration);
+                out.write(",\"pid\":");
+                out.number(pid);
+                out.write(",\"tid\":");
+                out.number(buffer->tid);
+                out.put('}');
+            }
+        }
+        out.write("\n]}\n");
+    }
+
+    bool writeFile(const std::string& path) const {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        bool ok;
+        {
+            BufferedWriter out(fd);
+            write(out);
+            out.flush();
+            ok = out.ok();
+        }
+        ::close(fd);
+        return ok;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct ThreadBuffer {
+        std::unique_ptr<TraceEvent[]> events;   // allocated by the owning thread on its first span
+        size_t capacity{0};
+        std::atomic<size_t> size{0};            // published with release after each span
+        std::atomic<uint64_t> dropped{0};
+        uint64_t tid{0};
+        std::string name;                       // guarded by 'registryMtx'
+    };
+
+    static inline std::atomic<bool> on{false};
+
+    Clock::time_point epoch{Clock::now()};
+    std::atomic<size_t> capacity{defaultCapacity};
+    mutable std::mutex registryMtx;
+    std::vector<std::shared_ptr<ThreadBuffer>> registry;
+
+    Tracer() = default;
+
+    // the calling thread's buffer, registered on first use
+    ThreadBuffer& threadBuffer() {
+        thread_local std::shared_ptr<ThreadBuffer> local;
+        if (!local) {
+            auto buffer = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(registryMtx);
+            buffer->tid = registry.size() + 1;
+            registry.push_back(buffer);
+            local = std::move(buffer);
+        }
+        return *local;
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> snapshot() const {
+        std::lock_guard<std::mutex> lock(registryMtx);
+        return registry;
+    }
+
+    // nanoseconds as microseconds with three decimals
+    template<typename Writer>
+    static void writeMicros(Writer& out, int64_t nanos) {
+        if (nanos < 0) nanos = 0;
+        uint64_t value = static_cast<uint64_t>(nanos);
+        out.number(value / 1000);
+        char fraction[4] = {'.', static_cast<char>('0' + value / 100 % 10),
+                            static_cast<char>('0' + value / 10 % 10), static_cast<char>('0' + value % 10)};
+        out.write(std::string_view(fraction, sizeof(fraction)));
+    }
+
+    template<typename Writer>
+    static void writeEscaped(Writer& out, std::string_view text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out.put('\\');
+                out.put(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                out.put(' ');
+            } else {
+                out.put(c);
+            }
+        }
+    }
+};
+
+/**
+ * Records the lifetime of the scope as one span, see TRACE_SCOPE.
+ */
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) noexcept :
+        name(name), begin(Tracer::enabled() ? Tracer::instance().now() : -1) {}
+
+    ~TraceScope() {
+        if (begin >= 0) {
+            Tracer& tracer = Tracer::instance();
+            tracer.record(name, begin, tracer.now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    int64_t begin;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+// Traces the rest of the enclosing scope under 'name', a string literal.
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>    // for std::min, std::max, std::copy
+#include <array>
+#include <charconv>     // for std::to_chars
+#include <cmath>        // for std::pow, std::log, std::exp, std::sqrt
+#include <cstdint>
+#include <cstring>      // for std::memcpy
+#include <stdexcept>    // for std::invalid_argument
+#include <string>
+#include <string_view>
+#include <utility>      // for std::pair
+#include <vector>
+
+namespace note {
+
+/**
+ * Shape of a generated wiki, see WikiGenerator.
+ */
+struct WikiGenOptions {
+    uint64_t notes = 1000;
+    uint64_t seed = 1;
+    // content length in bytes is log-normal around 'contentMedian', capped at 'contentMax'
+    size_t contentMedian = 300;
+    double contentSigma = 1.0;
+    size_t contentMax = 64 * 1024;
+    double linkShare = 0.02;        // share of content words that are [[links]] to other notes
+    // tags of a note: 0 to 'maxTags' (at most 'WikiGenerator::maxTagLimit'), picked from the level
+    // above with a power-law of exponent 'tagSkew'
+    size_t maxTags = 3;
+    double tagSkew = 1.1;
+    // mega-hubs: 'hubs' notes ("default", "hub 2", ...) tagged by 'hubShare' of all notes
+    size_t hubs = 1;
+    double hubShare = 0.1;
+    // notes sit on 'depth' levels, each growing geometrically, tags point one level up, 0: flat
+    size_t depth = 4;
+    double cycleShare = 0.001;      // share of notes that also tag a note further down, closing cycles
+};
+
+/**
+ * splitmix64: tiny, fast, and the same integer sequence on every platform, unlike
+ * the std distributions. 'uniform' is exact too, 'normal' goes through libm.
+ */
+struct SplitMix64 {
+    uint64_t state;
+
+    uint64_t next() noexcept {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // in [0, 1)
+    double uniform() noexcept { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    // in [0, n)
+    uint64_t below(uint64_t n) noexcept { return n == 0 ? 0 : next() % n; }
+
+    // standard normal, Box-Muller
+    double normal() noexcept {
+        double u = 1.0 - uniform();
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * uniform());
+    }
+};
+
+/**
+ * Picks in [0, n), rank k with a weight of about 1/(k+1)^s, by inverting the
+ * continuous power-law. The normalization is computed once, a pick costs one pow.
+ */
+class PowerLaw {
+public:
+    PowerLaw(uint64_t n, double s) : n(n), harmonic(std::abs(s - 1.0) < 1e-9), a(1.0 - s) {
+        scale = harmonic ? std::log(static_cast<double>(n) + 1.0)
+                         : std::pow(static_cast<double>(n) + 1.0, a) - 1.0;
+    }
+
+    uint64_t size() const noexcept { return n; }
+
+    uint64_t operator()(SplitMix64& rng) const noexcept {
+        if (n <= 1) return 0;
+        double u = rng.uniform();
+        double x = harmonic ? std::exp(u * scale) : std::pow(u * scale + 1.0, 1.0 / a);
+        return std::min<uint64_t>(n - 1, static_cast<uint64_t>(x) - 1);
+    }
+
+private:
+    uint64_t n;
+    bool harmonic;
+    double a;
+    double scale;
+};
+
+/**
+ * Writes a synthetic wiki in the schema of 'NoteStore::load_json_file':
+ *      [{"title": "...", "content": "...", "tags": ["...", ...]}, ...]
+ * * Output is streamed note by note into 'Writer' (ex: BufferedWriter), nothing
+ *   but the level bounds is kept in memory, so 10M notes take seconds.
+ * * The same options and seed give the same bytes with the same C math library:
+ *   content sizes and tag picks go through exp, log, cos and pow, whose last bits
+ *   may differ between libm versions.
+ * * Every note is derived from its own id and the seed, so 'title(id)' names any
+ *   note without generating the ones before it.
+ *
+ * example:
+ *      BufferedWriter out(fd);
+ *      note::WikiGenerator gen({.notes = 10'000'000, .seed = 7});
+ *      gen.write(out);
+ */
+class WikiGenerator {
+public:
+    // the most tags a note picks from the level above, besides a hub and a cycle
+    static constexpr size_t maxTagLimit = 16;
+
+    // throws std::invalid_argument when 'options.maxTags' is over 'maxTagLimit'
+    explicit WikiGenerator(WikiGenOptions options) : opts(options) {
+        if (opts.maxTags > maxTagLimit) {
+            throw std::invalid_argument("maxTags is over " + std::to_string(maxTagLimit));
+        }
+        opts.hubs = std::min<uint64_t>(opts.hubs, opts.notes);
+        hubPick = PowerLaw(opts.hubs, opts.tagSkew);
+        // level 0 holds the hubs, level l about r^l notes, the last level the rest
+        uint64_t regular = opts.notes - opts.hubs;
+        levelStart.push_back(0);
+        levelStart.push_back(opts.hubs);
+        if (opts.depth > 1 && regular > 0) {
+            double ratio = std::max(2.0, std::pow(static_cast<double>(regular), 1.0 / static_cast<double>(opts.depth)));
+            double size = 1.0;
+            for (size_t l = 1; l < opts.depth && levelStart.back() < opts.notes; ++l) {
+                levelStart.push_back(std::min<uint64_t>(opts.notes, levelStart.back() + static_cast<uint64_t>(size)));
+                size *= ratio;
+            }
+        }
+        if (levelStart.back() < opts.notes) levelStart.push_back(opts.notes);
+        // the notes tagged from each level: flat wikis tag any regular note, leveled ones the level above
+        for (size_t level = 1; level + 1 < levelStart.size(); ++level) {
+            uint64_t lo = opts.depth > 1 ? levelStart[level - 1] : opts.hubs;
+            uint64_t hi = opts.depth > 1 ? levelStart[level] : opts.notes;
+            if (level == 1) {
+                lo = 0;
+                hi = opts.depth > 1 ? opts.hubs : opts.notes;
+            }
+            parents.push_back({lo, PowerLaw(hi - lo, opts.tagSkew)});
+        }
+    }
+
+    const WikiGenOptions& options() const noexcept { return opts; }
+
+    // "default" for the first hub, "<word> <word> <id>" for regular notes
+    std::string title(uint64_t id) const {
+        std::string out;
+        appendTitle(id, out);
+        return out;
+    }
+
+    template<typename Writer>
+    void write(Writer& out) const {
+        std::string record;
+        out.write("[\n");
+        for (uint64_t id = 0; id < opts.notes; ++id) {
+            record.clear();
+            appendNote(id, record);
+            if (id + 1 < opts.notes) record += ",\n";
+            out.write(record);
+        }
+        out.write("\n]\n");
+    }
+
+    // the JSON object of note 'id'
+    void appendNote(uint64_t id, std::string& out) const {
+        SplitMix64 rng{opts.seed * 0x100000001b3ull ^ (id + 1)};
+        out += "{\"title\":\"";
+        appendTitle(id, out);
+        out += "\",\"content\":\"";
+        appendContent(rng, out);
+        out += "\",\"tags\":[";
+        uint64_t tagged[maxTagLimit + 2];     // a hub, the picks and a cycle
+        size_t tag_count = 0;
+        auto tag = [&](uint64_t tag_id) {
+            if (tag_id == id) return;
+            for (size_t i = 0; i < tag_count; ++i) {
+                if (tagged[i] == tag_id) return;
+            }
+            if (tag_count > 0) out += ',';
+            tagged[tag_count++] = tag_id;
+            out += '"';
+            appendTitle(tag_id, out);
+            out += '"';
+        };
+
+        size_t level = levelOf(id);
+        if (level > 0 && opts.hubs > 0 && rng.uniform() < opts.hubShare) {
+            tag(hubPick(rng));
+        }
+        if (level > 0) {
+            const auto& [lo, pick] = parents[level - 1];
+            size_t tags = static_cast<size_t>(rng.below(opts.maxTags + 1));
+            for (size_t t = 0; t < tags && pick.size() > 0; ++t) {
+                tag(lo + pick(rng));
+            }
+            if (level + 1 < levelStart.size() - 1 && rng.uniform() < opts.cycleShare) {
+                uint64_t below = levelStart[level + 1];
+                tag(below + rng.below(opts.notes - below));
+            }
+        }
+        out += "]}";
+    }
+
+private:
+    WikiGenOptions opts;
+    std::vector<uint64_t> levelStart;   // first id of every level, then 'notes'
+    PowerLaw hubPick{0, 1.0};
+    std::vector<std::pair<uint64_t, PowerLaw>> parents;     // first id and picker of the tags, per level from 1
+
+    static constexpr std::string_view words[] = {
+        "note", "wiki", "graph", "idea", "draft", "project", "meeting", "design",
+        "render", "search", "memory", "cache", "thread", "queue", "index", "layout",
+        "parser", "budget", "review", "release", "bug", "fix", "test", "bench",
+        "alpha", "beta", "gamma", "delta", "river", "mountain", "forest", "ocean",
+        "coffee", "garden", "music", "travel", "recipe", "book", "paper", "letter",
+        "the", "a", "of", "and", "to", "in", "with", "for",
+        "fast", "slow", "small", "large", "old", "new", "open", "closed",
+        "red", "green", "blue", "yellow", "north", "south", "east", "west",
+    };
+    static constexpr size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    // the words padded to 8 bytes: a fixed size copy beats one of the word's length,
+    // whose branches the random words keep mispredicting
+    struct Word {
+        char text[8];
+        size_t size;
+    };
+    static constexpr auto paddedWords = [] {
+        std::array<Word, wordCount> padded{};
+        for (size_t i = 0; i < wordCount; ++i) {
+            std::copy(words[i].begin(), words[i].end(), padded[i].text);
+            padded[i].size = words[i].size();
+        }
+        return padded;
+    }();
+
+    size_t levelOf(uint64_t id) const {
+        size_t level = 0;
+        while (level + 1 < levelStart.size() && levelStart[level + 1] <= id) ++level;
+        return level;
+    }
+
+    static constexpr size_t maxTitle = 48;
+
+    // writes the title of 'id' to 'buffer' of at least 'maxTitle' bytes, returns its length
+    size_t writeTitle(uint64_t id, char* buffer) const {
+        auto put = [&buffer](std::string_view text) {
+            std::memcpy(buffer, text.data(), text.size());
+            buffer += text.size();
+        };
+        char* begin = buffer;
+        if (id < opts.hubs) {
+            if (id == 0) {
+                put("default");
+                return static_cast<size_t>(buffer - begin);
+            }
+            put("hub ");
+            return static_cast<size_t>(std::to_chars(buffer, buffer + 24, id + 1).ptr - begin);
+        }
+        SplitMix64 rng{opts.seed ^ (id * 0x9e3779b97f4a7c15ull)};
+        uint64_t pick = rng.next();
+        put(words[pick % wordCount]);
+        put(" ");
+        put(words[(pick >> 32) % wordCount]);
+        put(" ");
+        return static_cast<size_t>(std::to_chars(buffer, buffer + 24, id).ptr - begin);
+    }
+
+    void appendTitle(uint64_t id, std::string& out) const {
+        char buffer[maxTitle];
+        out.append(buffer, writeTitle(id, buffer));
+    }
+
+    // Words, [[links]] and paragraph breaks, JSON escaped, log-normal length.
+    // Written in place: the string grows once, not per word.
+    void appendContent(SplitMix64& rng, std::string& out) const {
+        double length = static_cast<double>(opts.contentMedian) * std::exp(opts.contentSigma * rng.normal());
+        size_t target = std::min(opts.contentMax, static_cast<size_t>(length));
+        // one step writes at most a link and a paragraph break past 'target'
+        constexpr size_t slack = maxTitle + 16;
+        size_t start = out.size();
+        out.resize(start + target + slack);
+        char* p = out.data() + start;
+        const char* end = p + target;
+        uint64_t link_limit = static_cast<uint64_t>(opts.linkShare * 0x1.0p53);
+        unsigned sentence = 0;
+        while (p < end) {
+            uint64_t r = rng.next();
+            if ((r >> 11) < link_limit && opts.notes > 0) {
+                std::memcpy(p, "[[", 2);
+                p += 2;
+                p += writeTitle(rng.below(opts.notes), p);
+                std::memcpy(p, "]]", 2);
+                p += 2;
+            } else {
+                const Word& word = paddedWords[r % wordCount];
+                std::memcpy(p, word.text, 8);
+                p += word.size;
+            }
+            if (++sentence % 12 != 0) {
+                *p++ = ' ';
+            } else if (sentence % 60 != 0) {
+                std::memcpy(p, ". ", 2);
+                p += 2;
+            } else {
+                std::memcpy(p, ".\\n\\n", 5);
+                p += 5;
+            }
+        }
+        out.resize(static_cast<size_t>(p - out.data()));
+    }
+};
+
+} // namespace note
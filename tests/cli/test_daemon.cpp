@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "client.hpp"
+#include "daemon.hpp"
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+using protocol::FrameResult;
+
+namespace {
+
+FrameResult parse(std::string_view buffer, uint8_t& kind, std::string_view& body, size_t& consumed) {
+    return protocol::nextFrame(buffer, kind, body, consumed);
+}
+
+std::string header(uint32_t length) {
+    std::string out;
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(static_cast<char>((length >> shift) & 0xff));
+    return out;
+}
+
+} // namespace
+
+TEST(Protocol, FrameRoundTrips) {
+    std::string buffer;
+    protocol::appendFrame(buffer, 7, std::string_view("body\0with a zero", 16));
+    ASSERT_EQ(buffer.size(), protocol::headerSize + 1 + 16);
+    uint8_t kind = 0;
+    std::string_view body;
+    size_t consumed = 0;
+    ASSERT_EQ(parse(buffer, kind, body, consumed), FrameResult::Complete);
+    EXPECT_EQ(kind, 7);
+    EXPECT_EQ(body, std::string_view("body\0with a zero", 16));
+    EXPECT_EQ(consumed, buffer.size());
+}
+
+TEST(Protocol, AppendFrameRefusesOversizeBodies) {
+    std::string buffer = "kept";
+    std::string body(protocol::maxPayload, 'x');
+    EXPECT_FALSE(protocol::appendFrame(buffer, 1, body));
+    EXPECT_EQ(buffer, "kept");
+    body.pop_back();
+    EXPECT_TRUE(protocol::appendFrame(buffer, 1, body));
+    EXPECT_EQ(buffer.size(), 4 + protocol::headerSize + protocol::maxPayload);
+}
+
+TEST(Protocol, FrameWriterSplitsLongReplies) {
+    std::string out;
+    std::string text(2 * protocol::replyChunk + 10, 'x');
+    {
+        protocol::FrameWriter writer(out);
+        writer.write(text);
+        writer.put('-');
+        writer.number(42);
+        writer.finish(protocol::Status::Ok);
+    }
+    std::string_view rest = out;
+    std::string joined;
+    std::vector<uint8_t> kinds;
+    uint8_t kind;
+    std::string_view body;
+    size_t consumed;
+    while (parse(rest, kind, body, consumed) == FrameResult::Complete) {
+        EXPECT_LE(body.size(), protocol::replyChunk);
+        kinds.push_back(kind);
+        joined.append(body);
+        rest.remove_prefix(consumed);
+    }
+    EXPECT_TRUE(rest.empty());
+    auto more = static_cast<uint8_t>(protocol::Status::More);
+    EXPECT_EQ(kinds, (std::vector<uint8_t>{more, more, static_cast<uint8_t>(protocol::Status::Ok)}));
+    EXPECT_EQ(joined, text + "-42");
+
+    // an empty reply is one frame with just the status
+    out.clear();
+    protocol::FrameWriter(out).finish(protocol::Status::NotFound);
+    ASSERT_EQ(parse(out, kind, body, consumed), FrameResult::Complete);
+    EXPECT_EQ(kind, static_cast<uint8_t>(protocol::Status::NotFound));
+    EXPECT_TRUE(body.empty());
+    EXPECT_EQ(consumed, out.size());
+}
+
+TEST(Protocol, ShortFramesAreIncomplete) {
+    std::string buffer;
+    protocol::appendFrame(buffer, 1, "title");
+    uint8_t kind;
+    std::string_view body;
+    size_t consumed;
+    for (size_t size = 0; size < buffer.size(); ++size) {
+        EXPECT_EQ(parse(std::string_view(buffer).substr(0, size), kind, body, consumed), FrameResult::Incomplete)
+            << size;
+    }
+}
+
+TEST(Protocol, EmptyAndOversizeFramesAreInvalid) {
+    uint8_t kind;
+    std::string_view body;
+    size_t consumed;
+    EXPECT_EQ(parse(header(0), kind, body, consumed), FrameResult::Invalid);
+    // known to be invalid from the header alone, nothing more is read
+    EXPECT_EQ(parse(header(protocol::maxPayload + 1), kind, body, consumed), FrameResult::Invalid);
+    EXPECT_EQ(parse(header(UINT32_MAX), kind, body, consumed), FrameResult::Invalid);
+    EXPECT_EQ(parse(header(protocol::maxPayload), kind, body, consumed), FrameResult::Incomplete);
+}
+
+TEST(Protocol, FramesBackToBack) {
+    std::string buffer;
+    protocol::appendFrame(buffer, 1, "first");
+    protocol::appendFrame(buffer, 2, "");
+    protocol::appendFrame(buffer, 3, "third");
+    std::string_view rest = buffer;
+    std::string seen;
+    uint8_t kind;
+    std::string_view body;
+    size_t consumed;
+    while (parse(rest, kind, body, consumed) == FrameResult::Complete) {
+        seen += std::to_string(kind) + ":" + std::string(body) + ";";
+        rest.remove_prefix(consumed);
+    }
+    EXPECT_EQ(seen, "1:first;2:;3:third;");
+    EXPECT_TRUE(rest.empty());
+}
+
+// A daemon serving a store in a temporary directory from its own thread.
+class DaemonTest : public ::testing::Test {
+protected:
+    fs::path dir;
+    Options opts;
+    std::unique_ptr<NoteDaemon> daemon;
+    std::thread server;
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / ("daemon_test_" + std::to_string(::getpid()));
+        fs::create_directories(dir);
+        opts.storage_path = (dir / "notes.json").string();
+        opts.socket_path = (dir / "sock").string();
+        std::ofstream(opts.storage_path) << R"([
+            {"title": "a", "content": "first", "tags": ["default"]},
+            {"title": "b", "content": "second", "tags": ["default"]}
+        ])";
+        daemon = std::make_unique<NoteDaemon>(opts, 20ms);
+        server = std::thread([this] { daemon->run(); });
+        // serving once a client gets in
+        auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (std::chrono::steady_clock::now() < deadline && !DaemonClient().connect(opts.socket_path)) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    void TearDown() override {
+        NoteDaemon::stop();
+        server.join();
+        daemon.reset();
+        fs::remove_all(dir);
+    }
+
+    std::string stored() const {
+        std::ifstream in(opts.storage_path);
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    // a raw connection, for frames DaemonClient doesn't send
+    int connectRaw() const {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        opts.socket_path.copy(addr.sun_path, opts.socket_path.size());
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        return fd;
+    }
+};
+
+TEST_F(DaemonTest, AnswersGetAndSearch) {
+    DaemonClient client;
+    ASSERT_TRUE(client.connect(opts.socket_path));
+    protocol::Status status;
+    std::string reply;
+    ASSERT_TRUE(client.request(protocol::Op::Get, "a", status, reply));
+    EXPECT_EQ(status, protocol::Status::Ok);
+    EXPECT_NE(reply.find(R"("content":"first")"), std::string::npos) << reply;
+
+    ASSERT_TRUE(client.request(protocol::Op::Get, "missing", status, reply));
+    EXPECT_EQ(status, protocol::Status::NotFound);
+
+    std::string search = {static_cast<char>(QueryField::Tag), static_cast<char>(QueryFormat::JsonLines)};
+    ASSERT_TRUE(client.request(protocol::Op::Search, search + "default", status, reply));
+    EXPECT_EQ(status, protocol::Status::Ok);
+    EXPECT_EQ(std::count(reply.begin(), reply.end(), '\n'), 2);
+}
+
+TEST_F(DaemonTest, RejectsBadRequests) {
+    DaemonClient client;
+    ASSERT_TRUE(client.connect(opts.socket_path));
+    protocol::Status status;
+    std::string reply;
+    ASSERT_TRUE(client.request(protocol::Op::Search, "x", status, reply));     // no field and format
+    EXPECT_EQ(status, protocol::Status::BadRequest);
+    ASSERT_TRUE(client.request(protocol::Op::Search, std::string("\x09\x00q", 3), status, reply));
+    EXPECT_EQ(status, protocol::Status::BadRequest);
+    ASSERT_TRUE(client.request(protocol::Op::Update, "no content separator", status, reply));
+    EXPECT_EQ(status, protocol::Status::BadRequest);
+    ASSERT_TRUE(client.request(static_cast<protocol::Op>(42), "", status, reply));
+    EXPECT_EQ(status, protocol::Status::BadRequest);
+    // the connection still works
+    ASSERT_TRUE(client.request(protocol::Op::Get, "b", status, reply));
+    EXPECT_EQ(status, protocol::Status::Ok);
+}
+
+TEST_F(DaemonTest, ShortFramesWaitForTheRest) {
+    int fd = connectRaw();
+    std::string frame;
+    protocol::appendFrame(frame, static_cast<uint8_t>(protocol::Op::Get), "a");
+    for (char c : frame) {
+        ASSERT_EQ(::send(fd, &c, 1, MSG_NOSIGNAL), 1);
+        std::this_thread::sleep_for(1ms);
+    }
+    std::string buffer(4096, '\0');
+    ssize_t n = ::recv(fd, buffer.data(), buffer.size(), 0);
+    ASSERT_GT(n, 0);
+    uint8_t kind;
+    std::string_view body;
+    size_t consumed;
+    EXPECT_EQ(protocol::nextFrame(std::string_view(buffer.data(), static_cast<size_t>(n)), kind, body, consumed),
+              FrameResult::Complete);
+    EXPECT_EQ(kind, static_cast<uint8_t>(protocol::Status::Ok));
+    ::close(fd);
+}
+
+TEST_F(DaemonTest, OversizeFrameClosesTheConnection) {
+    int fd = connectRaw();
+    std::string bad = header(protocol::maxPayload + 1);
+    ASSERT_EQ(::send(fd, bad.data(), bad.size(), MSG_NOSIGNAL), static_cast<ssize_t>(bad.size()));
+    char byte;
+    EXPECT_EQ(::recv(fd, &byte, 1, 0), 0);  // hung up, no reply
+    ::close(fd);
+
+    // other clients are still served
+    DaemonClient client;
+    ASSERT_TRUE(client.connect(opts.socket_path));
+    protocol::Status status;
+    std::string reply;
+    ASSERT_TRUE(client.request(protocol::Op::Get, "a", status, reply));
+    EXPECT_EQ(status, protocol::Status::Ok);
+}
+
+TEST_F(DaemonTest, RepliesOverTheFrameLimit) {
+    DaemonClient client;
+    ASSERT_TRUE(client.connect(opts.socket_path));
+    protocol::Status status;
+    std::string reply;
+    // five notes of 14 MiB: each update fits in a frame, a search for all of them doesn't
+    std::string content(14u << 20, 'x');
+    content += " needle";
+    for (char n = '1'; n <= '5'; ++n) {
+        ASSERT_TRUE(client.request(protocol::Op::Update, std::string("big ") + n + '\0' + content, status, reply));
+        ASSERT_EQ(status, protocol::Status::Ok);
+    }
+    std::string search = {static_cast<char>(QueryField::Content), static_cast<char>(QueryFormat::JsonLines)};
+    ASSERT_TRUE(client.request(protocol::Op::Search, search + "needle", status, reply));
+    EXPECT_EQ(status, protocol::Status::Ok);
+    EXPECT_GT(reply.size(), protocol::maxPayload);
+    EXPECT_EQ(std::count(reply.begin(), reply.end(), '\n'), 5);
+    EXPECT_EQ(reply.compare(reply.size() - 9, 9, "needle\"}\n"), 0);
+
+    // a request over the limit is refused before it is sent, the connection stays usable
+    EXPECT_FALSE(client.request(protocol::Op::Update, std::string(protocol::maxPayload, 'x'), status, reply));
+    ASSERT_TRUE(client.request(protocol::Op::Get, "a", status, reply));
+    EXPECT_EQ(status, protocol::Status::Ok);
+}
+
+TEST_F(DaemonTest, UpdatesAreSavedWhileServing) {
+    DaemonClient client;
+    ASSERT_TRUE(client.connect(opts.socket_path));
+    protocol::Status status;
+    std::string reply;
+    ASSERT_TRUE(client.request(protocol::Op::Update, std::string("a\0edited", 8), status, reply));
+    EXPECT_EQ(status, protocol::Status::Ok);
+    ASSERT_TRUE(client.request(protocol::Op::Update, std::string("new note\0made here", 18), status, reply));
+    EXPECT_EQ(status, protocol::Status::Ok);
+
+    // saved 'saveDelay' later, without stopping the daemon
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (std::chrono::steady_clock::now() < deadline && stored().find("made here") == std::string::npos) {
+        std::this_thread::sleep_for(5ms);
+    }
+    std::string text = stored();
+    EXPECT_NE(text.find("made here"), std::string::npos);
+    EXPECT_NE(text.find("edited"), std::string::npos);
+    EXPECT_EQ(text.find("first"), std::string::npos);
+}
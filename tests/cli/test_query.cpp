@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "buffered_writer.h"
+#include "query.hpp"
+
+namespace fs = std::filesystem;
+
+class NoteQueryTest : public ::testing::Test {
+protected:
+    fs::path path;
+
+    void SetUp() override {
+        path = fs::temp_directory_path() / ("note_query_test_" + std::to_string(::getpid()) + ".json");
+        std::ofstream(path) << R"([
+            {"title": "post", "content": "line\none", "tags": ["rust, c++", "tab\tbed", "back\\slash"]},
+            {"title": "other", "content": "not a match", "tags": []}
+        ])";
+    }
+    void TearDown() override { fs::remove(path); }
+
+    std::string query(const std::string& text, QueryField field, QueryFormat format) {
+        NoteStore store(path.string());
+        std::string result;
+        StringWriter out(result);
+        NoteQuery<StringWriter>(store, format, out).run(text, field);
+        return result;
+    }
+};
+
+TEST_F(NoteQueryTest, TsvEscapesCommasInTitleLists) {
+    std::string tsv = query("post", QueryField::Title, QueryFormat::Tsv);
+    EXPECT_EQ(tsv.substr(0, tsv.find('\n')), "id\ttitle\ttags\tkids\tcontent");
+    EXPECT_NE(tsv.find("\tpost\trust\\, c++,tab\\tbed,back\\\\slash\t\tline\\none\n"), std::string::npos) << tsv;
+}
+
+TEST_F(NoteQueryTest, TsvKeepsCommasOutsideLists) {
+    std::ofstream(path) << R"([{"title": "a, b", "content": "x, y", "tags": []}])";
+    std::string tsv = query("a", QueryField::Title, QueryFormat::Tsv);
+    EXPECT_NE(tsv.find("\ta, b\t\t\tx, y\n"), std::string::npos) << tsv;
+}
+
+TEST_F(NoteQueryTest, JsonLinesKeepTitlesWhole) {
+    std::string json = query("post", QueryField::Title, QueryFormat::JsonLines);
+    EXPECT_NE(json.find(R"("tags":["rust, c++","tab\tbed","back\\slash"])"), std::string::npos) << json;
+    EXPECT_NE(json.find(R"("content":"line\none")"), std::string::npos) << json;
+}
+
+TEST_F(NoteQueryTest, TagQueryListsTheKids) {
+    std::string json = query("rust, c++", QueryField::Tag, QueryFormat::JsonLines);
+    EXPECT_NE(json.find(R"("title":"post")"), std::string::npos) << json;
+    EXPECT_EQ(json.find(R"("title":"other")"), std::string::npos) << json;
+}
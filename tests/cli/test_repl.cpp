@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "buffered_writer.h"
+#include "cli_viewer.hpp"
+#include "repl.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// the text of every row of 'pager', from a render of all of them
+std::vector<std::string> pagerRows(const Pager& pager) {
+    std::string screen;
+    StringWriter out(screen);
+    pager.render(out);
+    std::vector<std::string> rows;
+    std::string_view rest = std::string_view(screen).substr(std::string_view("\033[H\033[2J").size());
+    for (size_t i = 0; i < pager.rowCount(); ++i) {
+        size_t end = rest.find('\n');
+        rows.emplace_back(rest.substr(0, end));
+        rest.remove_prefix(end + 1);
+    }
+    return rows;
+}
+
+using Rows = std::vector<std::string>;
+
+} // namespace
+
+TEST(Utf8, DecodesCodePoints) {
+    std::string_view text = "a\xc3\xa9\xe6\x97\xa5\xf0\x9f\x98\x80";
+    size_t i = 0;
+    EXPECT_EQ(decodeUtf8(text, i), U'a');
+    EXPECT_EQ(decodeUtf8(text, i), U'é');
+    EXPECT_EQ(decodeUtf8(text, i), U'日');
+    EXPECT_EQ(decodeUtf8(text, i), U'\U0001f600');
+    EXPECT_EQ(i, text.size());
+}
+
+TEST(Utf8, InvalidBytesAreOneByteEach) {
+    std::string_view text = "\xff\xc3(\xe6\x97";
+    size_t i = 0;
+    EXPECT_EQ(decodeUtf8(text, i), 0xffu);
+    EXPECT_EQ(decodeUtf8(text, i), 0xc3u);     // not followed by a continuation byte
+    EXPECT_EQ(decodeUtf8(text, i), U'(');
+    EXPECT_EQ(decodeUtf8(text, i), 0xe6u);     // cut off at the end
+    EXPECT_EQ(i, 4u);
+}
+
+TEST(Utf8, DisplayWidth) {
+    EXPECT_EQ(displayWidth(U'a'), 1u);
+    EXPECT_EQ(displayWidth(U'é'), 1u);
+    EXPECT_EQ(displayWidth(U'́'), 0u);    // combining acute accent
+    EXPECT_EQ(displayWidth(U'日'), 2u);
+    EXPECT_EQ(displayWidth(U'가'), 2u);    // Hangul
+    EXPECT_EQ(displayWidth(U'\U0001f600'), 2u);
+    EXPECT_EQ(displayWidth(U'\x1b'), 0u);
+}
+
+TEST(Pager, WrapsAsciiLines) {
+    Pager pager("abcdefgh\n\nxy", {.rows = 24, .cols = 3});
+    EXPECT_EQ(pagerRows(pager), (Rows{"abc", "def", "gh", "", "xy"}));
+}
+
+TEST(Pager, NeverSplitsACodePoint) {
+    // 'é' is two bytes and one column: four of them fit four columns
+    Pager pager("\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9", {.rows = 24, .cols = 4});
+    EXPECT_EQ(pagerRows(pager), (Rows{"\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9", "\xc3\xa9"}));
+}
+
+TEST(Pager, WideCharactersTakeTwoColumns) {
+    // three columns hold one wide character and one narrow one
+    Pager pager("\xe6\x97\xa5\xe6\x97\xa5x\xe6\x97\xa5", {.rows = 24, .cols = 3});
+    EXPECT_EQ(pagerRows(pager), (Rows{"\xe6\x97\xa5", "\xe6\x97\xa5x", "\xe6\x97\xa5"}));
+    // wider than the whole row, it still gets one
+    Pager narrow("\xe6\x97\xa5\xe6\x97\xa5", {.rows = 24, .cols = 1});
+    EXPECT_EQ(narrow.rowCount(), 2u);
+}
+
+TEST(Pager, CombiningMarksStayWithTheirLetter) {
+    Pager pager("ae\xcc\x81" "b", {.rows = 24, .cols = 2});
+    EXPECT_EQ(pagerRows(pager), (Rows{"ae\xcc\x81", "b"}));
+}
+
+TEST(Pager, TabsExpandToTheTabWidth) {
+    Pager pager("a\tb\n\tc", {.rows = 24, .cols = 80}, 4);
+    EXPECT_EQ(pagerRows(pager), (Rows{"a   b", "    c"}));
+    // a tab that doesn't fit starts the next row
+    Pager wrapped("abcdef\tx", {.rows = 24, .cols = 7}, 4);
+    EXPECT_EQ(pagerRows(wrapped), (Rows{"abcdef", "    x"}));
+}
+
+TEST(Pager, PagesThroughTheRows) {
+    std::string text;
+    for (int i = 0; i < 10; ++i) text += "line " + std::to_string(i) + "\n";
+    Pager pager(text, {.rows = 5, .cols = 80});
+    EXPECT_EQ(pager.rowCount(), 11u);   // the empty row after the last newline
+    EXPECT_EQ(pager.pageRows(), 4u);
+    EXPECT_FALSE(pager.atEnd());
+    pager.next();
+    pager.next();
+    EXPECT_TRUE(pager.atEnd());
+    std::string screen;
+    StringWriter out(screen);
+    pager.render(out);
+    EXPECT_NE(screen.find("line 8\nline 9\n"), std::string::npos);
+    EXPECT_NE(screen.find("-- lines 9-11 of 11 (end)"), std::string::npos) << screen;
+    pager.next();
+    EXPECT_TRUE(pager.atEnd());
+    pager.previous();
+    pager.previous();
+    pager.previous();
+    screen.clear();
+    pager.render(out);
+    EXPECT_NE(screen.find("-- lines 1-4 of 11 [enter]"), std::string::npos) << screen;
+}
+
+class ReplTest : public ::testing::Test {
+protected:
+    fs::path path;
+    fs::path screenPath;
+
+    void SetUp() override {
+        std::string stem = "repl_test_" + std::to_string(::getpid());
+        path = fs::temp_directory_path() / (stem + ".json");
+        screenPath = fs::temp_directory_path() / (stem + ".out");
+        std::ofstream(path) << R"([
+            {"title": "alpha", "content": "first", "tags": ["default"]},
+            {"title": "alps", "content": "second", "tags": ["default"]},
+            {"title": "beta", "content": "third\nline", "tags": ["alpha"]}
+        ])";
+    }
+    void TearDown() override {
+        fs::remove(path);
+        fs::remove(screenPath);
+    }
+
+    // everything the REPL drew while running 'commands'
+    std::string run(const std::string& commands) {
+        Options opts;
+        opts.storage_path = path.string();
+        std::istringstream in(commands);
+        int fd = ::open(screenPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        EXPECT_GE(fd, 0);
+        {
+            CliViewer viewer(opts, in, fd);
+            EXPECT_EQ(viewer.run(), 0);
+        }
+        ::close(fd);
+        std::ifstream screen(screenPath);
+        std::stringstream text;
+        text << screen.rdbuf();
+        return text.str();
+    }
+};
+
+TEST(TitleIndex, CompletesExactAndUniquePrefixes) {
+    fs::path path = fs::temp_directory_path() / ("title_index_test_" + std::to_string(::getpid()) + ".json");
+    std::ofstream(path) << R"([
+        {"title": "alpha", "content": "", "tags": []},
+        {"title": "alps", "content": "", "tags": []},
+        {"title": "al", "content": "", "tags": []},
+        {"title": "beta", "content": "", "tags": []}
+    ])";
+    NoteStore store(path.string());
+    fs::remove(path);
+    TitleIndex index;
+    std::vector<std::string_view> candidates;
+
+    EXPECT_EQ(index.complete(store, "al", candidates), store.findId("al"));      // exact, though a prefix too
+    EXPECT_EQ(index.complete(store, "b", candidates), store.findId("beta"));
+    EXPECT_EQ(index.complete(store, "alp", candidates), 0u);
+    EXPECT_EQ(candidates, (std::vector<std::string_view>{"alpha", "alps"}));
+    EXPECT_EQ(index.complete(store, "alp", candidates, 1), 0u);
+    EXPECT_EQ(candidates.size(), 1u);
+    EXPECT_EQ(index.complete(store, "z", candidates), 0u);
+    EXPECT_TRUE(candidates.empty());
+
+    // a new note is seen at the next call
+    store.addNote("gamma", "", {}, {});
+    EXPECT_EQ(index.complete(store, "g", candidates), store.findId("gamma"));
+}
+
+TEST_F(ReplTest, OpensAndClosesNotes) {
+    std::string screen = run("open beta\nls\nclose alpha\nls\nq\n");
+    EXPECT_NE(screen.find("]  beta\n"), std::string::npos) << screen;
+    EXPECT_NE(screen.find("open notes:\n  1. alpha\n  2. beta\n  3. alps\n"), std::string::npos) << screen;
+    EXPECT_NE(screen.find("open notes:\n  1. beta\n  2. alps\n"), std::string::npos) << screen;
+}
+
+TEST_F(ReplTest, CompletesTitlesAndListNumbers) {
+    std::string screen = run("open be\nopen alp\ntags\nopen 1\nq\n");
+    EXPECT_NE(screen.find("]  beta\n"), std::string::npos) << screen;
+    EXPECT_NE(screen.find("did you mean:\n  alpha\n  alps\n"), std::string::npos) << screen;
+    EXPECT_NE(screen.find("tags:\n  1. alpha\n"), std::string::npos) << screen;
+    EXPECT_NE(screen.find("[1/3]  alpha\n"), std::string::npos) << screen;
+}
+
+TEST_F(ReplTest, ReportsUnknownCommands) {
+    std::string screen = run("frobnicate\nhelp\n");     // ends at the end of the input
+    EXPECT_NE(screen.find("unknown command 'frobnicate', try 'help'"), std::string::npos) << screen;
+    EXPECT_NE(screen.find("open <title|n>"), std::string::npos) << screen;
+}
+
+TEST_F(ReplTest, ShowPagesTheContent) {
+    std::string screen = run("show beta\nq\nq\n");
+    EXPECT_NE(screen.find("third\nline\n-- lines 1-2 of 2 (end)"), std::string::npos) << screen;
+}
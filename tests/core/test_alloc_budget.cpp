@@ -0,0 +1,341 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// the counting global allocator, this is the only translation unit of core_tests that includes it
+#include "alloc_counter.h"
+#include "buffered_writer.h"
+#include "note.hpp"
+#include "parser.h"
+#include "tokenizer.h"
+#include "viewstate.hpp"
+#include "wiki_gen.hpp"
+
+namespace fs = std::filesystem;
+
+// Allocation and byte budgets of the core operations: going over a budget fails
+// like any other bug. Budgets are upper bounds, derived from the data where the
+// small string buffer decides if a string allocates.
+
+namespace {
+
+const size_t smallString = std::string().capacity();
+
+// allocations of a copy of 's'
+size_t stringAllocs(const std::string& s) { return s.size() > smallString ? 1 : 0; }
+
+size_t stringBytes(const std::string& s) { return s.size() > smallString ? s.size() + 1 : 0; }
+
+} // namespace
+
+class AllocBudget : public ::testing::Test {
+protected:
+    fs::path path;
+    std::unique_ptr<NoteStore> store;
+
+    void SetUp() override {
+        // the logger starts its thread on first use, not inside a measured scope
+        Logger::getInstance();
+        path = fs::temp_directory_path() / ("alloc_budget_test_" + std::to_string(::getpid()) + ".json");
+        std::string json;
+        StringWriter out(json);
+        note::WikiGenerator({.notes = 2000, .seed = 3, .contentMedian = 200}).write(out);
+        std::ofstream(path) << json;
+        store = std::make_unique<NoteStore>(path.string());
+    }
+    void TearDown() override { fs::remove(path); }
+
+    // a note with tags and kids, the most tagged one
+    NoteId busyNote() const {
+        NoteId best = 1;
+        for (NoteId id = 1; id <= store->lastId(); ++id) {
+            const NoteData& note = store->getNote(id);
+            if (!note.tags.empty() && note.kids.size() > store->getNote(best).kids.size()) best = id;
+        }
+        return best;
+    }
+};
+
+TEST_F(AllocBudget, LookupsDoNotAllocate) {
+    const NoteStore& s = *store;
+    NoteId id = busyNote();
+    const std::string title = s.getNote(id).title;
+    alloc_counter::Scope scope;
+    EXPECT_EQ(s.getId(title), id);
+    EXPECT_EQ(s.findId(title), id);
+    EXPECT_EQ(s.findId("no such note"), 0u);
+    EXPECT_NE(s.findNote(id), nullptr);
+    EXPECT_EQ(&s.getNote(id), s.findNote(id));
+    EXPECT_EQ(scope.allocations(), 0u);
+}
+
+TEST_F(AllocBudget, GetNoteStringsBuildsEachStringOnce) {
+    NoteId id = busyNote();
+    const NoteData& note = store->getNote(id);
+    size_t allocs = stringAllocs(note.title) + stringAllocs(note.content) + 2;
+    size_t bytes = stringBytes(note.title) + stringBytes(note.content) +
+                   (note.tags.size() + note.kids.size()) * sizeof(std::string);
+    for (NoteId tag : note.tags) {
+        allocs += stringAllocs(store->getNote(tag).title);
+        bytes += stringBytes(store->getNote(tag).title);
+    }
+    for (NoteId kid : note.kids) {
+        allocs += stringAllocs(store->getNote(kid).title);
+        bytes += stringBytes(store->getNote(kid).title);
+    }
+
+    alloc_counter::Scope scope;
+    NoteDataStrings strings = store->getNoteStrings(id);
+    EXPECT_LE(scope.allocations(), allocs);
+    EXPECT_LE(scope.bytes(), bytes);
+    EXPECT_EQ(strings.kids.size(), note.kids.size());
+}
+
+TEST_F(AllocBudget, NoteViewDoesNotAllocate) {
+    NoteId id = busyNote();
+    const NoteStore& s = *store;
+    alloc_counter::Scope scope;
+    NoteDataView note = s.getNoteView(id);
+    size_t bytes = note.title.size() + note.content.size();
+    for (std::string_view tag : note.tags) bytes += tag.size();
+    for (std::string_view kid : note.kids) bytes += kid.size();
+    EXPECT_EQ(scope.allocations(), 0u);
+    EXPECT_GT(bytes, 0u);
+}
+
+TEST_F(AllocBudget, NoOpUpdateDoesNotAllocate) {
+    NoteId id = busyNote();
+    NoteDataStrings strings = store->getNoteStrings(id);
+    uint64_t version = store->version();
+    alloc_counter::Scope scope;
+    store->updateNote(id, strings.title, strings.content, strings.tags, strings.kids);
+    EXPECT_EQ(scope.allocations(), 0u);
+    EXPECT_EQ(store->version(), version);
+}
+
+TEST_F(AllocBudget, ContentUpdateReusesTheNote) {
+    NoteId id = busyNote();
+    NoteDataStrings strings = store->getNoteStrings(id);
+    const std::string contents[2] = {std::string(500, 'a'), std::string(500, 'b')};
+    store->updateNote(id, strings.title, contents[0], strings.tags, strings.kids);
+
+    // the content fits the note's buffer: only the two id lists are built
+    alloc_counter::Scope scope;
+    for (int i = 1; i <= 10; ++i) {
+        store->updateNote(id, strings.title, contents[i & 1], strings.tags, strings.kids);
+    }
+    EXPECT_LE(scope.allocations(), 10u * 2);
+    EXPECT_LE(scope.bytes(), 10u * (strings.tags.size() + strings.kids.size()) * sizeof(NoteId));
+    EXPECT_EQ(store->getNote(id).content, contents[0]);
+}
+
+TEST_F(AllocBudget, AddNoteAmortized) {
+    const std::vector<std::string> tags = {store->getNote(1).title, store->getNote(2).title};
+    constexpr size_t notes = 1000;
+    alloc_counter::Scope scope;
+    for (size_t i = 0; i < notes; ++i) {
+        store->addNote("added " + std::to_string(i), "short content", tags, {});
+    }
+    // the title, two map nodes and the tag list per note, plus the tags' growing kid lists and rehashes
+    EXPECT_LE(scope.allocations(), notes * 5);
+}
+
+TEST_F(AllocBudget, SaveDoesNotCopyTagNotes) {
+    // popular tags with long contents and kid lists, copying them per tag reference shows up in bytes
+    NoteId hub = store->findId("default");
+    const NoteData& hubNote = store->getNote(hub);
+    store->updateNote(hub, hubNote.title, std::string(64 * 1024, 'x'), {}, {});
+    fs::path saved = path.string() + ".saved";
+    alloc_counter::Scope scope;
+    store->save_json_file(saved.string());
+    size_t written = fs::file_size(saved);
+    fs::remove(saved);
+    EXPECT_LE(scope.bytes(), written * 8);
+}
+
+TEST(AllocCounter, CountsAlignedAndNothrowForms) {
+    struct alignas(64) Line { char bytes[64]; };
+    Line* volatile line = nullptr;
+    Line* volatile lines = nullptr;
+    int* volatile number = nullptr;
+    alloc_counter::Scope scope;
+    line = new Line;
+    lines = new Line[3];
+    number = new (std::nothrow) int(7);
+    EXPECT_EQ(scope.allocations(), 3u);
+    EXPECT_EQ(scope.bytes(), sizeof(Line) + 3 * sizeof(Line) + sizeof(int));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(line) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(lines) % 64, 0u);
+    EXPECT_EQ(*number, 7);
+    delete line;
+    delete[] lines;
+    delete number;
+}
+
+TEST(AllocBudgetParse, OneAllocationForShortWords) {
+    std::string_view words = "beta, alpha gamma,,delta alpha";
+    alloc_counter::Scope scope;
+    std::vector<std::string> keys = parseWords(words);
+    EXPECT_EQ(scope.allocations(), 1u);
+    EXPECT_EQ(keys, (std::vector<std::string>{"alpha", "beta", "delta", "gamma"}));
+}
+
+TEST(AllocBudgetParse, LongWordsAllocateOnce) {
+    std::string long_word(smallString + 10, 'w');
+    std::string words = long_word + " a " + long_word + "x b";
+    alloc_counter::Scope scope;
+    std::vector<std::string> keys = parseWords(words);
+    EXPECT_EQ(scope.allocations(), 1u + 2);
+    EXPECT_EQ(keys.size(), 4u);
+}
+
+TEST(AllocBudgetParse, TokenizerAllocatesOnlyTheList) {
+    std::string_view words = R"(beta, alpha "gamma delta",,alpha beta)";
+    tokenizer::Tokenizer tokenizer;
+    std::vector<std::string_view> keys;
+    alloc_counter::Scope scope;
+    tokenizer.tokenize(words, keys);
+    EXPECT_EQ(scope.allocations(), 1u);
+    EXPECT_EQ(keys, (std::vector<std::string_view>{"beta", "alpha", "gamma delta"}));
+
+    // the list and the hash set are reused
+    scope.reset();
+    tokenizer.tokenize(words, keys);
+    EXPECT_EQ(scope.allocations(), 0u);
+}
+
+TEST(AllocBudgetParse, TokenizerReusesTheLargeHashSet) {
+    std::string words;
+    for (size_t i = 0; i < 4 * tokenizer::Tokenizer::inlineTokens; ++i) words += "w" + std::to_string(i) + " ";
+    tokenizer::Tokenizer tokenizer;
+    std::vector<std::string_view> keys;
+    tokenizer.tokenize(words, keys);
+    alloc_counter::Scope scope;
+    tokenizer.tokenize(words, keys);
+    EXPECT_EQ(scope.allocations(), 0u);
+    EXPECT_EQ(keys.size(), 4 * tokenizer::Tokenizer::inlineTokens);
+}
+
+TEST_F(AllocBudget, ViewStateSteadyOperationsDoNotAllocate) {
+    ViewState view;
+    std::vector<NoteId> kids = store->getKids("default");
+    view.addFromKids(kids);
+    ASSERT_GE(view.view().size(), 3u);
+    NoteId first = view.view().front().id;
+    NoteId second = view.view()[1].id;
+    NoteListState& lists = view.getLists(busyNote());
+    const NoteData& busy = store->getNote(busyNote());
+    view.sorted(lists.kids, busy.kids, busy.modified, ListSort::Title, *store);
+
+    alloc_counter::Scope scope;
+    view.moveDown(first);
+    view.moveUp(first);
+    view.addId(second);                 // already visible
+    EXPECT_TRUE(view.isVisible(first));
+    view.getNote(first);
+    view.getLists(busyNote());
+    view.sorted(lists.kids, busy.kids, busy.modified, ListSort::Title, *store);
+    view.sorted(lists.kids, busy.kids, busy.modified, ListSort::Stored, *store);
+    EXPECT_EQ(scope.allocations(), 0u);
+}
+
+TEST_F(AllocBudget, ViewStateSortRebuildReusesTheCache) {
+    ViewState view;
+    NoteId id = busyNote();
+    NoteListState& lists = view.getLists(id);
+    const NoteData& busy = store->getNote(id);
+    view.sorted(lists.kids, busy.kids, busy.modified, ListSort::Recent, *store);
+    NoteDataStrings strings = store->getNoteStrings(id);
+    store->updateNote(id, strings.title, strings.content + " edited", strings.tags, strings.kids);
+
+    alloc_counter::Scope scope;
+    const auto& sorted = view.sorted(lists.kids, busy.kids, busy.modified, ListSort::Recent, *store);
+    EXPECT_EQ(scope.allocations(), 0u);
+    EXPECT_EQ(sorted.size(), busy.kids.size());
+}
+
+TEST_F(AllocBudget, ViewStateSortMergesChangedKids) {
+    ViewState view;
+    NoteId id = busyNote();
+    NoteListState& lists = view.getLists(id);
+    const NoteData& busy = store->getNote(id);
+    view.sorted(lists.kids, busy.kids, busy.modified, ListSort::Title, *store);
+    auto editKid = [&](NoteId kid) {
+        NoteDataStrings strings = store->getNoteStrings(kid);
+        store->updateNote(kid, "0 " + strings.title, strings.content, strings.tags, strings.kids);
+    };
+    // the first merge sizes the scratch list
+    editKid(busy.kids.front());
+    view.sorted(lists.kids, busy.kids, busy.modified, ListSort::Title, *store);
+    editKid(busy.kids.back());
+
+    alloc_counter::Scope scope;
+    const auto& sorted = view.sorted(lists.kids, busy.kids, busy.modified, ListSort::Title, *store);
+    EXPECT_EQ(scope.allocations(), 0u);
+    ASSERT_EQ(sorted.size(), busy.kids.size());
+    EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end(), [&](NoteId a, NoteId b) {
+        return store->getNote(a).title < store->getNote(b).title;
+    }));
+}
+
+TEST_F(AllocBudget, EditReusesTheEditBuffers) {
+    ViewState view;
+    NoteId id = busyNote();
+    NoteDataStrings strings = store->getNoteStrings(id);
+    view.addId(id);
+    view.startEdit(id, store->getNoteView(id));
+    view.stopEdit(id);
+
+    // a second edit of the same note fits in the buffers of the first
+    alloc_counter::Scope scope;
+    view.startEdit(id, store->getNoteView(id));
+    EXPECT_EQ(scope.allocations(), 0u);
+
+    // back to strings: the two word lists and the words that don't fit a small string
+    size_t allocs = 2;
+    for (const auto& tag : strings.tags) allocs += stringAllocs(tag);
+    for (const auto& kid : strings.kids) allocs += stringAllocs(kid);
+    // the tokenizer's hash set for lists over 'inlineTokens' words is kept from the first edit
+    NoteDataStrings first;
+    view.copyFromEdit(first);
+    NoteDataStrings edited;
+    scope.reset();
+    view.copyFromEdit(edited);
+    EXPECT_LE(scope.allocations(), allocs + stringAllocs(strings.title) + stringAllocs(strings.content));
+}
+
+TEST(AllocBudgetLogger, WarmProducerDoesNotAllocate) {
+    Logger& logger = Logger::getInstance();
+    LogLevel level = logger.getLogLevel();
+    logger.enableConsoleLogging(false);
+    logger.setLogLevel(LogLevel::INFO);
+    logger.setThreadBufferCapacity(16);
+    auto logSome = [] {
+        for (int i = 0; i < 64; ++i) LOG_INFO() << "message " << i << " with text past the small string buffer";
+    };
+    size_t allocations = 0;
+    // a thread of its own, for a fresh ring of 16 slots
+    std::thread([&] {
+        // every buffer going around the ring and the logger's batches gets its capacity
+        for (int round = 0; round < 8; ++round) {
+            logSome();
+            logger.waitForQueueToEmpty();
+        }
+        alloc_counter::Scope scope;
+        logSome();
+        allocations = scope.allocations();
+    }).join();
+    logger.waitForQueueToEmpty();
+    logger.setThreadBufferCapacity(4096);
+    logger.setLogLevel(level);
+    logger.enableConsoleLogging(true);
+    EXPECT_EQ(allocations, 0u);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+#include "diagnostics.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr size_t index(FramePhase phase) { return static_cast<size_t>(phase); }
+
+} // namespace
+
+TEST(FrameTimings, StartsEmpty) {
+    FrameTimings timings;
+    EXPECT_EQ(timings.size(), 0u);
+}
+
+TEST(FrameTimings, LapsOfOnePhaseAddUp) {
+    FrameTimings timings;
+    auto t = FrameTimings::Clock::now();
+    timings.beginFrame(t);
+    timings.lap(FramePhase::Tools, t + 1ms);
+    timings.lap(FramePhase::Notes, t + 3ms);
+    timings.lap(FramePhase::Tools, t + 4ms);    // the tools are lapped twice per frame
+    const FrameTimings::Frame& frame = timings.frame(0);
+    EXPECT_FLOAT_EQ(frame[index(FramePhase::Tools)], 2000.0f);
+    EXPECT_FLOAT_EQ(frame[index(FramePhase::Notes)], 2000.0f);
+    EXPECT_FLOAT_EQ(frame[index(FramePhase::Input)], 0.0f);
+    EXPECT_FLOAT_EQ(FrameTimings::total(frame), 4000.0f);
+}
+
+TEST(FrameTimings, BeginFrameDropsTheTimeSinceTheLastLap) {
+    FrameTimings timings;
+    auto t = FrameTimings::Clock::now();
+    timings.beginFrame(t);
+    timings.lap(FramePhase::Input, t + 1ms);
+    timings.beginFrame(t + 10ms);
+    timings.lap(FramePhase::Input, t + 11ms);
+    EXPECT_EQ(timings.size(), 2u);
+    EXPECT_FLOAT_EQ(timings.frame(0)[index(FramePhase::Input)], 1000.0f);
+    EXPECT_FLOAT_EQ(FrameTimings::total(timings.frame(0)), 1000.0f);
+    EXPECT_FLOAT_EQ(timings.frame(1)[index(FramePhase::Input)], 1000.0f);
+}
+
+TEST(FrameTimings, RingKeepsTheLastFrames) {
+    FrameTimings timings;
+    auto t = FrameTimings::Clock::now();
+    // frame 'i' spends 'i' microseconds in Render
+    constexpr size_t recorded = FrameTimings::frames + 60;
+    for (size_t i = 0; i < recorded; ++i) {
+        timings.beginFrame(t);
+        timings.lap(FramePhase::Render, t + std::chrono::microseconds(i));
+        EXPECT_EQ(timings.size(), std::min(i + 1, FrameTimings::frames));
+    }
+    EXPECT_EQ(timings.size(), FrameTimings::frames);
+    for (size_t age = 0; age < FrameTimings::frames; ++age) {
+        EXPECT_FLOAT_EQ(timings.frame(age)[index(FramePhase::Render)], static_cast<float>(recorded - 1 - age))
+            << "age " << age;
+    }
+}
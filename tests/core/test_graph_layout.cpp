@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "graph_layout.hpp"
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::vector<GraphPoint> randomPoints(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coord(-500.0f, 500.0f);
+    std::vector<GraphPoint> points(count);
+    for (auto& p : points) p = {coord(rng), coord(rng)};
+    return points;
+}
+
+std::vector<uint32_t> queried(const QuadTree& tree, const std::vector<GraphPoint>& points,
+                              float x0, float y0, float x1, float y1) {
+    std::vector<uint32_t> found;
+    tree.query(points, x0, y0, x1, y1, [&](uint32_t i) { found.push_back(i); });
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+std::vector<uint32_t> scanned(const std::vector<GraphPoint>& points, float x0, float y0, float x1, float y1) {
+    std::vector<uint32_t> found;
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        const GraphPoint& p = points[i];
+        if (p.x >= x0 && p.x <= x1 && p.y >= y0 && p.y <= y1) found.push_back(i);
+    }
+    return found;
+}
+
+} // namespace
+
+TEST(QuadTree, OrderHoldsEveryBodyOnce) {
+    std::vector<GraphPoint> points = randomPoints(1000, 1);
+    // coincident points end up together in a max depth cell
+    for (int i = 0; i < 10; ++i) points.push_back({1.0f, 1.0f});
+    QuadTree tree;
+    tree.build(points);
+    std::vector<uint32_t> order = tree.order();
+    std::sort(order.begin(), order.end());
+    ASSERT_EQ(order.size(), points.size());
+    for (uint32_t i = 0; i < order.size(); ++i) EXPECT_EQ(order[i], i);
+}
+
+TEST(QuadTree, QueryMatchesAScan) {
+    std::vector<GraphPoint> points = randomPoints(2000, 2);
+    for (int i = 0; i < 10; ++i) points.push_back({-3.0f, 7.0f});
+    QuadTree tree;
+    tree.build(points);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coord(-600.0f, 600.0f);
+    for (int round = 0; round < 200; ++round) {
+        float x0 = coord(rng), x1 = coord(rng), y0 = coord(rng), y1 = coord(rng);
+        if (x0 > x1) std::swap(x0, x1);
+        if (y0 > y1) std::swap(y0, y1);
+        EXPECT_EQ(queried(tree, points, x0, y0, x1, y1), scanned(points, x0, y0, x1, y1));
+    }
+    EXPECT_EQ(queried(tree, points, -1000, -1000, 1000, 1000).size(), points.size());
+    EXPECT_EQ(queried(tree, points, -4, 6, -2, 8).size(), 10u);
+    EXPECT_TRUE(queried(tree, points, 900, 900, 1000, 1000).empty());
+}
+
+TEST(QuadTree, EmptyTree) {
+    QuadTree tree;
+    std::vector<GraphPoint> points;
+    tree.build(points);
+    EXPECT_TRUE(tree.order().empty());
+    EXPECT_TRUE(queried(tree, points, -1, -1, 1, 1).empty());
+    GraphPoint f = tree.repulsion(points, 0, 1.0f, 1.0f);
+    EXPECT_EQ(f.x, 0.0f);
+    EXPECT_EQ(f.y, 0.0f);
+}
+
+TEST(QuadTree, ExactRepulsionWithoutApproximation) {
+    std::vector<GraphPoint> points = randomPoints(200, 4);
+    QuadTree tree;
+    tree.build(points);
+    for (uint32_t body : {0u, 57u, 199u}) {
+        // theta 0 opens every cell: the sum over every other body
+        GraphPoint f = tree.repulsion(points, body, 100.0f, 0.0f);
+        double fx = 0, fy = 0;
+        for (uint32_t i = 0; i < points.size(); ++i) {
+            if (i == body) continue;
+            double dx = points[body].x - points[i].x, dy = points[body].y - points[i].y;
+            double d2 = dx * dx + dy * dy;
+            fx += dx * 100.0 / d2;
+            fy += dy * 100.0 / d2;
+        }
+        EXPECT_NEAR(f.x, fx, 1e-3 * (1.0 + std::abs(fx)));
+        EXPECT_NEAR(f.y, fy, 1e-3 * (1.0 + std::abs(fy)));
+    }
+}
+
+class GraphLayoutTest : public ::testing::Test {
+protected:
+    fs::path path;
+
+    void SetUp() override {
+        path = fs::temp_directory_path() / ("graph_layout_test_" + std::to_string(::getpid()) + ".json");
+        std::ofstream(path) << R"([
+            {"title": "a", "content": "", "tags": ["hub"]},
+            {"title": "b", "content": "", "tags": ["hub"]},
+            {"title": "c", "content": "", "tags": ["hub", "a"]}
+        ])";
+    }
+    void TearDown() override { fs::remove(path); }
+
+    // the newest frame once 'done' holds for it, false after 'limit'
+    template<typename Done>
+    static bool waitFor(GraphLayout& layout, Done done, std::chrono::milliseconds limit = 5000ms) {
+        auto deadline = std::chrono::steady_clock::now() + limit;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (done(layout.acquire())) return true;
+            std::this_thread::sleep_for(1ms);
+        }
+        return false;
+    }
+};
+
+TEST_F(GraphLayoutTest, PublishesTheStoreGraph) {
+    NoteStore store(path.string());
+    std::shared_mutex mtx;
+    GraphLayout layout(store, mtx, 1);
+    layout.setActive(true);
+    ASSERT_TRUE(waitFor(layout, [](const GraphFrame& f) { return f.iteration >= 10; }));
+
+    const GraphFrame& frame = layout.acquire();
+    EXPECT_EQ(frame.ids.size(), store.size());
+    EXPECT_EQ(frame.positions.size(), frame.ids.size());
+    EXPECT_EQ(frame.edges.size(), 4u);
+    ASSERT_EQ(frame.adjacencyOffsets.size(), frame.ids.size() + 1);
+    EXPECT_EQ(frame.adjacency.size(), 2 * frame.edges.size());
+    for (const GraphPoint& p : frame.positions) {
+        EXPECT_TRUE(std::isfinite(p.x) && std::isfinite(p.y));
+    }
+    // the frame's tree covers its own positions
+    size_t found = 0;
+    frame.tree.query(frame.positions, -1e9f, -1e9f, 1e9f, 1e9f, [&](uint32_t) { ++found; });
+    EXPECT_EQ(found, frame.ids.size());
+}
+
+TEST_F(GraphLayoutTest, MarkDirtyPicksUpNewNotes) {
+    NoteStore store(path.string());
+    std::shared_mutex mtx;
+    GraphLayout layout(store, mtx, 1);
+    layout.setActive(true);
+    ASSERT_TRUE(waitFor(layout, [&](const GraphFrame& f) { return f.ids.size() == store.size(); }));
+    uint64_t topology = layout.acquire().topology;
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        store.addNote("d", "", {"b"}, {});
+    }
+    layout.markDirty();
+    ASSERT_TRUE(waitFor(layout, [&](const GraphFrame& f) { return f.topology != topology; }));
+    const GraphFrame& frame = layout.acquire();
+    EXPECT_EQ(frame.ids.size(), 5u);
+    EXPECT_EQ(frame.edges.size(), 5u);
+}
+
+TEST_F(GraphLayoutTest, IdleWhileInactive) {
+    NoteStore store(path.string());
+    std::shared_mutex mtx;
+    GraphLayout layout(store, mtx, 1);
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(layout.acquire().iteration, 0u);
+    EXPECT_TRUE(layout.acquire().ids.empty());
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "markdown_cache.hpp"
+
+namespace fs = std::filesystem;
+
+class MarkdownCacheTest : public ::testing::Test {
+protected:
+    fs::path path;
+    std::unique_ptr<NoteStore> store;
+    MarkdownCache cache;
+    NoteId id{};
+
+    void SetUp() override {
+        path = fs::temp_directory_path() / ("markdown_cache_test_" + std::to_string(::getpid()) + ".json");
+        std::ofstream(path) << R"([
+            {"title": "a", "content": "# heading\n\nsee [[later]] and [[a]]", "tags": []}
+        ])";
+        store = std::make_unique<NoteStore>(path.string());
+        id = store->findId("a");
+    }
+    void TearDown() override { fs::remove(path); }
+
+    markdown::Document& get() { return cache.get(id, store->getNote(id), *store); }
+
+    // the [[link]] spans of the second block
+    const markdown::Span& link(const markdown::Document& doc, size_t n) {
+        size_t seen = 0;
+        for (const auto& span : doc.blocks.at(1).spans) {
+            if (span.type == markdown::SpanType::Link && seen++ == n) return span;
+        }
+        throw std::out_of_range("no such link");
+    }
+};
+
+TEST_F(MarkdownCacheTest, ParsesOnlyWhenTheNoteChanged) {
+    markdown::Document& doc = get();
+    ASSERT_EQ(doc.blocks.size(), 2u);
+    // a block no parse would make, it stays as long as the note is not re-parsed
+    doc.blocks.emplace_back();
+    EXPECT_EQ(get().blocks.size(), 3u);
+
+    // another note's change moves the store version, not this note's
+    store->addNote("b", "", {}, {});
+    EXPECT_EQ(get().blocks.size(), 3u);
+
+    store->updateNote(id, "a", "# heading\n\nsee [[later]] and [[a]]\n\nmore", {}, {});
+    markdown::Document& parsed = get();
+    EXPECT_EQ(parsed.blocks.size(), 3u);
+    EXPECT_EQ(parsed.blocks.back().type, markdown::BlockType::Paragraph);
+    EXPECT_EQ(parsed.reusedBlocks, 2u);    // the unchanged blocks were moved over
+}
+
+TEST_F(MarkdownCacheTest, ResolvesLinksWhenTheStoreChanges) {
+    EXPECT_EQ(link(get(), 0).target, 0u);   // "later" doesn't exist yet
+    EXPECT_EQ(link(get(), 1).target, id);
+
+    store->addNote("later", "", {}, {});
+    EXPECT_EQ(link(get(), 0).target, store->findId("later"));
+    EXPECT_EQ(link(get(), 1).target, id);
+}
+
+TEST_F(MarkdownCacheTest, EraseDropsTheEntry) {
+    get().blocks.emplace_back();
+    EXPECT_EQ(get().blocks.size(), 3u);
+    cache.erase(id);
+    // parsed again from the note, the extra block is gone
+    EXPECT_EQ(get().blocks.size(), 2u);
+    EXPECT_EQ(get().reusedBlocks, 0u);
+}
@@ -0,0 +1,327 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "note.hpp"
+#include "viewstate.hpp"
+
+namespace fs = std::filesystem;
+using note::NoteStore;
+using note::MemoryStats;
+using note::NoteDataStrings;
+using note::NoteDataView;
+using note::NoteId;
+
+class NoteStoreTest : public ::testing::Test {
+protected:
+    fs::path path;
+
+    void SetUp() override {
+        path = fs::temp_directory_path() / ("note_store_test_" + std::to_string(::getpid()) + ".json");
+        std::ofstream(path) << R"([
+            {"title": "a", "content": "first", "tags": ["default"]},
+            {"title": "b", "content": "second", "tags": ["default", "a"]},
+            {"title": "c", "content": "a content too long for a small string buffer", "tags": []}
+        ])";
+    }
+    void TearDown() override {
+        fs::remove(path);
+        fs::remove(path.string() + ".saved");
+    }
+};
+
+namespace {
+
+void expectSame(const MemoryStats& a, const MemoryStats& b) {
+    EXPECT_EQ(a.notes, b.notes);
+    EXPECT_EQ(a.placeholders, b.placeholders);
+    EXPECT_EQ(a.edges, b.edges);
+    EXPECT_EQ(a.titleBytes, b.titleBytes);
+    EXPECT_EQ(a.contentBytes, b.contentBytes);
+    EXPECT_EQ(a.indexBytes, b.indexBytes);
+    EXPECT_EQ(a.listBytes, b.listBytes);
+    EXPECT_EQ(a.tableBytes, b.tableBytes);
+    EXPECT_EQ(a.slackBytes, b.slackBytes);
+}
+
+} // namespace
+
+TEST_F(NoteStoreTest, MemoryStatsCountNotesAndEdges) {
+    NoteStore store(path.string());
+    MemoryStats m = store.memoryStats();
+    EXPECT_EQ(m.notes, 4u);     // "default" is made from the tags
+    EXPECT_EQ(m.placeholders, 1u);
+    EXPECT_EQ(m.edges, 3u);
+    EXPECT_GT(m.contentBytes, 0u);  // "c"'s content doesn't fit a small string
+    EXPECT_EQ(m.titleBytes + m.indexBytes, 0u);    // the short titles fit the small string buffer
+    EXPECT_EQ(m.listBytes, 2 * m.edges * sizeof(NoteId));
+    EXPECT_GT(m.tableBytes, 0u);
+    EXPECT_EQ(m.totalBytes(), m.titleBytes + m.contentBytes + m.indexBytes + m.listBytes +
+                              m.tableBytes + m.slackBytes);
+
+    store.addNote("d", "", {"a"}, {});
+    EXPECT_EQ(store.memoryStats().notes, 5u);
+    EXPECT_EQ(store.memoryStats().edges, 4u);
+}
+
+TEST_F(NoteStoreTest, MemoryStatsFollowEveryChange) {
+    NoteStore store(path.string());
+    expectSame(store.memoryStats(), store.recountMemoryStats());
+
+    // new notes, and placeholders for the missing tags
+    store.addNote("a note with a title longer than the small string buffer",
+                  std::string(1000, 'x'), {"a", "missing tag", "another missing tag"}, {"missing kid"});
+    EXPECT_EQ(store.memoryStats().placeholders, 4u);
+    expectSame(store.memoryStats(), store.recountMemoryStats());
+
+    // content grows and shrinks, a rename moves the note in its tags' kid lists
+    NoteId id = store.findId("b");
+    store.updateNote(id, "b", std::string(5000, 'y'), {"default", "a"}, {});
+    store.updateNote(id, "b", "short", {"default"}, {});
+    store.updateNote(id, "b renamed to something long enough to allocate", "short", {"default", "c"}, {"a"});
+    expectSame(store.memoryStats(), store.recountMemoryStats());
+
+    // the placeholder gets content
+    NoteId tag = store.findId("missing tag");
+    store.updateNote(tag, "missing tag", "now a note", {}, {});
+    EXPECT_EQ(store.memoryStats().placeholders, 3u);
+    expectSame(store.memoryStats(), store.recountMemoryStats());
+
+    for (int i = 0; i < 100; ++i) store.addNote("note " + std::to_string(i), "content", {"default"}, {});
+    expectSame(store.memoryStats(), store.recountMemoryStats());
+}
+
+TEST_F(NoteStoreTest, PlaceholdersAreTheNotesNeverWritten) {
+    std::ofstream(path) << R"([
+        {"title": "empty", "content": "", "tags": []},
+        {"title": "b", "content": "", "tags": ["missing"]}
+    ])";
+    NoteStore store(path.string());
+    EXPECT_EQ(store.memoryStats().placeholders, 1u);   // "missing", not the empty notes
+    EXPECT_TRUE(store.getNote(store.findId("missing")).placeholder);
+    EXPECT_FALSE(store.getNote(store.findId("empty")).placeholder);
+
+    // written empty, it is a note now
+    store.updateNote(store.findId("missing"), "missing", "", {}, {"b", "a kid"});
+    EXPECT_FALSE(store.getNote(store.findId("missing")).placeholder);
+    EXPECT_EQ(store.memoryStats().placeholders, 1u);   // "a kid"
+
+    store.addNote("a kid", "", {}, {});
+    EXPECT_EQ(store.memoryStats().placeholders, 0u);
+    expectSame(store.memoryStats(), store.recountMemoryStats());
+}
+
+TEST_F(NoteStoreTest, ViewMemoryStatsFollowSortedLists) {
+    NoteStore store(path.string());
+    ViewState view;
+    view.addFromKids(store.getKids("default"));
+    EXPECT_EQ(view.memoryStats().visible, 2u);
+    EXPECT_EQ(view.memoryStats().sortedBytes, 0u);
+
+    NoteId id = store.findId("default");
+    const auto& kids = store.getNote(id).kids;
+    NoteListState& lists = view.getLists(id);
+    view.sorted(lists.kids, kids, store.getNote(id).modified, ListSort::Title, store);
+    ViewMemoryStats stats = view.memoryStats();
+    EXPECT_EQ(stats.listStates, 1u);
+    EXPECT_EQ(stats.sortedBytes, kids.size() * sizeof(NoteId));
+    EXPECT_GT(stats.tableBytes, 0u);
+
+    // a rebuild replaces the list, it doesn't add to it
+    store.addNote("d", "", {"default"}, {});
+    view.sorted(lists.kids, kids, store.getNote(id).modified, ListSort::Recent, store);
+    EXPECT_EQ(view.memoryStats().sortedBytes, kids.size() * sizeof(NoteId));
+    EXPECT_EQ(view.memoryStats().totalBytes() - stats.totalBytes(),
+              view.memoryStats().slackBytes - stats.slackBytes + sizeof(NoteId));
+}
+
+TEST_F(NoteStoreTest, SortedListsFollowOtherNotesChanges) {
+    NoteStore store(path.string());
+    ViewState view;
+    NoteId id = store.findId("default");
+    const auto& kids = store.getNote(id).kids;
+    NoteListState& lists = view.getLists(id);
+    auto titles = [&](const std::vector<NoteId>& ids) {
+        std::vector<std::string> out;
+        for (NoteId kid : ids) out.push_back(store.getNote(kid).title);
+        return out;
+    };
+    view.sorted(lists.kids, kids, store.getNote(id).modified, ListSort::Title, store);
+
+    // a new kid and a renamed one are merged in, the hub itself didn't change
+    store.addNote("0", "", {"default"}, {});
+    NoteId b = store.findId("b");
+    store.updateNote(b, "00", "second", {"default", "a"}, {});
+    uint64_t hubVersion = store.getNote(id).modified;
+    EXPECT_EQ(titles(view.sorted(lists.kids, kids, hubVersion, ListSort::Title, store)),
+              (std::vector<std::string>{"0", "00", "a"}));
+    EXPECT_EQ(titles(view.sorted(lists.kids, kids, hubVersion, ListSort::Recent, store)),
+              (std::vector<std::string>{"00", "0", "a"}));
+    store.updateNote(store.findId("a"), "a", "edited", {"default"}, {});
+    EXPECT_EQ(titles(view.sorted(lists.kids, kids, hubVersion, ListSort::Recent, store)),
+              (std::vector<std::string>{"a", "00", "0"}));
+    EXPECT_EQ(view.memoryStats().sortedBytes, kids.size() * sizeof(NoteId));
+}
+
+TEST_F(NoteStoreTest, ClosingANoteDropsItsListState) {
+    NoteStore store(path.string());
+    ViewState view;
+    NoteId id = store.findId("default");
+    view.addId(id);
+    NoteListState& lists = view.getLists(id);
+    view.sorted(lists.kids, store.getNote(id).kids, store.getNote(id).modified, ListSort::Title, store);
+    EXPECT_EQ(view.memoryStats().listStates, 1u);
+    EXPECT_GT(view.memoryStats().sortedBytes, 0u);
+
+    view.removeId(id);
+    EXPECT_FALSE(view.isVisible(id));
+    EXPECT_EQ(view.memoryStats().listStates, 0u);
+    EXPECT_EQ(view.memoryStats().sortedBytes, 0u);
+}
+
+TEST_F(NoteStoreTest, ViewMemoryStatsMatchARecount) {
+    NoteStore store(path.string());
+    ViewState view;
+    auto expectRecount = [&] {
+        ViewMemoryStats kept = view.memoryStats(), counted = view.recountMemoryStats();
+        EXPECT_EQ(kept.listStates, counted.listStates);
+        EXPECT_EQ(kept.sortedBytes, counted.sortedBytes);
+        EXPECT_EQ(kept.slackBytes, counted.slackBytes);
+        EXPECT_EQ(kept.totalBytes(), counted.totalBytes());
+    };
+    // sorted, merged, sorted again and closed, on two notes
+    for (const char* title : {"default", "a"}) {
+        NoteId id = store.findId(title);
+        view.addId(id);
+        NoteListState& lists = view.getLists(id);
+        const NoteData& note = store.getNote(id);
+        view.sorted(lists.kids, note.kids, note.modified, ListSort::Title, store);
+        view.sorted(lists.tags, note.tags, note.modified, ListSort::Recent, store);
+    }
+    expectRecount();
+    for (int i = 0; i < 20; ++i) store.addNote("kid " + std::to_string(i), "", {"default", "a"}, {});
+    for (const char* title : {"default", "a"}) {
+        NoteId id = store.findId(title);
+        const NoteData& note = store.getNote(id);
+        view.sorted(view.getLists(id).kids, note.kids, 0, ListSort::Recent, store);
+    }
+    expectRecount();
+    view.removeId(store.findId("default"));
+    expectRecount();
+    view.removeId(store.findId("a"));
+    expectRecount();
+    EXPECT_EQ(view.memoryStats().sortedBytes, 0u);
+}
+
+TEST_F(NoteStoreTest, AddNoteBumpsTheVersionOnce) {
+    NoteStore store(path.string());
+    uint64_t version = store.version();
+    store.addNote("d", "", {"default"}, {});
+    EXPECT_EQ(store.version(), version + 1);
+    EXPECT_EQ(store.getNote(store.findId("d")).modified, store.version());
+}
+
+TEST_F(NoteStoreTest, NoteViewMatchesNoteStrings) {
+    NoteStore store(path.string());
+    NoteId id = store.findId("b");
+    NoteDataView view = store.getNoteView(id);
+    NoteDataStrings strings = store.getNoteStrings(id);
+    EXPECT_EQ(view.id, id);
+    EXPECT_EQ(view.title, strings.title);
+    EXPECT_EQ(view.content, strings.content);
+    EXPECT_EQ(std::vector<std::string>(view.tags.begin(), view.tags.end()), strings.tags);
+    EXPECT_EQ(view.tags.ids(), store.getNote(id).tags);
+    ASSERT_EQ(view.kids.size(), 0u);
+    EXPECT_EQ(view.tags[1], "a");
+
+    // the default tag's kids, resolved as they are read
+    NoteDataView tag = store.getNoteView(store.findId("default"));
+    EXPECT_EQ(std::vector<std::string>(tag.kids.begin(), tag.kids.end()),
+              (std::vector<std::string>{"a", "b"}));
+
+    std::ostringstream fromView, fromStrings;
+    fromView << view;
+    fromStrings << strings;
+    EXPECT_EQ(fromView.str(), fromStrings.str());
+}
+
+TEST_F(NoteStoreTest, NoteViewIsCurrentUntilTheNextChange) {
+    NoteStore store(path.string());
+    NoteId id = store.findId("a");
+    NoteDataView view = store.getNoteView(id);
+    EXPECT_TRUE(store.isCurrent(view));
+    store.updateNote(id, "a", "first", {"default"}, {"b"});  // a no-op, nothing changes
+    EXPECT_TRUE(store.isCurrent(view));
+    store.updateNote(id, "a", "changed", {"default"}, {"b"});
+    EXPECT_FALSE(store.isCurrent(view));
+    EXPECT_EQ(store.getNoteView(id).content, "changed");
+
+    NoteDataView missing = store.getNoteView(12345);
+    EXPECT_EQ(missing.id, 0u);
+    EXPECT_TRUE(missing.title.empty());
+    EXPECT_TRUE(missing.tags.empty());
+    EXPECT_EQ(missing.tags.begin(), missing.tags.end());
+}
+
+TEST_F(NoteStoreTest, UnchangedEditIsANoOp) {
+    NoteStore store(path.string());
+    NoteId id = store.findId("b");
+    // a multi word kid, a kid made of a delimiter, out of order tags
+    store.updateNote(id, "b", "second", {"default", "a"}, {"c", "two words", ","});
+    NoteDataView before = store.getNoteView(id);
+
+    ViewState view;
+    view.addId(id);
+    view.startEdit(id, before);
+    EXPECT_EQ(view.getEditNote().kids, R"( c "two words" ",")");
+    NoteDataStrings edited;
+    view.copyFromEdit(edited);
+    EXPECT_EQ(edited.tags, (std::vector<std::string>{"default", "a"}));
+    EXPECT_EQ(edited.kids, (std::vector<std::string>{"c", "two words", ","}));
+    store.updateNote(id, edited.title, edited.content, edited.tags, edited.kids);
+    EXPECT_TRUE(store.isCurrent(before));
+}
+
+TEST_F(NoteStoreTest, LoadAndSaveAreTimed) {
+    NoteStore store(path.string());
+    EXPECT_GT(store.lastLoadDuration().count(), 0);
+    EXPECT_EQ(store.lastSaveDuration().count(), 0);
+    store.save_json_file(path.string() + ".saved");
+    EXPECT_GT(store.lastSaveDuration().count(), 0);
+}
+
+// every word of up to 5 of these characters comes back alone and whole, quoted or not
+TEST(ViewState, AppendWordRoundTripsThroughTheTokenizer) {
+    constexpr std::string_view alphabet = "a \",\t";
+    tokenizer::Tokenizer tokenizer;
+    std::vector<std::string> out;
+    std::vector<std::string> words{""};
+    size_t quoted = 0;
+    for (size_t length = 1; length <= 5; ++length) {
+        std::vector<std::string> longer;
+        for (const std::string& word : words) {
+            for (char c : alphabet) longer.push_back(word + c);
+        }
+        words = std::move(longer);
+        for (const std::string& word : words) {
+            std::string line;
+            ViewState::appendWord(line, word, " ");
+            quoted += tokenizer::Tokenizer::needsQuotes(word);
+            tokenizer.tokenize(line, out);
+            EXPECT_EQ(out, std::vector<std::string>{word}) << "[" << word << "] written as [" << line << "]";
+        }
+    }
+    EXPECT_GT(quoted, 3000u);
+
+    // and next to each other on one line, in order
+    std::vector<std::string> titles{"\"quoted", "say \"hi\" now", "plain", "a\"b", "\"", "\"\"", "x,\" y"};
+    std::string line;
+    for (const std::string& title : titles) ViewState::appendWord(line, title, ", ");
+    tokenizer.tokenize(line, out);
+    EXPECT_EQ(out, titles);
+}
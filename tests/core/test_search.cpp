@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "search.hpp"
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+class SearchWorkerTest : public ::testing::Test {
+protected:
+    fs::path path;
+    std::unique_ptr<NoteStore> store;
+    std::shared_mutex storeMtx;
+    EventQueue events;
+
+    void TearDown() override { fs::remove(path); }
+
+    void load(const std::string& json) {
+        path = fs::temp_directory_path() / ("search_test_" + std::to_string(::getpid()) + ".json");
+        std::ofstream(path) << json;
+        store = std::make_unique<NoteStore>(path.string());
+    }
+
+    // Waits for the SearchResults event of a complete snapshot, false after 5 s.
+    bool waitComplete(SearchWorker& worker, SearchSnapshot& out) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (std::chrono::steady_clock::now() < deadline) {
+            Event event;
+            while (events.try_pop(event)) {
+                if (event.type == EventType::SearchResults && worker.latest(out) && out.complete) return true;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+        return false;
+    }
+
+    std::vector<std::string> titles(const SearchSnapshot& snapshot) const {
+        std::vector<std::string> out;
+        for (const SearchHit& hit : snapshot.hits) out.push_back(store->getNote(hit.id).title);
+        return out;
+    }
+};
+
+TEST_F(SearchWorkerTest, RanksTitleMatchesAboveContentAndFoldsCase) {
+    load(R"([
+        {"title": "cherry", "content": "no match here", "tags": []},
+        {"title": "banana", "content": "An Apple a day", "tags": []},
+        {"title": "green apple", "content": "", "tags": []},
+        {"title": "Apple pie", "content": "", "tags": []},
+        {"title": "apple", "content": "", "tags": []}
+    ])");
+    SearchWorker worker(*store, storeMtx, events);
+    worker.submit("APPLE");
+    SearchSnapshot snapshot;
+    ASSERT_TRUE(waitComplete(worker, snapshot));
+    // exact title, title prefix, title substring, content
+    EXPECT_EQ(titles(snapshot), (std::vector<std::string>{"apple", "Apple pie", "green apple", "banana"}));
+    EXPECT_EQ(snapshot.scanned, 5u);
+}
+
+TEST_F(SearchWorkerTest, KeepsTheBestMaxHits) {
+    std::string json = "[";
+    for (size_t i = 0; i < SearchWorker::maxHits + 100; ++i) {
+        if (i > 0) json += ",";
+        json += R"({"title": "note )" + std::to_string(i) + R"(", "content": "", "tags": []})";
+    }
+    json += "]";
+    load(json);
+    SearchWorker worker(*store, storeMtx, events);
+    worker.submit("note");
+    SearchSnapshot snapshot;
+    ASSERT_TRUE(waitComplete(worker, snapshot));
+    ASSERT_EQ(snapshot.hits.size(), SearchWorker::maxHits);
+    EXPECT_EQ(snapshot.scanned, SearchWorker::maxHits + 100);
+    // same score: the shorter titles, then the older notes
+    EXPECT_EQ(store->getNote(snapshot.hits.front().id).title, "note 0");
+    EXPECT_EQ(store->getNote(snapshot.hits.back().id).title, "note 199");
+    EXPECT_TRUE(std::is_sorted(snapshot.hits.begin(), snapshot.hits.end()));
+}
+
+TEST_F(SearchWorkerTest, NewQueryCancelsTheOldOne) {
+    load(R"([
+        {"title": "alpha", "content": "", "tags": []},
+        {"title": "beta", "content": "", "tags": []}
+    ])");
+    SearchWorker worker(*store, storeMtx, events);
+    worker.submit("alpha");
+    SearchSnapshot snapshot;
+    ASSERT_TRUE(waitComplete(worker, snapshot));
+    uint64_t first = snapshot.generation;
+
+    {
+        // the worker can't scan while the store is locked: both queries wait
+        std::unique_lock<std::shared_mutex> writer(storeMtx);
+        worker.submit("zzz");
+        EXPECT_FALSE(worker.latest(snapshot));    // "alpha"'s results are stale now
+        worker.submit("beta");
+    }
+    ASSERT_TRUE(waitComplete(worker, snapshot));
+    EXPECT_GT(snapshot.generation, first + 1);
+    EXPECT_EQ(titles(snapshot), (std::vector<std::string>{"beta"}));
+}
+
+TEST_F(SearchWorkerTest, EmptyQueryCompletesWithoutHits) {
+    load(R"([{"title": "alpha", "content": "", "tags": []}])");
+    SearchWorker worker(*store, storeMtx, events);
+    worker.submit("");
+    SearchSnapshot snapshot;
+    ASSERT_TRUE(waitComplete(worker, snapshot));
+    EXPECT_TRUE(snapshot.hits.empty());
+}
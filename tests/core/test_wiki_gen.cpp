@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "buffered_writer.h"
+#include "note.hpp"
+#include "wiki_gen.hpp"
+
+namespace fs = std::filesystem;
+using note::NoteStore;
+using note::WikiGenerator;
+using note::WikiGenOptions;
+
+namespace {
+
+std::string generate(WikiGenOptions options) {
+    std::string text;
+    StringWriter out(text);
+    WikiGenerator(options).write(out);
+    return text;
+}
+
+} // namespace
+
+TEST(WikiGenerator, SameSeedSameBytes) {
+    WikiGenOptions options{.notes = 500, .seed = 7};
+    std::string first = generate(options);
+    EXPECT_EQ(generate(options), first);
+    options.seed = 8;
+    EXPECT_NE(generate(options), first);
+}
+
+TEST(WikiGenerator, NotesAreNamedWithoutTheOnesBefore) {
+    WikiGenerator gen({.notes = 100, .hubs = 2});
+    EXPECT_EQ(gen.title(0), "default");
+    EXPECT_EQ(gen.title(1), "hub 2");
+    std::string note;
+    gen.appendNote(42, note);
+    EXPECT_EQ(note.find("{\"title\":\"" + gen.title(42) + "\""), 0u);
+}
+
+TEST(WikiGenerator, MaxTagsOverTheLimitThrows) {
+    EXPECT_THROW(WikiGenerator({.maxTags = WikiGenerator::maxTagLimit + 1}), std::invalid_argument);
+    EXPECT_NO_THROW(WikiGenerator({.maxTags = WikiGenerator::maxTagLimit}));
+}
+
+TEST(WikiGenerator, LoadsIntoTheNoteStore) {
+    WikiGenOptions options{.notes = 300, .seed = 3, .maxTags = WikiGenerator::maxTagLimit,
+                           .hubs = 3, .hubShare = 0.5, .cycleShare = 0.2};
+    fs::path path = fs::temp_directory_path() / ("wiki_gen_test_" + std::to_string(::getpid()) + ".json");
+    std::ofstream(path) << generate(options);
+
+    NoteStore store(path.string());
+    fs::remove(path);
+    // every tag names a generated note, none is made up
+    EXPECT_EQ(store.memoryStats().notes, options.notes);
+    EXPECT_EQ(store.memoryStats().placeholders, 0u);
+    WikiGenerator gen(options);
+    size_t most_tags = 0;
+    for (uint64_t id = 0; id < options.notes; ++id) {
+        const auto& note = store.getNote(gen.title(id));
+        most_tags = std::max(most_tags, note.tags.size());
+    }
+    EXPECT_GT(most_tags, 8u);
+    EXPECT_LE(most_tags, WikiGenerator::maxTagLimit + 2);
+}
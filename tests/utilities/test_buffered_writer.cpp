@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "buffered_writer.h"
+
+// reads everything from 'fd' until the write end is closed
+static std::string drain(int fd) {
+    std::string out;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) out.append(chunk, static_cast<size_t>(n));
+    return out;
+}
+
+TEST(BufferedWriter, BuffersUntilFlush) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    {
+        BufferedWriter out(fds[1], 64);
+        out.write("id: ");
+        out.number(42);
+        out.put('\n');
+        EXPECT_EQ(out.buffered(), 7u);
+        out.flush();
+        EXPECT_EQ(out.buffered(), 0u);
+        EXPECT_TRUE(out.ok());
+    }
+    ::close(fds[1]);
+    EXPECT_EQ(drain(fds[0]), "id: 42\n");
+    ::close(fds[0]);
+}
+
+TEST(BufferedWriter, LargeWritesBypassTheBuffer) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    std::string big(100000, 'x');
+    std::string result;
+    std::thread reader([&] { result = drain(fds[0]); });
+    {
+        BufferedWriter out(fds[1], 16);
+        out.write("head ");
+        out.write(big);
+        for (int i = 0; i < 10; ++i) out.put('y');
+    }   // flushed by the destructor
+    ::close(fds[1]);
+    reader.join();
+    ::close(fds[0]);
+    EXPECT_EQ(result, "head " + big + std::string(10, 'y'));
+}
+
+TEST(BufferedWriter, FailedWriteIsSticky) {
+    BufferedWriter out(-1, 16);
+    out.write("lost");
+    out.flush();
+    EXPECT_FALSE(out.ok());
+}
+
+TEST(StringWriter, AppendsToTarget) {
+    std::string target = "> ";
+    StringWriter out(target);
+    out.write("id: ");
+    out.number(7);
+    out.put('\n');
+    EXPECT_EQ(target, "> id: 7\n");
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "events.hpp"
+
+namespace {
+
+std::vector<Event> drain(EventQueue& q) {
+    std::vector<Event> out;
+    Event event;
+    while (q.try_pop(event)) out.push_back(event);
+    return out;
+}
+
+std::atomic<int> g_wakeups{0};
+
+void countWakeup() { g_wakeups.fetch_add(1); }
+
+} // namespace
+
+TEST(EventQueue, MovesOnTheSameIdAddUp) {
+    EventQueue q;
+    for (int i = 0; i < 3; ++i) q.push({EventType::MoveUp, 1});
+    q.push({EventType::MoveUp, 2});
+    q.push({EventType::MoveDown, 1});
+    q.push({EventType::MoveDown, 1, std::nullopt, 4});
+    std::vector<Event> events = drain(q);
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].type, EventType::MoveUp);
+    EXPECT_EQ(events[0].id, 1u);
+    EXPECT_EQ(events[0].repeat, 3u);
+    EXPECT_EQ(events[1].id, 2u);
+    EXPECT_EQ(events[1].repeat, 1u);
+    EXPECT_EQ(events[2].type, EventType::MoveDown);
+    EXPECT_EQ(events[2].repeat, 5u);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(EventQueue, DropsDuplicatesRightBehind) {
+    EventQueue q;
+    q.push({EventType::OpenId, 5});
+    q.push({EventType::OpenId, 5});
+    q.push({EventType::SearchQuery});
+    q.push({EventType::SearchQuery});
+    q.push({EventType::SearchQuery});
+    q.push({EventType::SearchResults});
+    q.push({EventType::SearchResults});
+    std::vector<Event> events = drain(q);
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].type, EventType::OpenId);
+    EXPECT_EQ(events[1].type, EventType::SearchQuery);
+    EXPECT_EQ(events[2].type, EventType::SearchResults);
+}
+
+TEST(EventQueue, KeepsEventsThatDiffer) {
+    EventQueue q;
+    q.push({EventType::OpenId, 5});
+    q.push({EventType::OpenId, 6});
+    q.push({EventType::OpenId, 6, 1});
+    q.push({EventType::OpenId, 6, 2});
+    q.push({EventType::BeginEdit, 6});
+    q.push({EventType::BeginEdit, 6});
+    // not right behind: the first OpenId isn't merged into the later one
+    q.push({EventType::OpenId, 5});
+    std::vector<Event> events = drain(q);
+    ASSERT_EQ(events.size(), 7u);
+    EXPECT_EQ(events[1].insertAfter, std::nullopt);
+    EXPECT_EQ(events[2].insertAfter, 1u);
+    EXPECT_EQ(events[3].insertAfter, 2u);
+}
+
+TEST(EventQueue, SpillsWhenFullAndKeepsOrder) {
+    EventQueue q(4);
+    for (note::NoteId id = 1; id <= 10; ++id) q.push({EventType::CloseId, id});
+    EXPECT_FALSE(q.empty());
+    std::vector<Event> events = drain(q);
+    ASSERT_EQ(events.size(), 10u);
+    for (note::NoteId id = 1; id <= 10; ++id) EXPECT_EQ(events[id - 1].id, id);
+    EXPECT_TRUE(q.empty());
+
+    // the ring is used again once the spilled events are gone
+    q.push({EventType::CloseId, 11});
+    events = drain(q);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].id, 11u);
+    // the spill warnings are written before the next test
+    Logger::getInstance().waitForQueueToEmpty();
+}
+
+TEST(EventQueue, ManyProducersKeepOrderAcrossTheSpill) {
+    constexpr note::NoteId producers = 4;
+    constexpr note::NoteId per_producer = 20000;
+    EventQueue q(16);
+
+    std::vector<std::thread> threads;
+    for (note::NoteId p = 0; p < producers; ++p) {
+        threads.emplace_back([&q, p] {
+            for (note::NoteId i = 0; i < per_producer; ++i) q.push({EventType::CloseId, p * per_producer + i});
+        });
+    }
+
+    std::vector<note::NoteId> next(producers, 0);
+    note::NoteId received = 0;
+    Event event;
+    while (received < producers * per_producer) {
+        if (!q.try_pop(event)) {
+            std::this_thread::yield();
+            continue;
+        }
+        note::NoteId p = event.id / per_producer;
+        EXPECT_EQ(event.id % per_producer, next[p]);
+        next[p] = event.id % per_producer + 1;
+        ++received;
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_TRUE(q.empty());
+    Logger::getInstance().waitForQueueToEmpty();
+}
+
+TEST(EventQueue, WakeupRunsAfterEveryPush) {
+    EventQueue q(4);
+    g_wakeups = 0;
+    q.setWakeup(&countWakeup);
+    for (note::NoteId id = 1; id <= 6; ++id) q.push({EventType::CloseId, id});   // spilled ones too
+    EXPECT_EQ(g_wakeups.load(), 6);
+    q.setWakeup(nullptr);
+    q.push({EventType::CloseId, 7});
+    EXPECT_EQ(g_wakeups.load(), 6);
+    drain(q);
+    Logger::getInstance().waitForQueueToEmpty();
+}
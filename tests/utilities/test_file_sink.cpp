@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "file_sink.h"
+
+namespace fs = std::filesystem;
+
+class FileSinkTest : public ::testing::Test {
+protected:
+    fs::path dir;
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / ("file_sink_test_" + std::to_string(::getpid()));
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+    void TearDown() override { fs::remove_all(dir); }
+
+    static std::string read(const fs::path& file) {
+        std::ifstream in(file);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+};
+
+TEST_F(FileSinkTest, BuffersUntilFlushPolicy) {
+    fs::path log = dir / "a.log";
+    FileSink sink;
+    ASSERT_TRUE(sink.open(log.string(), {.flushBytes = 64, .flushInterval = std::chrono::hours(1)}));
+    sink.write("first", false);
+    EXPECT_EQ(read(log), "");               // still buffered
+    sink.write("urgent", true);
+    EXPECT_EQ(read(log), "first\nurgent\n");
+    sink.write(std::string(100, 'x'), false);  // over 'flushBytes'
+    EXPECT_EQ(sink.buffered(), 0u);
+}
+
+TEST_F(FileSinkTest, TimeBasedFlush) {
+    fs::path log = dir / "b.log";
+    FileSink sink;
+    ASSERT_TRUE(sink.open(log.string(), {.flushInterval = std::chrono::milliseconds(10)}));
+    sink.write("line", false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    sink.flushIfDue();
+    EXPECT_EQ(read(log), "line\n");
+}
+
+TEST_F(FileSinkTest, RotatesBySizeAndKeepsFiles) {
+    fs::path log = dir / "c.log";
+    FileSink sink;
+    ASSERT_TRUE(sink.open(log.string(), {.flushBytes = 1, .rotateBytes = 20, .keepFiles = 2}));
+    for (int i = 0; i < 10; ++i) sink.write("0123456789", false);
+    sink.close();
+    EXPECT_TRUE(fs::exists(dir / "c.log.1"));
+    EXPECT_TRUE(fs::exists(dir / "c.log.2"));
+    EXPECT_FALSE(fs::exists(dir / "c.log.3"));
+    EXPECT_EQ(read(dir / "c.log.1"), "0123456789\n0123456789\n");
+}
+
+TEST_F(FileSinkTest, CompressesRotatedFiles) {
+    fs::path log = dir / "d.log";
+    FileSink sink;
+    ASSERT_TRUE(sink.open(log.string(), {.flushBytes = 1, .rotateBytes = 10, .compress = true}));
+    sink.write("0123456789", false);
+    sink.close();   // waits for the compressor
+    EXPECT_TRUE(fs::exists(dir / "d.log.1.gz"));
+    EXPECT_FALSE(fs::exists(dir / "d.log.1"));
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flight_recorder.h"
+
+namespace fs = std::filesystem;
+
+class FlightRecorderTest : public ::testing::Test {
+protected:
+    fs::path path;
+
+    void SetUp() override {
+        path = fs::temp_directory_path() / ("flight_recorder_test_" + std::to_string(::getpid()));
+        fs::remove(path);
+    }
+    void TearDown() override { fs::remove(path); }
+};
+
+TEST_F(FlightRecorderTest, KeepsTheLastRecordsInOrder) {
+    {
+        FlightRecorder recorder;
+        ASSERT_TRUE(recorder.open(path.string(), 8, 64));
+        for (int i = 0; i < 20; ++i) recorder.record(2, i, 0xab, "msg " + std::to_string(i));
+    }   // unmapped, as after a crash the file is all there is
+
+    std::string error;
+    std::vector<FlightRecord> records = FlightRecorder::load(path.string(), 5, error);
+    EXPECT_TRUE(error.empty());
+    ASSERT_EQ(records.size(), 5u);
+    EXPECT_EQ(records.front().seq, 16u);
+    EXPECT_EQ(records.front().args, "msg 15");
+    EXPECT_EQ(records.back().args, "msg 19");
+    EXPECT_EQ(records.back().timestamp, 19);
+    EXPECT_EQ(records.back().thread, 0xabu);
+    EXPECT_EQ(records.back().level, 2);
+}
+
+TEST_F(FlightRecorderTest, LongRecordsAreCut) {
+    FlightRecorder recorder;
+    ASSERT_TRUE(recorder.open(path.string(), 4, 48));
+    recorder.record(0, 0, 0, std::string(100, 'x'));
+    std::string error;
+    auto records = FlightRecorder::load(path.string(), 10, error);
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].args.size(), 48u - FlightRecorder::slotHeaderSize);
+}
+
+TEST_F(FlightRecorderTest, ReopenContinuesTheRing) {
+    {
+        FlightRecorder recorder;
+        ASSERT_TRUE(recorder.open(path.string(), 16));
+        recorder.record(0, 0, 0, "before");
+    }
+    FlightRecorder recorder;
+    ASSERT_TRUE(recorder.open(path.string(), 16));
+    recorder.record(0, 0, 0, "after");
+    std::string error;
+    auto records = FlightRecorder::load(path.string(), 10, error);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].args, "before");
+    EXPECT_EQ(records[1].seq, 2u);
+}
+
+TEST_F(FlightRecorderTest, ConcurrentWritersGetDistinctSlots) {
+    FlightRecorder recorder;
+    ASSERT_TRUE(recorder.open(path.string(), 4096));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&recorder, t] {
+            for (int i = 0; i < 1000; ++i) recorder.record(0, i, static_cast<uint64_t>(t), "x");
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    std::string error;
+    auto records = FlightRecorder::load(path.string(), 10000, error);
+    ASSERT_EQ(records.size(), 4000u);
+    for (size_t i = 0; i < records.size(); ++i) EXPECT_EQ(records[i].seq, i + 1);
+}
+
+TEST_F(FlightRecorderTest, RejectsOtherFiles) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    std::fputs("not a ring, just some text that is long enough for a header...................", file);
+    std::fclose(file);
+    std::string error;
+    EXPECT_TRUE(FlightRecorder::load(path.string(), 10, error).empty());
+    EXPECT_FALSE(error.empty());
+}
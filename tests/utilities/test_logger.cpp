@@ -1,6 +1,10 @@
+#include <atomic>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <latch>
+#include <sstream>
 #include <thread>
 #include <type_traits>
 #include <vector>
@@ -75,3 +79,233 @@ TEST(PriorityQueue, Order) {
 
     EXPECT_EQ(logQueue.top().timestamp, t2);
 }
+
+TEST(ThreadRingBuffer, FifoAndFull) {
+    ThreadRingBuffer<int> ring(4);
+    EXPECT_EQ(ring.capacity(), 4u);
+    EXPECT_TRUE(ring.empty());
+    for (int i = 0; i < 4; ++i) {
+        int v = i;
+        EXPECT_TRUE(ring.try_push(v));
+    }
+    int extra = 4;
+    EXPECT_FALSE(ring.try_push(extra));
+    EXPECT_EQ(extra, 4);    // not moved from
+
+    int out = 0;
+    ASSERT_TRUE(ring.try_pop(out));
+    EXPECT_EQ(out, 0);
+    EXPECT_TRUE(ring.try_push(extra));
+    for (int expected = 1; expected <= 4; ++expected) {
+        ASSERT_TRUE(ring.try_pop(out));
+        EXPECT_EQ(out, expected);
+    }
+    EXPECT_FALSE(ring.try_pop(out));
+}
+
+TEST(ThreadRingBuffer, ProducerAndConsumerBothPop) {
+    constexpr int N = 100000;
+    ThreadRingBuffer<int> ring(64);
+    std::atomic<bool> producing{true};
+    std::atomic<long> consumed{0};
+    long dropped = 0;
+
+    std::thread consumer([&] {
+        int v = 0;
+        int last = -1;
+        while (producing.load() || !ring.empty()) {
+            if (ring.try_pop(v)) {
+                EXPECT_GT(v, last);     // the order survives the producer's pops
+                last = v;
+                consumed.fetch_add(1);
+            }
+        }
+    });
+    for (int i = 0; i < N; ++i) {
+        int v = i;
+        while (!ring.try_push(v)) {
+            int oldest = 0;
+            if (ring.try_pop(oldest)) ++dropped;   // drop-oldest
+        }
+    }
+    producing.store(false);
+    consumer.join();
+    EXPECT_EQ(consumed.load() + dropped, N);
+}
+
+TEST(LoggerRings, ManyThreadsDrainCompletely) {
+    auto& logger = Logger::getInstance();
+    logger.enableConsoleLogging(false);
+    logger.setOverflowPolicy(OverflowPolicy::BLOCK);
+    uint64_t dropped_before = logger.droppedMessages();
+
+    std::vector<std::thread> ts;
+    for (int t = 0; t < 4; ++t) {
+        ts.emplace_back([] {
+            for (int i = 0; i < 5000; ++i) LOG_ERROR() << "ring message " << i;
+        });
+    }
+    for (auto& t : ts) t.join();
+    logger.waitForQueueToEmpty();
+    logger.enableConsoleLogging(true);
+    EXPECT_EQ(logger.droppedMessages(), dropped_before);
+}
+
+TEST(LogArgs, DecodesLikeAnOstream) {
+    std::string args;
+    std::ostringstream expected;
+    auto add = [&](const auto& v) {
+        log_args::encode(args, v);
+        expected << v;
+    };
+    add("text ");
+    add(std::string("string "));
+    add(std::string_view("view "));
+    add(-42);
+    add(' ');
+    add(18446744073709551615ull);
+    add(' ');
+    add(3.25);
+    add(' ');
+    add(1e-7f);
+    add(' ');
+    add(true);
+    add('x');
+    add(static_cast<uint8_t>('y'));
+
+    std::string decoded;
+    log_args::decode(args, decoded);
+    EXPECT_EQ(decoded, expected.str());
+}
+
+TEST(LogArgs, TruncatedInputStops) {
+    std::string args;
+    log_args::encode(args, std::string("hello"));
+    args.pop_back();
+    std::string decoded;
+    log_args::decode(args, decoded);    // must not read past the end
+    EXPECT_TRUE(decoded.empty());
+}
+
+TEST(LogArgs, FieldsFollowTheText) {
+    std::string args;
+    log_args::encode(args, "opened ");
+    log_args::encodeKey(args, "id");
+    log_args::encode(args, 42);
+    log_args::encode(args, "note");
+    log_args::encodeKey(args, "ok");
+    log_args::encode(args, true);
+
+    std::string decoded;
+    log_args::decode(args, decoded);
+    EXPECT_EQ(decoded, "opened note id=42 ok=1");
+
+    std::string json;
+    log_args::decodeJsonFields(args, json);
+    EXPECT_EQ(json, R"(,"id":42,"ok":true)");
+}
+
+TEST(LogArgs, JsonStringsAreEscaped) {
+    std::string json;
+    log_args::appendJsonString("a\"b\\c\nd\x01", json);
+    EXPECT_EQ(json, R"("a\"b\\c\nd\u0001")");
+}
+
+TEST(LoggerJson, FileRecordsCarryFields) {
+    auto path = std::filesystem::temp_directory_path() / ("logger_json_" + std::to_string(::getpid()) + ".log");
+    Logger& logger = Logger::getInstance();
+    logger.enableFileLogging(path.string(), {}, LogFormat::JSON_LINES);
+    LOG_ERROR() << "saved \"notes\"" << logField("count", 3) << logField("path", std::string("a.json"));
+    logger.waitForQueueToEmpty();
+    logger.enableFileLogging("");
+
+    std::ifstream in(path);
+    std::string record, found;
+    while (std::getline(in, record)) {
+        if (record.find("saved") != std::string::npos) found = record;
+    }
+    std::filesystem::remove(path);
+    ASSERT_FALSE(found.empty());
+    EXPECT_EQ(found.rfind("{\"ts\":\"", 0), 0u);
+    EXPECT_NE(found.find(R"("level":"ERROR")"), std::string::npos);
+    EXPECT_NE(found.find(R"("msg":"saved \"notes\"","count":3,"path":"a.json"})"), std::string::npos);
+    EXPECT_EQ(found.find('\x1b'), std::string::npos);   // no color codes
+}
+
+TEST(LoggerJson, EagerFormattingKeepsFields) {
+    auto path = std::filesystem::temp_directory_path() / ("logger_json_eager_" + std::to_string(::getpid()) + ".log");
+    Logger& logger = Logger::getInstance();
+    logger.setDeferredFormatting(false);
+    logger.enableFileLogging(path.string(), {}, LogFormat::JSON_LINES);
+    LOG_ERROR() << "eager" << logField("ratio", 0.1 + 0.2) << logField("big", 123456789.25);
+    logger.waitForQueueToEmpty();
+    logger.enableFileLogging("");
+    logger.setDeferredFormatting(true);
+
+    std::ifstream in(path);
+    std::string record, found;
+    while (std::getline(in, record)) {
+        if (record.find("eager") != std::string::npos) found = record;
+    }
+    std::filesystem::remove(path);
+    // doubles read back to the same value
+    EXPECT_NE(found.find(R"("msg":"eager","ratio":0.30000000000000004,"big":123456789.25})"), std::string::npos) << found;
+}
+
+TEST(LoggerFlightRecorder, RecordsLevelsBelowTheLogLevel) {
+    auto path = std::filesystem::temp_directory_path() / ("logger_flight_" + std::to_string(::getpid()));
+    Logger& logger = Logger::getInstance();
+    logger.setLogLevel(LogLevel::WARNING);
+    ASSERT_TRUE(logger.enableFlightRecorder(path.string(), 64));
+    LOG_INFO() << "quiet " << 7;
+    logger.enableFlightRecorder("");
+
+    std::string error;
+    auto records = FlightRecorder::load(path.string(), 64, error);
+    std::filesystem::remove(path);
+    ASSERT_FALSE(records.empty());
+    EXPECT_EQ(records.back().level, static_cast<uint8_t>(LogLevel::INFO));
+    std::string text;
+    log_args::decode(records.back().args, text);
+    EXPECT_EQ(text, "quiet 7");
+}
+
+TEST(LoggerCrashDeathTest, QueuedMessagesAreFlushedOnCrash) {
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    // no pid in the name, the "threadsafe" style runs the statement in a new process
+    auto path = std::filesystem::temp_directory_path() / "logger_crash_death_test.log";
+    std::filesystem::remove(path);
+    EXPECT_DEATH({
+        Logger& logger = Logger::getInstance();
+        logger.enableConsoleLogging(false);
+        logger.enableFileLogging(path.string(), {.flushBytes = 1 << 20, .flushInterval = std::chrono::hours(1)});
+        logger.installCrashHandlers();
+        LOG_WARNING() << "last words";
+        std::raise(SIGABRT);
+    }, "");
+    std::ifstream in(path);
+    std::stringstream content;
+    content << in.rdbuf();
+    std::filesystem::remove(path);
+    EXPECT_NE(content.str().find("last words"), std::string::npos);
+}
+
+TEST(LoggerCrashDeathTest, BatchInFlightIsFlushedOnCrash) {
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    auto path = std::filesystem::temp_directory_path() / "logger_crash_batch_death_test.log";
+    std::filesystem::remove(path);
+    // the crash lands while the logger thread has batches popped and not yet written
+    EXPECT_DEATH({
+        Logger& logger = Logger::getInstance();
+        logger.enableConsoleLogging(false);
+        logger.enableFileLogging(path.string(), {.flushBytes = 1 << 20, .flushInterval = std::chrono::hours(1)});
+        logger.installCrashHandlers();
+        for (int i = 0; i < 3000; ++i) LOG_WARNING() << "line " << i;
+        std::raise(SIGABRT);
+    }, "");
+    std::ifstream in(path);
+    size_t lines = 0;
+    for (std::string line; std::getline(in, line);) lines += line.find("line ") != std::string::npos;
+    std::filesystem::remove(path);
+    EXPECT_EQ(lines, 3000u);
+}
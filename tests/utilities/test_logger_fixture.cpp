@@ -16,13 +16,17 @@ static void TestObserver(LogMessage const& m) {
 }
 
 struct LoggerTapFixture : ::testing::Test {
+    LogLevel savedLevel = LogLevel::WARNING;
+
     void SetUp() override {
+        savedLevel = Logger::getInstance().getLogLevel();
 #ifdef LOGGER_TEST_HOOKS
         g_seen.clear();
         setLogTestObserver(&TestObserver);
 #endif
     }
     void TearDown() override {
+        Logger::getInstance().setLogLevel(savedLevel);
 #ifdef LOGGER_TEST_HOOKS
         setLogTestObserver(nullptr);
 #endif
@@ -48,3 +52,32 @@ TEST_F(LoggerTapFixture, DebugBehaviorDependsOnNDEBUG) {
     EXPECT_EQ(g_seen.back().level, LogLevel::DEBUG);
 #endif
 }
+
+TEST_F(LoggerTapFixture, DeferredMessagesAreDecodedForObservers) {
+    LOG_ERROR() << "count " << 3 << " ratio " << 0.5 << " hex " << std::hex << 255;
+    std::unique_lock<std::mutex> lk(g_m);
+    g_cv.wait_for(lk, std::chrono::milliseconds(100), []{ return !g_seen.empty(); });
+    ASSERT_FALSE(g_seen.empty());
+    // manipulators switch the rest of the message to ostream formatting
+    EXPECT_EQ(g_seen.back().message, "count 3 ratio 0.5 hex ff");
+}
+
+TEST_F(LoggerTapFixture, DisabledLevelSkipsOperands) {
+    Logger::getInstance().setLogLevel(LogLevel::WARNING);
+    int evaluated = 0;
+    auto operand = [&] { return ++evaluated; };
+    LOG_INFO() << operand();
+    EXPECT_EQ(evaluated, 0);
+    LOG_ERROR() << operand();
+    EXPECT_EQ(evaluated, 1);
+}
+
+TEST_F(LoggerTapFixture, EveryNAndRateLimited) {
+    for (int i = 0; i < 10; ++i) LOG_EVERY_N(ERROR, 4) << "every " << i;
+    for (int i = 0; i < 10; ++i) LOG_RATE_LIMITED(ERROR, std::chrono::hours(1)) << "rate " << i;
+    Logger::getInstance().waitForQueueToEmpty();
+    std::lock_guard<std::mutex> lk(g_m);
+    std::vector<std::string> messages;
+    for (const auto& m : g_seen) messages.push_back(m.message);
+    EXPECT_EQ(messages, (std::vector<std::string>{"every 0", "every 4", "every 8", "rate 0"}));
+}
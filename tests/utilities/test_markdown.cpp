@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "markdown.h"
+
+using namespace markdown;
+
+TEST(Markdown, BlockTypes) {
+    Document doc = parse("# Title\n\nsome text\nmore text\n\n- one\n- two\n\n---\n\n> quoted\n");
+    ASSERT_EQ(doc.blocks.size(), 6u);
+    EXPECT_EQ(doc.blocks[0].type, BlockType::Heading);
+    EXPECT_EQ(doc.blocks[0].level, 1);
+    EXPECT_EQ(doc.blocks[1].type, BlockType::Paragraph);
+    EXPECT_EQ(doc.blocks[1].spans[0].text, "some text more text");
+    EXPECT_EQ(doc.blocks[2].type, BlockType::ListItem);
+    EXPECT_EQ(doc.blocks[3].spans[0].text, "two");
+    EXPECT_EQ(doc.blocks[4].type, BlockType::Rule);
+    EXPECT_EQ(doc.blocks[5].type, BlockType::Quote);
+    EXPECT_EQ(doc.blocks[5].spans[0].text, "quoted");
+}
+
+TEST(Markdown, OrderedList) {
+    Document doc = parse("1. first\n2. second");
+    ASSERT_EQ(doc.blocks.size(), 2u);
+    EXPECT_EQ(doc.blocks[0].number, 1u);
+    EXPECT_EQ(doc.blocks[1].number, 2u);
+    EXPECT_EQ(doc.blocks[1].spans[0].text, "second");
+}
+
+TEST(Markdown, CodeBlockKeepsBlankLines) {
+    Document doc = parse("```\nint a;\n\nint b;\n```\nafter");
+    ASSERT_EQ(doc.blocks.size(), 2u);
+    EXPECT_EQ(doc.blocks[0].type, BlockType::CodeBlock);
+    EXPECT_EQ(doc.blocks[0].code, "int a;\n\nint b;");
+    EXPECT_EQ(doc.blocks[1].spans[0].text, "after");
+}
+
+TEST(Markdown, InlineSpans) {
+    Document doc = parse("see [[Other Note|that]] and `code`, **bold** or *em*");
+    ASSERT_EQ(doc.blocks.size(), 1u);
+    const auto& spans = doc.blocks[0].spans;
+    ASSERT_EQ(spans.size(), 8u);
+    EXPECT_EQ(spans[1].type, SpanType::Link);
+    EXPECT_EQ(spans[1].text, "Other Note");
+    EXPECT_EQ(spans[1].label, "that");
+    EXPECT_EQ(spans[1].shown(), "that");
+    EXPECT_EQ(spans[3].type, SpanType::Code);
+    EXPECT_EQ(spans[5].type, SpanType::Strong);
+    EXPECT_EQ(spans[5].text, "bold");
+    EXPECT_EQ(spans[7].type, SpanType::Emphasis);
+}
+
+TEST(Markdown, UnclosedMarkersStayText) {
+    Document doc = parse("a * b and [[open");
+    ASSERT_EQ(doc.blocks[0].spans.size(), 1u);
+    EXPECT_EQ(doc.blocks[0].spans[0].text, "a * b and [[open");
+}
+
+TEST(Markdown, LinkWithoutLabelShowsTheTitle) {
+    Document doc = parse("[[Other Note]]");
+    ASSERT_EQ(doc.blocks[0].spans.size(), 1u);
+    EXPECT_TRUE(doc.blocks[0].spans[0].label.empty());
+    EXPECT_EQ(doc.blocks[0].spans[0].shown(), "Other Note");
+}
+
+TEST(Markdown, EmphasisNeedsNonSpaceInside) {
+    Document doc = parse("2 * 3 * 4 and a ** b **");
+    ASSERT_EQ(doc.blocks[0].spans.size(), 1u);
+    EXPECT_EQ(doc.blocks[0].spans[0].text, "2 * 3 * 4 and a ** b **");
+
+    doc = parse("*a * b* c");
+    ASSERT_EQ(doc.blocks[0].spans.size(), 2u);
+    EXPECT_EQ(doc.blocks[0].spans[0].type, SpanType::Emphasis);
+    EXPECT_EQ(doc.blocks[0].spans[0].text, "a * b");
+}
+
+TEST(Markdown, IncrementalReuseOfUnchangedBlocks) {
+    std::string source = "# Head\n\nfirst paragraph\n\nsecond paragraph";
+    Document doc = parse(source);
+    EXPECT_EQ(doc.reusedBlocks, 0u);
+
+    doc = parse("# Head\n\nfirst paragraph, edited\n\nsecond paragraph", std::move(doc));
+    ASSERT_EQ(doc.blocks.size(), 3u);
+    EXPECT_EQ(doc.reusedBlocks, 2u);
+    EXPECT_EQ(doc.blocks[1].spans[0].text, "first paragraph, edited");
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "mpsc_queue.h"
+
+TEST(MpscQueue, FifoSingleProducer) {
+    MpscQueue<int> q(8);
+    for (int i = 0; i < 5; ++i) EXPECT_TRUE(q.try_push(i));
+    int v;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(q.try_pop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(q.try_pop(v));
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(MpscQueue, RejectsWhenFull) {
+    MpscQueue<int> q(4);
+    EXPECT_EQ(q.capacity(), 4u);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(q.try_push(i));
+    EXPECT_FALSE(q.try_push(4));
+    int v;
+    ASSERT_TRUE(q.try_pop(v));
+    EXPECT_TRUE(q.try_push(4));
+}
+
+TEST(MpscQueue, FrontAndPop) {
+    MpscQueue<int> q(4);
+    EXPECT_EQ(q.front(), nullptr);
+    q.try_push(7);
+    ASSERT_NE(q.front(), nullptr);
+    EXPECT_EQ(*q.front(), 7);
+    q.pop();
+    EXPECT_EQ(q.front(), nullptr);
+}
+
+TEST(MpscQueue, ManyProducersKeepPerProducerOrder) {
+    constexpr int producers = 4;
+    constexpr int per_producer = 20000;
+    MpscQueue<std::pair<int, int>> q(256);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&q, p] {
+            for (int i = 0; i < per_producer; ++i) {
+                while (!q.try_push({p, i})) std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<int> next(producers, 0);
+    int received = 0;
+    std::pair<int, int> item;
+    while (received < producers * per_producer) {
+        if (!q.try_pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        EXPECT_EQ(item.second, next[item.first]);
+        next[item.first] = item.second + 1;
+        ++received;
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_TRUE(q.empty());
+}
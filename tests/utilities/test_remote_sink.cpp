@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+#include "remote_sink.h"
+
+using namespace std::chrono_literals;
+
+// A stand-in log server: accepts one client, splits its frames into lines and
+// acknowledges every frame with one byte.
+class FakeLogServer {
+public:
+    explicit FakeLogServer(int port = 0) {
+        listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        EXPECT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        socklen_t length = sizeof(addr);
+        ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &length);
+        this->port = ntohs(addr.sin_port);
+        ::listen(listener, 1);
+        worker = std::thread([this] { serve(); });
+    }
+
+    ~FakeLogServer() {
+        ::shutdown(listener, SHUT_RDWR);
+        ::close(listener);
+        if (client >= 0) ::shutdown(client, SHUT_RDWR);
+        worker.join();
+        if (client >= 0) ::close(client);
+    }
+
+    int port;
+    std::atomic<size_t> lines{0};
+    std::string last;
+
+private:
+    int listener{-1};
+    int client{-1};
+    std::thread worker;
+
+    bool readAll(char* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::recv(client, data, size, 0);
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    void serve() {
+        client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) return;
+        unsigned char header[4];
+        while (readAll(reinterpret_cast<char*>(header), 4)) {
+            uint32_t length = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) |
+                              (uint32_t(header[2]) << 8) | uint32_t(header[3]);
+            std::string payload(length, '\0');
+            if (!readAll(payload.data(), length)) return;
+            size_t start = 0, end;
+            while ((end = payload.find('\n', start)) != std::string::npos) {
+                last = payload.substr(start, end - start);
+                lines.fetch_add(1);
+                start = end + 1;
+            }
+            ::send(client, "A", 1, MSG_NOSIGNAL);
+        }
+    }
+};
+
+static bool pollUntil(RemoteSink& sink, const std::function<bool()>& done, std::chrono::milliseconds limit = 2000ms) {
+    auto deadline = std::chrono::steady_clock::now() + limit;
+    while (std::chrono::steady_clock::now() < deadline) {
+        sink.poll();
+        if (done()) return true;
+        std::this_thread::sleep_for(1ms);
+    }
+    return false;
+}
+
+TEST(RemoteSink, RejectsInvalidAddress) {
+    RemoteSink sink;
+    EXPECT_FALSE(sink.open("not an address", 1234));
+    EXPECT_FALSE(sink.isOpen());
+}
+
+TEST(RemoteSink, BatchesLinesIntoFrames) {
+    FakeLogServer server;
+    RemoteSink sink;
+    ASSERT_TRUE(sink.open("127.0.0.1", server.port, {.batchDelay = 5ms}));
+    for (int i = 0; i < 1000; ++i) sink.write("line " + std::to_string(i));
+    EXPECT_TRUE(pollUntil(sink, [&] { return server.lines.load() == 1000; }));
+    EXPECT_EQ(server.last, "line 999");
+    EXPECT_LT(sink.sentFrames(), 1000u);    // batched, not one frame per line
+    EXPECT_TRUE(pollUntil(sink, [&] { return sink.receivedBytes() == sink.sentFrames(); }));
+}
+
+TEST(RemoteSink, ReconnectsAndKeepsBufferedLines) {
+    int port;
+    {
+        FakeLogServer probe;    // find a free port, then leave it closed
+        port = probe.port;
+        RemoteSink poke;
+        poke.open("127.0.0.1", port);
+        pollUntil(poke, [&] { return poke.connected(); });
+    }
+    RemoteSink sink;
+    ASSERT_TRUE(sink.open("127.0.0.1", port, {.batchDelay = 1ms, .minBackoff = 5ms, .maxBackoff = 20ms}));
+    sink.write("while away");
+    pollUntil(sink, [] { return false; }, 30ms);     // refused, must not block or exit
+    EXPECT_FALSE(sink.connected());
+
+    FakeLogServer server(port);
+    EXPECT_TRUE(pollUntil(sink, [&] { return server.lines.load() == 1; }));
+    EXPECT_EQ(server.last, "while away");
+}
+
+TEST(RemoteSink, BoundedBufferDropsNewestLines) {
+    RemoteSink sink;
+    ASSERT_TRUE(sink.open("127.0.0.1", 9, {.maxBuffered = 100}));  // nobody listens on 'discard'
+    for (int i = 0; i < 20; ++i) sink.write("0123456789");
+    EXPECT_GT(sink.droppedLines(), 0u);
+    EXPECT_LE(sink.droppedLines(), 20u);
+}
+
+TEST(RemoteSink, CutOffFrameCountsEveryLine) {
+    // a server that accepts, never reads, then resets the connection
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    int small = 4096;
+    ::setsockopt(listener, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    socklen_t length = sizeof(addr);
+    ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &length);
+    ::listen(listener, 1);
+
+    // one frame, far larger than the socket buffers
+    const size_t lines = 200000;
+    RemoteSink sink;
+    ASSERT_TRUE(sink.open("127.0.0.1", ntohs(addr.sin_port),
+                          {.batchBytes = 64 << 20, .batchDelay = 1ms, .maxBuffered = 64 << 20}));
+    for (size_t i = 0; i < lines; ++i) sink.write("a line of the one frame that never gets through");
+    ASSERT_TRUE(pollUntil(sink, [&] { return sink.connected(); }));
+    int client = ::accept(listener, nullptr, nullptr);
+    ASSERT_GE(client, 0);
+    pollUntil(sink, [] { return false; }, 50ms);    // fills the socket buffers
+    EXPECT_EQ(sink.sentFrames(), 0u);
+
+    linger reset{1, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    ::close(client);
+    ::close(listener);
+    EXPECT_TRUE(pollUntil(sink, [&] { return !sink.connected(); }));
+    EXPECT_EQ(sink.droppedLines(), lines);
+}
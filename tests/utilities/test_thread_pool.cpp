@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+#include "thread_pool.h"
+
+TEST(ThreadPool, CoversEveryIndexOnce) {
+    ThreadPool pool(3);
+    std::vector<int> hits(10000, 0);
+    pool.parallel_for(hits.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) ++hits[i];
+    }, 64);
+    for (int h : hits) EXPECT_EQ(h, 1);
+}
+
+TEST(ThreadPool, NoWorkersRunsOnCaller) {
+    ThreadPool pool(0);
+    EXPECT_EQ(pool.size(), 1u);
+    size_t sum = 0;
+    pool.parallel_for(100, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) sum += i;
+    });
+    EXPECT_EQ(sum, 4950u);
+}
+
+TEST(ThreadPool, RepeatedJobsDontOverlap) {
+    ThreadPool pool(4);
+    std::atomic<size_t> total{0};
+    for (int round = 0; round < 200; ++round) {
+        std::vector<size_t> values(1000, round);
+        pool.parallel_for(values.size(), [&](size_t begin, size_t end) {
+            total += std::accumulate(values.begin() + begin, values.begin() + end, size_t{0});
+        }, 16);
+    }
+    // sum over rounds of round * 1000
+    EXPECT_EQ(total.load(), 1000u * (199u * 200u / 2));
+}
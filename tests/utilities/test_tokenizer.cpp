@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tokenizer.h"
+
+using namespace tokenizer;
+
+namespace {
+
+// words with doubled quotes point into the tokenizer, it lives until the next call
+std::vector<std::string_view> tokens(std::string_view text) {
+    static Tokenizer tokenizer;
+    std::vector<std::string_view> out;
+    tokenizer.tokenize(text, out);
+    return out;
+}
+
+using Words = std::vector<std::string_view>;
+
+} // namespace
+
+TEST(Tokenizer, SplitsOnWhitespaceAndCommas) {
+    EXPECT_EQ(tokens("beta, alpha\tgamma,,delta\n epsilon"), (Words{"beta", "alpha", "gamma", "delta", "epsilon"}));
+    EXPECT_TRUE(tokens("").empty());
+    EXPECT_TRUE(tokens(" ,\t\r\n ,").empty());
+}
+
+TEST(Tokenizer, TokensPointIntoTheText) {
+    std::string text = "one two";
+    std::vector<std::string_view> out = tokens(text);
+    ASSERT_EQ(out.size(), 2u);
+    EXPECT_EQ(out[0].data(), text.data());
+    EXPECT_EQ(out[1].data(), text.data() + 4);
+}
+
+TEST(Tokenizer, QuotedWordsHoldDelimiters) {
+    EXPECT_EQ(tokens(R"(rust "data structures" "a, b")"), (Words{"rust", "data structures", "a, b"}));
+    // an unterminated quote runs to the end, quotes inside a word are kept
+    EXPECT_EQ(tokens(R"(x"y "open ended)"), (Words{"x\"y", "open ended"}));
+    // a closing quote ends the word even without a delimiter after it
+    EXPECT_EQ(tokens(R"("a b"c)"), (Words{"a b", "c"}));
+    EXPECT_TRUE(tokens(R"("" "")").empty());
+}
+
+TEST(Tokenizer, QuotedDelimitersAreTokens) {
+    EXPECT_EQ(tokens(R"(",")"), (Words{","}));
+    EXPECT_EQ(tokens(R"(a " " ",")"), (Words{"a", " ", ","}));
+    EXPECT_TRUE(Tokenizer::needsQuotes(","));
+}
+
+TEST(Tokenizer, ManyQuotedBlankTokens) {
+    // more tokens than the words outside quotes, past the smallest hash set
+    std::string text = "a";
+    for (size_t i = 1; i <= 40; ++i) text += " \"" + std::string(i, ' ') + "\"";
+    std::vector<std::string_view> out = tokens(text);
+    ASSERT_EQ(out.size(), 41u);
+    EXPECT_EQ(out[0], "a");
+    EXPECT_EQ(out[40], std::string(40, ' '));
+    EXPECT_GE(Tokenizer::maxTokens(text), out.size());
+}
+
+TEST(Tokenizer, DropsDuplicatesAndKeepsOrder) {
+    EXPECT_EQ(tokens("c a c b a \"c\""), (Words{"c", "a", "b"}));
+}
+
+TEST(Tokenizer, Utf8BytesAreNotDelimiters) {
+    EXPECT_EQ(tokens("caf\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac"), (Words{"caf\xc3\xa9", "\xe6\x97\xa5\xe6\x9c\xac"}));
+}
+
+TEST(Tokenizer, WordsAcrossBlocks) {
+    // words of every length around the 64 byte blocks, many more than 'inlineTokens'
+    std::string text;
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < 3 * Tokenizer::inlineTokens; ++i) {
+        std::string word = std::to_string(i) + std::string(i % 70, 'w');
+        expected.push_back(word);
+        text += word;
+        text += i % 3 ? " " : ", ";
+        if (i % 5 == 0) text += word + " ";     // a duplicate
+    }
+    Tokenizer tokenizer;
+    std::vector<std::string> out;
+    EXPECT_EQ(tokenizer.tokenize(text, out), expected.size());
+    EXPECT_EQ(out, expected);
+    // the same tokenizer again, on a short line
+    EXPECT_EQ(tokenizer.tokenize("x y x", out), 2u);
+    EXPECT_EQ(out, (std::vector<std::string>{"x", "y"}));
+}
+
+TEST(Tokenizer, MaxTokensIsAnUpperBound) {
+    for (std::string_view text : {"", "a", " a ", "a,b c", R"("a b" c)", R"(a"b"c)", R"("" x)", R"(" " ",")"}) {
+        EXPECT_GE(Tokenizer::maxTokens(text), tokens(text).size()) << text;
+    }
+    EXPECT_EQ(Tokenizer::maxTokens("a, b c"), 3u);
+}
+
+TEST(Tokenizer, NeedsQuotesRoundTrips) {
+    EXPECT_FALSE(Tokenizer::needsQuotes("plain"));
+    EXPECT_FALSE(Tokenizer::needsQuotes("a\"b"));
+    for (std::string_view word : {"two words", "a,b", "\"quoted", "tab\there"}) {
+        EXPECT_TRUE(Tokenizer::needsQuotes(word)) << word;
+    }
+    EXPECT_EQ(tokens("plain \"two words\""), (Words{"plain", "two words"}));
+}
+
+TEST(Tokenizer, DoubledQuotesAreOneQuote) {
+    EXPECT_EQ(tokens(R"("say ""hi"" now" """quoted" "end""")"), (Words{"say \"hi\" now", "\"quoted", "end\""}));
+    EXPECT_EQ(tokens(R"("""" """""")"), (Words{"\"", "\"\""}));
+    // unterminated after a doubled quote, it still runs to the end
+    EXPECT_EQ(tokens(R"("a""b c)"), (Words{"a\"b c"}));
+    // a single quote closes the word
+    EXPECT_EQ(tokens(R"("a""b"c)"), (Words{"a\"b", "c"}));
+
+    std::string line;
+    Tokenizer::appendQuoted(line, "say \"hi\" now");
+    EXPECT_EQ(line, R"("say ""hi"" now")");
+}
+
+TEST(Tokenizer, UnescapedTokensStayValid) {
+    // the copies of many escaped words in one long line don't move each other
+    std::string text;
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < 200; ++i) {
+        expected.push_back(std::to_string(i) + "\"" + std::string(i % 70, 'q'));
+        Tokenizer::appendQuoted(text, expected.back());
+        text += ' ';
+    }
+    Tokenizer tokenizer;
+    std::vector<std::string_view> out;
+    ASSERT_EQ(tokenizer.tokenize(text, out), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) EXPECT_EQ(out[i], expected[i]);
+}
+
+TEST(Tokenizer, SimdMasksMatchScalar) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> byte(0, 255);
+    char block[64];
+    for (int round = 0; round < 1000; ++round) {
+        for (char& c : block) c = static_cast<char>(byte(rng));
+        // more delimiters than random bytes give
+        block[round % 64] = round % 2 ? ',' : '"';
+        detail::BlockMasks scalar = detail::classifyScalar(block);
+        detail::BlockMasks dispatched = detail::classify(block);
+        EXPECT_EQ(dispatched.delimiters, scalar.delimiters);
+        EXPECT_EQ(dispatched.quotes, scalar.quotes);
+#ifdef TOKENIZER_X86
+        detail::BlockMasks sse2 = detail::classifySse2(block);
+        EXPECT_EQ(sse2.delimiters, scalar.delimiters);
+        EXPECT_EQ(sse2.quotes, scalar.quotes);
+#endif
+#ifdef TOKENIZER_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+            detail::BlockMasks avx2 = detail::classifyAvx2(block);
+            EXPECT_EQ(avx2.delimiters, scalar.delimiters);
+            EXPECT_EQ(avx2.quotes, scalar.quotes);
+        }
+#endif
+    }
+}
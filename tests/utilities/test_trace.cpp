@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <cstring>      // for std::strlen
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "trace.h"
+
+namespace fs = std::filesystem;
+
+class TraceTest : public ::testing::Test {
+protected:
+    Tracer& tracer = Tracer::instance();
+
+    void SetUp() override { tracer.clear(); }
+    void TearDown() override {
+        tracer.disable();
+        tracer.clear();
+    }
+
+    std::string json() const {
+        std::string out;
+        StringWriter writer(out);
+        tracer.write(writer);
+        return out;
+    }
+
+    static size_t count(const std::string& text, const std::string& what) {
+        size_t n = 0;
+        for (size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1)) ++n;
+        return n;
+    }
+};
+
+TEST_F(TraceTest, DisabledRecordsNothing) {
+    {
+        TRACE_SCOPE("off");
+    }
+    EXPECT_EQ(tracer.size(), 0u);
+    EXPECT_EQ(json().find("\"off\""), std::string::npos);
+}
+
+TEST_F(TraceTest, ScopeRecordsOneCompleteEvent) {
+    tracer.enable();
+    {
+        TRACE_SCOPE("load_json_file");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_EQ(tracer.size(), 1u);
+    std::string out = json();
+    EXPECT_EQ(out.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(out.find("{\"name\":\"load_json_file\",\"ph\":\"X\",\"ts\":"), std::string::npos);
+    // at least the 2 ms slept, in microseconds
+    size_t dur = out.find("\"dur\":");
+    ASSERT_NE(dur, std::string::npos);
+    EXPECT_GE(std::stod(out.substr(dur + 6)), 2000.0);
+    EXPECT_EQ(out.substr(out.size() - 4), "\n]}\n");
+}
+
+TEST_F(TraceTest, ScopeStartedWhileDisabledIsNotRecorded) {
+    {
+        TRACE_SCOPE("straddles");
+        tracer.enable();
+    }
+    EXPECT_EQ(tracer.size(), 0u);
+}
+
+TEST_F(TraceTest, NestedScopesNest) {
+    tracer.enable();
+    {
+        TRACE_SCOPE("outer");
+        {
+            TRACE_SCOPE("inner");
+        }
+    }
+    std::string out = json();
+    // the inner scope ends first
+    size_t inner = out.find("\"inner\"");
+    size_t outer = out.find("\"outer\"");
+    ASSERT_NE(inner, std::string::npos);
+    ASSERT_NE(outer, std::string::npos);
+    EXPECT_LT(inner, outer);
+    auto field = [&](size_t from, const char* name) {
+        return std::stod(out.substr(out.find(name, from) + std::strlen(name)));
+    };
+    double innerTs = field(inner, "\"ts\":");
+    double outerTs = field(outer, "\"ts\":");
+    EXPECT_LE(outerTs, innerTs);
+    EXPECT_GE(outerTs + field(outer, "\"dur\":"), innerTs + field(inner, "\"dur\":"));
+}
+
+TEST_F(TraceTest, ThreadsGetTheirOwnIdsAndNames) {
+    tracer.enable();
+    std::thread worker([this] {
+        tracer.setThreadName("worker \"1\"");
+        TRACE_SCOPE("work");
+    });
+    worker.join();
+    {
+        TRACE_SCOPE("main");
+    }
+    // the worker's spans outlive the worker
+    EXPECT_EQ(tracer.size(), 2u);
+    std::string out = json();
+    EXPECT_NE(out.find("\"ph\":\"M\""), std::string::npos);
+    EXPECT_NE(out.find("\"args\":{\"name\":\"worker \\\"1\\\"\"}"), std::string::npos);
+    size_t work = out.find("\"work\"");
+    size_t main = out.find("\"main\"");
+    ASSERT_NE(work, std::string::npos);
+    ASSERT_NE(main, std::string::npos);
+    EXPECT_NE(out.substr(out.find("\"tid\":", work), 8), out.substr(out.find("\"tid\":", main), 8));
+}
+
+TEST_F(TraceTest, FullBufferDropsAndCounts) {
+    tracer.enable(4);
+    // a new thread, its buffer is sized on its first span
+    std::thread worker([] {
+        for (int i = 0; i < 10; ++i) {
+            TRACE_SCOPE("tick");
+        }
+    });
+    worker.join();
+    EXPECT_EQ(tracer.dropped(), 6u);
+    EXPECT_EQ(count(json(), "\"tick\""), 4u);
+}
+
+TEST_F(TraceTest, WriteFileIsReadBack) {
+    fs::path path = fs::temp_directory_path() / ("trace_test_" + std::to_string(::getpid()) + ".json");
+    tracer.enable();
+    {
+        TRACE_SCOPE("save_json_file");
+    }
+    ASSERT_TRUE(tracer.writeFile(path.string()));
+    std::stringstream contents;
+    contents << std::ifstream(path).rdbuf();
+    fs::remove(path);
+    EXPECT_EQ(contents.str(), json());
+    EXPECT_FALSE(tracer.writeFile((path / "no such dir" / "x.json").string()));
+}